@@ -0,0 +1,74 @@
+/**
+ * Compares matmul over lg<double> to the naive triple loop
+ *     C[i][j] = A[i][0] B[0][j] + ... + A[i][p-1] B[p-1][j]
+ * with a log_exp_sum per value of C, and reports GFLOP-equivalents,
+ * i.e., 2*n*m*p / t, as for an ordinary matrix product.
+ *
+ *     g++ -std=c++20 -O3 -march=native -pthread -Iinclude bench/lg_gemm.cpp
+ *     ./a.out [n] [threads]
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_gemm.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+double seconds(F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename M>
+void run(char const * name, std::size_t n, thread_pool & pool)
+{
+    using L = lg<double,M>;
+    std::mt19937_64 g(1);
+    std::normal_distribution<double> d(-5.0, 3.0);
+    std::vector<L> a(n * n), b(n * n), c(n * n), r(n * n);
+    for (auto & x : a)
+        x = L::from_log(d(g));
+    for (auto & x : b)
+        x = L::from_log(d(g));
+
+    auto const naive = seconds([&]
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                log_exp_sum<double,M> acc;
+                for (std::size_t k = 0; k < n; ++k)
+                    acc += a[i * n + k] * b[k * n + j];
+                r[i * n + j] = acc.value();
+            }
+    });
+
+    auto const blocked = seconds([&]
+    {
+        matmul(std::span<L const>(a), std::span<L const>(b), std::span<L>(c), n, n, n, pool);
+    });
+
+    double err = 0;
+    for (std::size_t i = 0; i < n * n; ++i)
+        err = std::max(err, std::abs(c[i].k - r[i].k));
+
+    auto const flops = 2.0 * n * n * n * 1e-9;
+    std::cout << name << " n = " << n << ", " << pool.size() << " threads\n"
+              << "    naive:  " << naive << " s, " << flops / naive << " GFLOP/s\n"
+              << "    matmul: " << blocked << " s, " << flops / blocked << " GFLOP/s\n"
+              << "    speedup " << naive / blocked << ", max |error| in k " << err << "\n";
+}
+
+int main(int argc, char ** argv)
+{
+    std::size_t const n = argc > 1 ? std::atoi(argv[1]) : 512;
+    thread_pool pool(argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency());
+    run<std_math>("lg<double>", n, pool);
+    run<fast_math>("lg<double,fast_math>", n, pool);
+}
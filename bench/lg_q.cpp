@@ -0,0 +1,64 @@
+/**
+ * Compares quantizing n values of type lg<double> to 16-bit codes, and
+ * dequantizing them to lg<float>, one at a time with the constructor
+ * and conversion of lg_q, with the batch forms quantize and dequantize
+ * in lg_q.hpp.
+ *
+ *     g++ -std=c++20 -O2 -march=native -Iinclude bench/lg_q.cpp
+ */
+
+#include "homomorphic_computational_extensions/lg_q.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 10;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::milli> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps << " ms (" << r << ")\n";
+}
+
+int main()
+{
+    using Q = lg_q<std::uint16_t,1024>;
+    std::size_t const n = 10000000;
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(-70.0, 1.0);
+    std::vector<lg<double>> xs(n);
+    for (auto & x : xs)
+        x = lg<double>::from_log(u(g));
+    std::vector<Q> qs(n);
+    std::vector<lg<float>> ys(n);
+
+    bench("lg_q(lg<double>)   ", [&]
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            qs[i] = Q(xs[i]);
+        return double(qs[n / 2].q);
+    });
+    bench("quantize           ", [&]
+    {
+        quantize(xs, qs);
+        return double(qs[n / 2].q);
+    });
+    bench("lg<float>(lg_q)    ", [&]
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            ys[i] = lg<float>(qs[i]);
+        return double(ys[n / 2].k);
+    });
+    bench("dequantize         ", [&]
+    {
+        dequantize(qs, ys);
+        return double(ys[n / 2].k);
+    });
+}
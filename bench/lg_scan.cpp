@@ -0,0 +1,61 @@
+/**
+ * Compares the running product and the running sum of n values of type
+ * lg<double>, as a fold over operator* or log_exp_sum, with the scans in
+ * lg_scan.hpp on one thread and on a thread_pool.
+ *
+ *     g++ -std=c++20 -O2 -march=native -pthread -Iinclude bench/lg_scan.cpp
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_scan.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 5;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::milli> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps << " ms (last " << r << ")\n";
+}
+
+int main()
+{
+    using L = lg<double, fast_math>;
+    std::size_t const n = 100000000;
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<L> xs(n), ys(n);
+    for (auto & x : xs)
+        x = L(u(g));
+    thread_pool pool;
+
+    bench("product fold          ", [&]
+    {
+        L p;
+        for (std::size_t i = 0; i < n; ++i)
+            ys[i] = p = p * xs[i];
+        return ys[n - 1].k;
+    });
+    bench("inclusive_product     ", [&] { inclusive_product(xs, ys); return ys[n - 1].k; });
+    bench("  compensated         ", [&] { inclusive_product(xs, ys, true); return ys[n - 1].k; });
+    bench("  thread_pool         ", [&] { inclusive_product(xs, ys, pool); return ys[n - 1].k; });
+    bench("  thread_pool, comp.  ", [&] { inclusive_product(xs, ys, pool, true); return ys[n - 1].k; });
+
+    bench("log_exp_sum fold      ", [&]
+    {
+        log_exp_sum<double, fast_math> s;
+        for (std::size_t i = 0; i < n; ++i)
+            ys[i] = (s += xs[i]).value();
+        return ys[n - 1].k;
+    });
+    bench("inclusive_sum         ", [&] { inclusive_sum(xs, ys); return ys[n - 1].k; });
+    bench("  thread_pool         ", [&] { inclusive_sum(xs, ys, pool); return ys[n - 1].k; });
+}
@@ -0,0 +1,69 @@
+/**
+ * Compares the forward algorithm of an HMM whose transition matrix is
+ * 95% zero with a dense matrix (semiring.hpp) and with an
+ * lg_sparse_matrix, and building the sparse matrix on one thread and on
+ * a thread_pool.
+ *
+ *     g++ -std=c++20 -O2 -march=native -pthread -Iinclude bench/lg_sparse.cpp
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_sparse.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 5;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::milli> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps << " ms (" << r << ")\n";
+}
+
+int main()
+{
+    using L = lg<double, fast_math>;
+    std::size_t const m = 2000, n = 50;
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    auto const zero = L::from_log(-numeric_limits<double>::infinity());
+
+    std::vector<L> init(m, L(1.0 / m)), trans(m * m), emit(n * m), alpha(n * m);
+    std::vector<double> p(m * m);
+    for (std::size_t i = 0; i < m * m; ++i)
+    {
+        p[i] = u(g) < 0.05 ? u(g) : 0.0;
+        trans[i] = p[i] == 0 ? zero : L(p[i]);
+    }
+    for (auto & b : emit)
+        b = L(u(g));
+
+    thread_pool pool;
+    lg_sparse_matrix<double, fast_math> sparse(std::span<L const>(trans), m, m);
+
+    bench("dense forward      ", [&]
+    {
+        return forward<lg_sum<double, fast_math>>(std::span<L const>(init), std::span<L const>(trans),
+            std::span<L const>(emit), std::span<L>(alpha), m, n).k;
+    });
+    bench("sparse forward     ", [&]
+    {
+        return forward<lg_sum<double, fast_math>>(std::span<L const>(init), sparse,
+            std::span<L const>(emit), std::span<L>(alpha), n).k;
+    });
+    bench("build, one thread  ", [&]
+    {
+        return double(lg_sparse_matrix<double, fast_math>::from_values(std::span<double const>(p), m, m).nnz());
+    });
+    bench("build, thread_pool ", [&]
+    {
+        return double(lg_sparse_matrix<double, fast_math>::from_values(std::span<double const>(p), m, m, pool).nnz());
+    });
+}
@@ -0,0 +1,75 @@
+/**
+ * Compares adding n pairs of lg<double>, and summing n values, with exp
+ * and log per value, i.e., lg_expr.hpp's + and log_exp_sum, with the
+ * Gaussian-log table of lns.hpp, one at a time and a pack at a time.
+ *
+ *     g++ -std=c++20 -O2 -march=native -Iinclude bench/lns.cpp
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_expr.hpp"
+#include "homomorphic_computational_extensions/lns.hpp"
+#include "homomorphic_computational_extensions/log_exp_sum.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 10;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::milli> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps << " ms (" << r << ")\n";
+}
+
+int main()
+{
+    using L = lg<double, fast_math>;
+    std::size_t const n = 1000000;
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(-50.0, 0.0);
+    std::vector<L> xs(n), ys(n), zs(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        xs[i] = L::from_log(u(g));
+        ys[i] = L::from_log(u(g));
+    }
+
+    bench("eval(x + y)        ", [&]
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            zs[i] = eval(xs[i] + ys[i]);
+        return zs[n / 2].k;
+    });
+    bench("lns_add(x, y)      ", [&]
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            zs[i] = lns_add(xs[i], ys[i]);
+        return zs[n / 2].k;
+    });
+    bench("lns_add, batch     ", [&]
+    {
+        lns_add(xs, ys, zs);
+        return zs[n / 2].k;
+    });
+    bench("fold of eval(s + x)", [&]
+    {
+        auto s = L::from_log(-numeric_limits<double>::infinity());
+        for (auto const & x : xs)
+            s = eval(s + x);
+        return s.k;
+    });
+    bench("log_exp_sum        ", [&]
+    {
+        log_exp_sum<double, fast_math> s;
+        s += std::span<L const>(xs);
+        return s.value().k;
+    });
+    bench("lns_sum            ", [&] { return lns_sum(xs).k; });
+}
@@ -0,0 +1,94 @@
+/**
+ * Compares the throughput of log_gamma and log_factorial, scalar and
+ * batch, with std::lgamma over the same arguments.
+ *
+ *     g++ -std=c++20 -O2 -march=native -Iinclude bench/log_gamma.cpp
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/log_gamma.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, std::size_t n, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 10;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::nano> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps / n << " ns/value (checksum " << r << ")\n";
+}
+
+int main()
+{
+    std::size_t const n = 1000000;
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(-3.0, 20.0);
+    std::vector<double> xs(n);
+    std::vector<std::uint64_t> ns(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        xs[i] = std::exp2(u(g));
+        ns[i] = std::uint64_t(xs[i]);
+    }
+    std::vector<lg<double>> ys(n);
+    std::vector<lg<double, fast_math>> zs(n);
+
+    bench("std::lgamma             ", n, [&]
+    {
+        double s = 0;
+        for (auto x : xs)
+            s += std::lgamma(x);
+        return s;
+    });
+    bench("log_gamma               ", n, [&]
+    {
+        double s = 0;
+        for (auto x : xs)
+            s += log_gamma(x).k;
+        return s;
+    });
+    bench("log_gamma batch         ", n, [&]
+    {
+        log_gamma(std::span<double const>(xs), std::span<lg<double>>(ys));
+        return ys[n / 2].k;
+    });
+    bench("log_gamma batch fast    ", n, [&]
+    {
+        log_gamma(std::span<double const>(xs), std::span<lg<double, fast_math>>(zs));
+        return zs[n / 2].k;
+    });
+
+    bench("std::lgamma(n + 1)      ", n, [&]
+    {
+        double s = 0;
+        for (auto k : ns)
+            s += std::lgamma(double(k) + 1);
+        return s;
+    });
+    bench("log_factorial           ", n, [&]
+    {
+        double s = 0;
+        for (auto k : ns)
+            s += log_factorial(k).k;
+        return s;
+    });
+    bench("log_factorial batch     ", n, [&]
+    {
+        log_factorial(std::span<std::uint64_t const>(ns), std::span<lg<double>>(ys));
+        return ys[n / 2].k;
+    });
+    bench("log_factorial batch fast", n, [&]
+    {
+        log_factorial(std::span<std::uint64_t const>(ns), std::span<lg<double, fast_math>>(zs));
+        return zs[n / 2].k;
+    });
+}
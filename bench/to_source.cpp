@@ -0,0 +1,63 @@
+/**
+ * Compares converting n values of type lg<float> back to float one at a
+ * time, with operator T and the predicates of safe<lg<float>>, with the
+ * fused, classified bulk conversion to_source in safe_batch.hpp.
+ *
+ *     g++ -std=c++20 -O2 -march=native -Iinclude bench/to_source.cpp
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+#include "homomorphic_computational_extensions/safe_batch.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 10;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::milli> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps << " ms (invalid " << r << ")\n";
+}
+
+int main()
+{
+    using L = lg<float, fast_math>;
+    std::size_t const n = 10000000;
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<float> u(-100.0f, 100.0f);
+    std::vector<L> xs(n);
+    for (auto & x : xs)
+        x = L::from_log(u(g));
+    std::vector<float> ys(n);
+    std::vector<std::uint64_t> over((n + 63) / 64), under(over.size());
+
+    bench("operator T, safe<lg> ", [&]
+    {
+        std::size_t invalid = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            ys[i] = float(xs[i]);
+            invalid += source_overflows(xs[i]) || source_underflows(xs[i]);
+        }
+        return double(invalid);
+    });
+    bench("to_source            ", [&]
+    {
+        to_source(xs, ys);
+        return 0.0;
+    });
+    bench("to_source, masks     ", [&]
+    {
+        return double(to_source(std::span<L const>(xs), std::span<float>(ys), std::span<std::uint64_t>(over),
+            std::span<std::uint64_t>(under)));
+    });
+}
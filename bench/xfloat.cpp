@@ -0,0 +1,66 @@
+/**
+ * Compares the product of n probabilities in xfloat<double> and in
+ * lg<double>, e.g., the likelihood of a sample, where the probabilities
+ * start out as values of type double.
+ *
+ *     g++ -std=c++20 -O2 -march=native -Iinclude bench/xfloat.cpp
+ */
+
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+#include "homomorphic_computational_extensions/xfloat.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename F>
+void bench(char const * name, F f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    double r = 0;
+    int const reps = 10;
+    for (int i = 0; i < reps; ++i)
+        r = f();
+    std::chrono::duration<double, std::milli> const t = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << t.count() / reps << " ms (log-likelihood " << r << ")\n";
+}
+
+int main()
+{
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<double> ps(10000000);
+    for (auto & p : ps)
+        p = u(g);
+
+    bench("lg<double> fold      ", [&]
+    {
+        lg<double> r;
+        for (auto p : ps)
+            r = r * lg<double>(p);
+        return r.k;
+    });
+
+    bench("lg<double> product_of", [&] { return product_of(ps).k; });
+    bench("lg<fast_math>        ", [&] { return product_of<fast_math>(ps).k; });
+
+    bench("xfloat<double> fold  ", [&]
+    {
+        xfloat<double> r(1.0);
+        for (auto p : ps)
+            r *= xfloat<double>(p);
+        return lg<double>(r).k;
+    });
+
+    // the mantissa is renormalized lazily, so the raw values may be
+    // multiplied in without normalizing them first.
+    bench("xfloat<double> raw   ", [&]
+    {
+        xfloat<double> r(1.0);
+        for (auto p : ps)
+            r *= xfloat<double>(p, 0);
+        return lg<double>(r).k;
+    });
+}
@@ -0,0 +1,478 @@
+/**
+ * block_scaled<S,B> is an array of real numbers in block floating point,
+ * i.e., the array is split into blocks of B values and the i-th value
+ * of a block with exponent e is
+ *     m[i] * 2^e,
+ * where the mantissas m[i] are of type S, float or std::int16_t, and e
+ * is a 32-bit integer shared by the block.
+ *
+ * Like scaled<T,N,D>, it extends the range of T by a scale, except that
+ * the scale is chosen at run time, per block, from the largest value of
+ * the block, so data whose magnitude varies from block to block keeps
+ * its precision relative to the largest value of its block. A value is
+ *     4 bytes + 4/B  for float mantissas (24 bits), and
+ *     2 bytes + 4/B  for int16 mantissas (15 bits),
+ * so a pass over a block_scaled array moves 2x or 4x less memory than
+ * over the same values as double. The exponent of a block is in
+ *     [-2^29, 2^29],
+ * so the range is about 2^(+-2^29), far beyond double, e.g., values
+ * that only exist as lg<T,M> with |k| < 2^29 log(2), about 3.7e8. A block
+ * whose exponent would be above the range saturates, i.e., its exponent
+ * is 2^29 and its mantissas are kept, and a block whose exponent would
+ * be below it flushes to 0, whether it is converted or the result of
+ * an operation, so the exponents of sums and products never overflow.
+ *
+ * The mantissas of a block are normalized so that the largest is in
+ *     [1/2,1)             for float,
+ *     [2^14, 2^15 - 1]    for int16,
+ * and every operation on blocks renormalizes its result:
+ *     +, -, *    : (block_scaled, block_scaled) -> block_scaled
+ *     dot        : (block_scaled, block_scaled) -> xfloat<double>
+ * + and - align the block with the smaller exponent to the larger one,
+ * * multiplies mantissas and adds exponents, and dot reduces each
+ * block of mantissa products and accumulates the blocks, scaled by
+ * their exponents, in xfloat<double>, which cannot overflow. The float
+ * kernels run simd::pack<float>::width values at a time, and the int16
+ * kernels are loops over 32-bit (or 64-bit, for dot) integers, which
+ * the compiler vectorizes. Values smaller than the precision of their
+ * block relative to its largest value flush to 0, which is the price of
+ * a shared exponent.
+ *
+ * Values convert from and to T (float or double), lg<T,M> and
+ * scaled<T,N,D> a block at a time. The conversions to a type that
+ * cannot represent a value overflow or underflow as that type does.
+ * int16 mantissas do not represent infinities or NaN.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "lg_vector.hpp"
+#include "scaled.hpp"
+#include "simd.hpp"
+#include "xfloat.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace block_scaled_detail
+{
+    // the exponent of a block of zeros, which is below that of any other
+    // block, so it never decides the alignment of a sum.
+    inline constexpr std::int32_t zero_exponent = std::numeric_limits<std::int32_t>::min() / 2;
+
+    // the range of the exponent of a block of nonzeros, which is far
+    // enough from zero_exponent and from the limits of int32 that the
+    // differences and sums of two exponents cannot overflow.
+    inline constexpr std::int32_t max_exponent = std::int32_t(1) << 29;
+    inline constexpr std::int32_t min_exponent = -max_exponent;
+
+    // the exponent e of a block of n mantissas m, saturated to max_exponent,
+    // or zero_exponent, with m flushed to 0, if e is below min_exponent.
+    template <typename S>
+    std::int32_t saturate(S * m, std::size_t n, std::int64_t e)
+    {
+        if (e > max_exponent)
+            return max_exponent;
+        if (e < min_exponent)
+        {
+            std::fill_n(m, n, S(0));
+            return zero_exponent;
+        }
+        return std::int32_t(e);
+    }
+
+    // x * 2^k for every x of a block of floats, exact unless a value
+    // overflows or underflows.
+    inline void scale(float * m, std::size_t n, int k)
+    {
+        using P = simd::pack<float>;
+        // 2^k is not a normal float for every k, so it is split in two.
+        auto const h = k / 2;
+        auto const s1 = P::broadcast(std::ldexp(1.0f, h)), s2 = P::broadcast(std::ldexp(1.0f, k - h));
+        for (std::size_t i = 0; i < n; i += P::width)
+            (P::load(m + i) * s1 * s2).store(m + i);
+    }
+
+    inline float magnitude(float const * m, std::size_t n)
+    {
+        using P = simd::pack<float>;
+        auto a = P::broadcast(0.0f);
+        for (std::size_t i = 0; i < n; i += P::width)
+        {
+            auto const x = P::load(m + i);
+            a = max(a, max(x, P::broadcast(0.0f) - x));
+        }
+        return a.hmax();
+    }
+
+    // brings the largest mantissa of a float block to [1/2,1).
+    inline void renormalize(float * m, std::size_t n, std::int32_t & e)
+    {
+        auto const a = magnitude(m, n);
+        if (a == 0.0f)
+            e = zero_exponent;
+        if (a == 0.0f || !std::isfinite(a))
+            return;
+        auto const d = std::ilogb(a) + 1;
+        if (d != 0)
+        {
+            scale(m, n, -d);
+            e += d;
+        }
+    }
+
+    // s[i] * 2^e as int16 mantissas, with the largest in [2^14, 2^15 - 1].
+    inline void renormalize(std::int32_t const * s, std::int16_t * m, std::size_t n, std::int32_t & e)
+    {
+        std::uint32_t a = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            a = std::max(a, s[i] < 0 ? std::uint32_t(0) - std::uint32_t(s[i]) : std::uint32_t(s[i]));
+        if (a == 0)
+        {
+            std::fill_n(m, n, std::int16_t(0));
+            e = zero_exponent;
+            return;
+        }
+
+        int d = std::bit_width(a) - 15;
+        if (d <= 0)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                m[i] = std::int16_t(s[i] * (std::int32_t(1) << -d));
+        }
+        else
+        {
+            // rounded to nearest, which may carry the largest to 2^15.
+            if (((std::uint64_t(a) + (std::uint64_t(1) << (d - 1))) >> d) > 32767)
+                ++d;
+            auto const half = std::int64_t(1) << (d - 1);
+            for (std::size_t i = 0; i < n; ++i)
+                m[i] = std::int16_t((std::int64_t(s[i]) + half) >> d);
+        }
+        e += d;
+    }
+
+    // 2^k as a double, or 0 if k is below the normal range.
+    inline double exp2(std::int64_t k)
+    {
+        if (k < -1022)
+            return 0.0;
+        return std::bit_cast<double>(std::uint64_t(k + 1023) << 52);
+    }
+
+    /**
+     * Encodes a block of n values v[i] * 2^offset, where v[i] are finite
+     * values of type double (or NaN and infinities, for float mantissas).
+     */
+    template <typename S>
+    void encode(double const * v, std::size_t n, std::int64_t offset, S * m, std::int32_t & e)
+    {
+        double a = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+            a = std::max(a, std::abs(v[i]));
+
+        int f = 0;
+        if (a != 0.0 && std::isfinite(a))
+            f = std::ilogb(a) + 1;
+
+        if constexpr (std::is_same_v<S, float>)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                m[i] = float(std::ldexp(v[i], -f));
+            e = saturate(m, n, a == 0.0 ? zero_exponent : f + offset);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                m[i] = std::int16_t(std::clamp(std::nearbyint(std::ldexp(v[i], 15 - f)), -32767.0, 32767.0));
+            e = saturate(m, n, a == 0.0 ? zero_exponent : f - 15 + offset);
+        }
+    }
+}
+
+template <typename S, std::size_t B = 64>
+class block_scaled
+{
+public:
+    static_assert(std::is_same_v<S, float> || std::is_same_v<S, std::int16_t>);
+    static_assert(32 <= B && B <= 256 && B % 16 == 0);
+
+    using mantissa_type = S;
+    static constexpr std::size_t block = B;
+
+    block_scaled() = default;
+
+    // n values equal to 0.
+    explicit block_scaled(std::size_t n) : n_(n), m_(blocks() * B, S(0)), e_(blocks(), block_scaled_detail::zero_exponent) {}
+
+    template <typename T> requires std::is_floating_point_v<T>
+    explicit block_scaled(std::span<T const> xs) : block_scaled(xs.size())
+    {
+        for (std::size_t b = 0; b < blocks(); ++b)
+        {
+            double w[B] = {};
+            std::copy_n(xs.data() + b * B, count(b), w);
+            block_scaled_detail::encode(w, B, 0, m_.data() + b * B, e_[b]);
+        }
+    }
+
+    template <typename T, typename M>
+    explicit block_scaled(std::span<lg<T,M> const> xs) : block_scaled(xs.size())
+    {
+        // exp(k) = exp(k - f log(2)) * 2^f, with f chosen from the largest
+        // exponent of the block so that exp does not overflow or underflow.
+        // f is clamped well beyond the range of the block exponent, where
+        // encode saturates it, so that it converts to an integer.
+        constexpr T limit = T(std::int64_t(1) << 40);
+        for (std::size_t b = 0; b < blocks(); ++b)
+        {
+            auto const n = count(b);
+            T k[B], v[B];
+            for (std::size_t i = 0; i < n; ++i)
+                k[i] = xs[b * B + i].k;
+            auto const top = simd::hmax(k, n);
+            auto const f = std::isfinite(top) ? std::int64_t(std::clamp(std::floor(top / std::numbers::ln2_v<T>), -limit, limit)) : 0;
+            for (std::size_t i = 0; i < n; ++i)
+                k[i] = k[i] - T(f) * std::numbers::ln2_v<T>;
+            M::exp(k, v, n);
+
+            double w[B] = {};
+            std::copy_n(v, n, w);
+            block_scaled_detail::encode(w, B, f, m_.data() + b * B, e_[b]);
+        }
+    }
+
+    template <typename T, int N, int D>
+    explicit block_scaled(std::span<scaled<T,N,D> const> xs) : block_scaled(xs.size())
+    {
+        // k * D/N, where k is brought to [1/2,1) first so the scale cannot
+        // overflow, and is exact if N/D is a power of two.
+        for (std::size_t b = 0; b < blocks(); ++b)
+        {
+            auto const n = count(b);
+            double a = 0.0;
+            for (std::size_t i = 0; i < n; ++i)
+                a = std::max(a, std::abs(double(xs[b * B + i].k)));
+            auto const f = a != 0.0 && std::isfinite(a) ? std::ilogb(a) + 1 : 0;
+
+            double w[B] = {};
+            for (std::size_t i = 0; i < n; ++i)
+                w[i] = scaled_detail::div_scale<double,N,D>(std::ldexp(double(xs[b * B + i].k), -f));
+            block_scaled_detail::encode(w, B, f, m_.data() + b * B, e_[b]);
+        }
+    }
+
+    std::size_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    std::size_t blocks() const { return (n_ + B - 1) / B; }
+
+    // the mantissas, block after block. The last block is padded with 0.
+    std::span<S> mantissas() { return m_; }
+    std::span<S const> mantissas() const { return m_; }
+
+    // the exponent of each block.
+    std::span<std::int32_t> exponents() { return e_; }
+    std::span<std::int32_t const> exponents() const { return e_; }
+
+    // the i-th value, which is never out of range.
+    xfloat<double> operator[](std::size_t i) const { return xfloat<double>(double(m_[i]), e_[i / B]); }
+
+    // the values as T, which may overflow or underflow.
+    template <typename T> requires std::is_floating_point_v<T>
+    void copy_to(std::span<T> ys) const
+    {
+        assert(ys.size() == n_);
+        for (std::size_t b = 0; b < blocks(); ++b)
+        {
+            // 2^e as one multiply, if it is a normal double.
+            auto const e = e_[b];
+            auto const s = std::ldexp(1.0, std::clamp(e, -1022, 1023));
+            for (std::size_t i = 0; i < count(b); ++i)
+            {
+                auto const x = double(m_[b * B + i]);
+                ys[b * B + i] = T(-1022 <= e && e <= 1023 ? x * s : std::ldexp(x, e));
+            }
+        }
+    }
+
+    // the values as lg<T,M>, i.e., log(m) + e log(2). Negative values are NaN.
+    template <typename T, typename M>
+    void copy_to(std::span<lg<T,M>> ys) const
+    {
+        assert(ys.size() == n_);
+        for (std::size_t b = 0; b < blocks(); ++b)
+        {
+            auto const n = count(b);
+            T v[B];
+            for (std::size_t i = 0; i < n; ++i)
+                v[i] = T(m_[b * B + i]);
+            M::log(v, v, n);
+            auto const shift = T(e_[b]) * std::numbers::ln2_v<T>;
+            for (std::size_t i = 0; i < n; ++i)
+                ys[b * B + i] = lg<T,M>::from_log(v[i] + shift);
+        }
+    }
+
+    // the values as scaled<T,N,D>, i.e., m * N/D * 2^e.
+    template <typename T, int N, int D>
+    void copy_to(std::span<scaled<T,N,D>> ys) const
+    {
+        assert(ys.size() == n_);
+        for (std::size_t i = 0; i < n_; ++i)
+        {
+            auto const k = std::ldexp(scaled_detail::times_scale<double,N,D>(double(m_[i])), e_[i / B]);
+            ys[i] = scaled<T,N,D>::from_scaled(T(k));
+        }
+    }
+
+private:
+    // the number of values in block b.
+    std::size_t count(std::size_t b) const { return std::min(B, n_ - b * B); }
+
+    std::size_t n_ = 0;
+    std::vector<S, lg_vector_detail::aligned_allocator<S>> m_;
+    std::vector<std::int32_t> e_;
+};
+
+namespace block_scaled_detail
+{
+    // z := x + s y, blockwise, for s = 1 or -1.
+    template <typename S, std::size_t B>
+    auto add(block_scaled<S,B> const & x, block_scaled<S,B> const & y, int s)
+    {
+        assert(x.size() == y.size());
+        block_scaled<S,B> z(x.size());
+        auto const xm = x.mantissas(), ym = y.mantissas();
+        auto const zm = z.mantissas();
+        for (std::size_t b = 0; b < x.blocks(); ++b)
+        {
+            auto const ex = x.exponents()[b], ey = y.exponents()[b];
+            auto const e = std::max(ex, ey);
+            auto & ez = z.exponents()[b];
+            if constexpr (std::is_same_v<S, float>)
+            {
+                using P = simd::pack<float>;
+                // the aligned scale of each operand, which flushes to 0 if it
+                // is far below the other.
+                auto const sx = P::broadcast(std::ldexp(1.0f, std::max(ex - e, -160)));
+                auto const sy = P::broadcast(std::ldexp(float(s), std::max(ey - e, -160)));
+                for (std::size_t i = b * B; i < (b + 1) * B; i += P::width)
+                    (P::load(xm.data() + i) * sx + P::load(ym.data() + i) * sy).store(zm.data() + i);
+                ez = e;
+                renormalize(zm.data() + b * B, B, ez);
+                ez = saturate(zm.data() + b * B, B, ez);
+            }
+            else
+            {
+                // the mantissas are widened by 15 bits, so aligning them
+                // loses nothing but what is below 2^(e - 30).
+                auto const dx = std::min(e - ex, 31), dy = std::min(e - ey, 31);
+                std::int32_t t[B];
+                for (std::size_t i = 0; i < B; ++i)
+                    t[i] = ((std::int32_t(xm[b * B + i]) * 32768) >> dx) + s * ((std::int32_t(ym[b * B + i]) * 32768) >> dy);
+                ez = e - 15;
+                renormalize(t, zm.data() + b * B, B, ez);
+                ez = saturate(zm.data() + b * B, B, ez);
+            }
+        }
+        return z;
+    }
+}
+
+template <typename S, std::size_t B>
+auto operator+(block_scaled<S,B> const & x, block_scaled<S,B> const & y) { return block_scaled_detail::add(x, y, 1); }
+
+template <typename S, std::size_t B>
+auto operator-(block_scaled<S,B> const & x, block_scaled<S,B> const & y) { return block_scaled_detail::add(x, y, -1); }
+
+template <typename S, std::size_t B>
+auto operator*(block_scaled<S,B> const & x, block_scaled<S,B> const & y)
+{
+    assert(x.size() == y.size());
+    block_scaled<S,B> z(x.size());
+    auto const xm = x.mantissas(), ym = y.mantissas();
+    auto const zm = z.mantissas();
+    for (std::size_t b = 0; b < x.blocks(); ++b)
+    {
+        // the shift d of the renormalization is added to the sum of the
+        // exponents in 64 bits, and then the block is saturated.
+        std::int32_t d = 0;
+        if constexpr (std::is_same_v<S, float>)
+        {
+            using P = simd::pack<float>;
+            for (std::size_t i = b * B; i < (b + 1) * B; i += P::width)
+                (P::load(xm.data() + i) * P::load(ym.data() + i)).store(zm.data() + i);
+            block_scaled_detail::renormalize(zm.data() + b * B, B, d);
+        }
+        else
+        {
+            std::int32_t t[B];
+            for (std::size_t i = 0; i < B; ++i)
+                t[i] = std::int32_t(xm[b * B + i]) * ym[b * B + i];
+            block_scaled_detail::renormalize(t, zm.data() + b * B, B, d);
+        }
+        auto const e = std::int64_t(x.exponents()[b]) + y.exponents()[b] + d;
+        z.exponents()[b] = block_scaled_detail::saturate(zm.data() + b * B, B,
+            d == block_scaled_detail::zero_exponent ? std::int64_t(d) : e);
+    }
+    return z;
+}
+
+/**
+ * dot : (block_scaled<S,B>, block_scaled<S,B>) -> xfloat<double>
+ *
+ * x1 y1 + ... + xn yn. For int16 mantissas, the sum of the products of
+ * a block is exact.
+ *
+ * The block sums are accumulated in a double relative to the largest
+ * exponent so far, which is rescaled when a block with a larger exponent
+ * arrives, as in log_exp_sum, so no block pays for an ldexp.
+ */
+template <typename S, std::size_t B>
+auto dot(block_scaled<S,B> const & x, block_scaled<S,B> const & y)
+{
+    assert(x.size() == y.size());
+    auto const xm = x.mantissas(), ym = y.mantissas();
+    double r = 0.0;
+    std::int64_t e = std::numeric_limits<std::int64_t>::min();
+    for (std::size_t b = 0; b < x.blocks(); ++b)
+    {
+        double s;
+        if constexpr (std::is_same_v<S, float>)
+        {
+            using P = simd::pack<float>;
+            auto a = P::broadcast(0.0f);
+            for (std::size_t i = b * B; i < (b + 1) * B; i += P::width)
+                a = a + P::load(xm.data() + i) * P::load(ym.data() + i);
+            s = a.sum();
+        }
+        else
+        {
+            std::int64_t a = 0;
+            for (std::size_t i = b * B; i < (b + 1) * B; ++i)
+                a += std::int32_t(xm[i]) * ym[i];
+            s = double(a);
+        }
+        if (s == 0.0)
+            continue;
+
+        auto const eb = std::int64_t(x.exponents()[b]) + y.exponents()[b];
+        if (e < eb)
+        {
+            r = e == std::numeric_limits<std::int64_t>::min() ? 0.0 : r * block_scaled_detail::exp2(e - eb);
+            e = eb;
+        }
+        r += s * block_scaled_detail::exp2(eb - e);
+    }
+    return r == 0.0 ? xfloat<double>() : xfloat<double>(r, e);
+}
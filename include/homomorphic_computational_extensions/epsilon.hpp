@@ -1,9 +1,11 @@
 #pragma once
 #include <cmath>
 #include <algorithm>
+#include <utility>
 
 using std::exp;
 using std::abs;
+using std::max;
 
 namespace alex::math
 {
@@ -42,17 +44,17 @@ namespace alex::math
             value(copy.value), eps(copy.eps) {}
 
         epsilon(T x, T eps) :
-            value(move(x)), eps(move(eps)) {}
+            value(std::move(x)), eps(std::move(eps)) {}
 
         epsilon & operator=(epsilon const & rhs)
         {
             value = rhs.value;
             eps = rhs.eps;
+            return *this;
         }
 
         operator T() const { return value; }
 
-    private:
         T value;
         T eps;
     };
@@ -90,7 +92,7 @@ namespace alex::math
     template <typename T>
     bool operator>=(epsilon<T> const & x, epsilon<T> const & y)
     {
-        return x == y && y.value > x.value;
+        return x == y || y.value < x.value;
     }
 
     // We allow values of type epsilon<T> to also be wrapped into an epsilon
@@ -101,13 +103,6 @@ namespace alex::math
     template <typename T>
     epsilon<T> distance(epsilon<T> const & a, epsilon<T> const & b)
     {
-        return epsilon<T>(distance(a.vaue,b.value),max(a.eps,b.eps));
+        return epsilon<T>(distance(a.value,b.value),max(a.eps,b.eps));
     }
-
-    struct epsilon_map
-    {
-
-    }
-
-
 }
@@ -0,0 +1,377 @@
+/**
+ * Arithmetic on epsilon<T> that propagates the uncertainty, i.e.,
+ *     +, -, *, / : (epsilon<T>, epsilon<T>) -> epsilon<T>
+ *     exp, log   : epsilon<T> -> epsilon<T>,
+ * and their batch forms over contiguous sequences of epsilon<T>.
+ *
+ * A value x of type epsilon<T> is read as the claim that the true
+ * value is within x.eps of x.value, i.e., in the interval
+ *     [x.value - x.eps, x.value + x.eps].
+ * The result of an operation is the value computed from the values of
+ * the operands, and an eps that bounds the distance to every result of
+ * the operation on points of the operand intervals, including the
+ * rounding error of the computed value itself. So if the operands hold
+ * their claims, so does the result, and a computation carried out in
+ * epsilon<T> comes with a certified bound on its error, at the cost of
+ * a few extra operations per step rather than a second run in higher
+ * precision.
+ *
+ * The bounds are those of midpoint-radius interval arithmetic:
+ *     x + y : x.eps + y.eps
+ *     x * y : |x| y.eps + x.eps |y| + x.eps y.eps
+ *     x / y : (x.eps |y| + |x| y.eps) / (|y| (|y| - y.eps))
+ *     exp x : exp(x) x.eps exp(x.eps)
+ *     log x : x.eps / (x - x.eps),
+ * plus u|r| for the rounding of the result r, where u is the unit
+ * roundoff of T, and 4u|r| for exp and log, whose implementations are
+ * assumed to be within 1 ulp (true of std_math and fast_math). A
+ * divisor, or the argument of log, whose interval reaches 0 has an
+ * infinite eps.
+ *
+ * The bounds must not be rounded down, but the rounding mode is left
+ * at round to nearest, since switching it is slow and not honored by
+ * every SIMD path. Instead, every rounded step of a bound is followed
+ * by
+ *     up(x) := x + (phi x + eta),  phi := u (1 + 2u),  eta := denorm_min,
+ * which is at least the successor of x under round to nearest (Rump,
+ * Zimmermann, Boldo and Melquiond, 2009), and every step that must be
+ * rounded down is followed by the analogous down(x). This assumes IEEE
+ * arithmetic in the precision of T (FLT_EVAL_METHOD == 0, not the x87
+ * unit) with subnormals, i.e., no -ffast-math.
+ *
+ * The kernels are written once against simd::pack (see simd.hpp), so
+ * the batch forms run pack<T>::width values at a time, and the single
+ * value forms are the same kernels on simd::scalar<T>.
+ */
+
+#pragma once
+
+#include "epsilon.hpp"
+#include "lg.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <span>
+
+namespace alex::math
+{
+    namespace epsilon_arithmetic_detail
+    {
+        // number of values buffered at a time by the batch forms.
+        inline constexpr std::size_t block = 256;
+
+        // a value and a bound on its error.
+        template <typename P>
+        struct bound
+        {
+            P c;
+            P r;
+        };
+
+        template <typename P>
+        P constant(typename P::value_type x) { return P::broadcast(x); }
+
+        // the unit roundoff of the lanes of P.
+        template <typename P>
+        P unit() { return constant<P>(std::numeric_limits<typename P::value_type>::epsilon() / 2); }
+
+        // at least the successor of x >= 0.
+        template <typename P>
+        P up(P const & x)
+        {
+            using T = typename P::value_type;
+            auto const u = std::numeric_limits<T>::epsilon() / 2;
+            return x + (constant<P>(u * (1 + 2 * u)) * x + constant<P>(std::numeric_limits<T>::denorm_min()));
+        }
+
+        // at most the predecessor of x >= 0, but not below 0.
+        template <typename P>
+        P down(P const & x)
+        {
+            using T = typename P::value_type;
+            auto const u = std::numeric_limits<T>::epsilon() / 2;
+            return max(x - (constant<P>(u * (1 + 2 * u)) * x + constant<P>(std::numeric_limits<T>::denorm_min())), constant<P>(0));
+        }
+
+        template <typename P>
+        P magnitude(P const & x) { return max(x, constant<P>(0) - x); }
+
+        template <typename P>
+        bound<P> add(P const & a, P const & ra, P const & b, P const & rb)
+        {
+            auto const c = a + b;
+            return { c, up(up(ra + rb) + up(unit<P>() * magnitude(c))) };
+        }
+
+        template <typename P>
+        bound<P> mul(P const & a, P const & ra, P const & b, P const & rb)
+        {
+            auto const c = a * b;
+            auto const p = up(up(up(magnitude(a) * rb) + up(ra * magnitude(b))) + up(ra * rb));
+            return { c, up(p + up(unit<P>() * magnitude(c))) };
+        }
+
+        template <typename P>
+        bound<P> div(P const & a, P const & ra, P const & b, P const & rb)
+        {
+            auto const c = a / b;
+            auto const mb = magnitude(b);
+            auto const num = up(up(ra * mb) + up(magnitude(a) * rb));
+            auto const den = down(mb * down(mb - rb));
+            auto const p = select(num <= constant<P>(0), constant<P>(0),
+                select(den <= constant<P>(0), constant<P>(std::numeric_limits<typename P::value_type>::infinity()), up(num / den)));
+            return { c, up(p + up(unit<P>() * magnitude(c))) };
+        }
+
+        // c := exp(a) and e := exp(ra), both within 1 ulp.
+        template <typename P>
+        bound<P> exp(P const & c, P const & ra, P const & e)
+        {
+            auto const p = select(ra <= constant<P>(0), constant<P>(0), up(up(ra * up(up(c))) * up(up(e))));
+            return { c, up(p + up(constant<P>(4) * unit<P>() * c)) };
+        }
+
+        // c := log(a), within 1 ulp.
+        template <typename P>
+        bound<P> log(P const & a, P const & ra, P const & c)
+        {
+            auto const den = down(a - ra);
+            auto const p = select(ra <= constant<P>(0), constant<P>(0),
+                select(den <= constant<P>(0), constant<P>(std::numeric_limits<typename P::value_type>::infinity()), up(ra / den)));
+            return { c, up(p + up(constant<P>(4) * unit<P>() * magnitude(c))) };
+        }
+
+        template <typename T, typename F>
+        auto scalar(F f, T const & a, T const & ra, T const & b, T const & rb)
+        {
+            using S = simd::scalar<T>;
+            auto const [c, r] = f(S{a}, S{ra}, S{b}, S{rb});
+            return epsilon<T>(c.v, r.v);
+        }
+
+        /**
+         * z[i] := f(x[i], y[i]) for i in [0,n), n <= block, where f maps the
+         * values and eps of the operands, as packs, to a bound. The operands
+         * are split into arrays of values and of eps first, so z may alias x
+         * or y.
+         */
+        template <typename T, typename F>
+        void binary(epsilon<T> const * x, epsilon<T> const * y, epsilon<T> * z, std::size_t n, F f)
+        {
+            using P = simd::pack<T>;
+            using S = simd::scalar<T>;
+
+            T a[block], ra[block], b[block], rb[block];
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                a[i] = x[i].value;
+                ra[i] = x[i].eps;
+                b[i] = y[i].value;
+                rb[i] = y[i].eps;
+            }
+
+            std::size_t const m = n - n % P::width;
+            for (std::size_t i = 0; i < m; i += P::width)
+            {
+                auto const [c, r] = f(P::load(a + i), P::load(ra + i), P::load(b + i), P::load(rb + i));
+                c.store(a + i);
+                r.store(ra + i);
+            }
+            for (std::size_t i = m; i < n; ++i)
+            {
+                auto const [c, r] = f(S::load(a + i), S::load(ra + i), S::load(b + i), S::load(rb + i));
+                c.store(a + i);
+                r.store(ra + i);
+            }
+
+            for (std::size_t i = 0; i < n; ++i)
+                z[i] = epsilon<T>(a[i], ra[i]);
+        }
+
+        template <typename T, typename F>
+        void binary(std::span<epsilon<T> const> x, std::span<epsilon<T> const> y, std::span<epsilon<T>> z, F f)
+        {
+            assert(x.size() == y.size() && x.size() == z.size());
+            for (std::size_t i = 0; i < x.size(); i += block)
+                binary(x.data() + i, y.data() + i, z.data() + i, std::min(block, x.size() - i), f);
+        }
+
+        inline constexpr auto add_ = [](auto a, auto ra, auto b, auto rb) { return add(a, ra, b, rb); };
+        inline constexpr auto sub_ = [](auto a, auto ra, auto b, auto rb) { return add(a, ra, decltype(b)::broadcast(0) - b, rb); };
+        inline constexpr auto mul_ = [](auto a, auto ra, auto b, auto rb) { return mul(a, ra, b, rb); };
+        inline constexpr auto div_ = [](auto a, auto ra, auto b, auto rb) { return div(a, ra, b, rb); };
+    }
+
+    template <typename T>
+    auto operator+(epsilon<T> const & x, epsilon<T> const & y)
+    {
+        return epsilon_arithmetic_detail::scalar(epsilon_arithmetic_detail::add_, x.value, x.eps, y.value, y.eps);
+    }
+
+    template <typename T>
+    auto operator-(epsilon<T> const & x, epsilon<T> const & y)
+    {
+        return epsilon_arithmetic_detail::scalar(epsilon_arithmetic_detail::sub_, x.value, x.eps, y.value, y.eps);
+    }
+
+    // negation is exact.
+    template <typename T>
+    auto operator-(epsilon<T> const & x) { return epsilon<T>(-x.value, x.eps); }
+
+    template <typename T>
+    auto operator*(epsilon<T> const & x, epsilon<T> const & y)
+    {
+        return epsilon_arithmetic_detail::scalar(epsilon_arithmetic_detail::mul_, x.value, x.eps, y.value, y.eps);
+    }
+
+    template <typename T>
+    auto operator/(epsilon<T> const & x, epsilon<T> const & y)
+    {
+        return epsilon_arithmetic_detail::scalar(epsilon_arithmetic_detail::div_, x.value, x.eps, y.value, y.eps);
+    }
+
+    /**
+     * exp : epsilon<T> -> epsilon<T>
+     *
+     * exp(x) with M::exp.
+     */
+    template <typename M = std_math, typename T>
+    auto exp(epsilon<T> const & x)
+    {
+        using S = simd::scalar<T>;
+        auto const [c, r] = epsilon_arithmetic_detail::exp(S{M::exp(x.value)}, S{x.eps}, S{M::exp(x.eps)});
+        return epsilon<T>(c.v, r.v);
+    }
+
+    /**
+     * log : epsilon<T> -> epsilon<T>
+     *
+     * log(x) with M::log.
+     */
+    template <typename M = std_math, typename T>
+    auto log(epsilon<T> const & x)
+    {
+        using S = simd::scalar<T>;
+        auto const [c, r] = epsilon_arithmetic_detail::log(S{x.value}, S{x.eps}, S{M::log(x.value)});
+        return epsilon<T>(c.v, r.v);
+    }
+
+    /**
+     * add : ([epsilon<T>], [epsilon<T>], [epsilon<T>]) -> void
+     *
+     * z[i] := x[i] + y[i]. z may alias x or y, as for the other batch
+     * forms below.
+     */
+    template <typename T>
+    void add(std::span<epsilon<T> const> x, std::span<epsilon<T> const> y, std::span<epsilon<T>> z)
+    {
+        epsilon_arithmetic_detail::binary(x, y, z, epsilon_arithmetic_detail::add_);
+    }
+
+    /**
+     * sub : ([epsilon<T>], [epsilon<T>], [epsilon<T>]) -> void
+     *
+     * z[i] := x[i] - y[i].
+     */
+    template <typename T>
+    void sub(std::span<epsilon<T> const> x, std::span<epsilon<T> const> y, std::span<epsilon<T>> z)
+    {
+        epsilon_arithmetic_detail::binary(x, y, z, epsilon_arithmetic_detail::sub_);
+    }
+
+    /**
+     * mul : ([epsilon<T>], [epsilon<T>], [epsilon<T>]) -> void
+     *
+     * z[i] := x[i] * y[i].
+     */
+    template <typename T>
+    void mul(std::span<epsilon<T> const> x, std::span<epsilon<T> const> y, std::span<epsilon<T>> z)
+    {
+        epsilon_arithmetic_detail::binary(x, y, z, epsilon_arithmetic_detail::mul_);
+    }
+
+    /**
+     * div : ([epsilon<T>], [epsilon<T>], [epsilon<T>]) -> void
+     *
+     * z[i] := x[i] / y[i].
+     */
+    template <typename T>
+    void div(std::span<epsilon<T> const> x, std::span<epsilon<T> const> y, std::span<epsilon<T>> z)
+    {
+        epsilon_arithmetic_detail::binary(x, y, z, epsilon_arithmetic_detail::div_);
+    }
+
+    /**
+     * exp : ([epsilon<T>], [epsilon<T>]) -> void
+     *
+     * z[i] := exp(x[i]), a block at a time with the batch M::exp.
+     */
+    template <typename M = std_math, typename T>
+    void exp(std::span<epsilon<T> const> x, std::span<epsilon<T>> z)
+    {
+        using P = simd::pack<T>;
+        using S = simd::scalar<T>;
+        constexpr auto block = epsilon_arithmetic_detail::block;
+        assert(x.size() == z.size());
+
+        T a[block], ra[block], e[block];
+        for (std::size_t j = 0; j < x.size(); j += block)
+        {
+            auto const n = std::min(block, x.size() - j);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                a[i] = x[j + i].value;
+                ra[i] = x[j + i].eps;
+            }
+            M::exp(a, a, n);
+            M::exp(ra, e, n);
+
+            std::size_t const m = n - n % P::width;
+            for (std::size_t i = 0; i < m; i += P::width)
+                epsilon_arithmetic_detail::exp(P::load(a + i), P::load(ra + i), P::load(e + i)).r.store(ra + i);
+            for (std::size_t i = m; i < n; ++i)
+                epsilon_arithmetic_detail::exp(S::load(a + i), S::load(ra + i), S::load(e + i)).r.store(ra + i);
+
+            for (std::size_t i = 0; i < n; ++i)
+                z[j + i] = epsilon<T>(a[i], ra[i]);
+        }
+    }
+
+    /**
+     * log : ([epsilon<T>], [epsilon<T>]) -> void
+     *
+     * z[i] := log(x[i]), a block at a time with the batch M::log.
+     */
+    template <typename M = std_math, typename T>
+    void log(std::span<epsilon<T> const> x, std::span<epsilon<T>> z)
+    {
+        using P = simd::pack<T>;
+        using S = simd::scalar<T>;
+        constexpr auto block = epsilon_arithmetic_detail::block;
+        assert(x.size() == z.size());
+
+        T a[block], ra[block], c[block];
+        for (std::size_t j = 0; j < x.size(); j += block)
+        {
+            auto const n = std::min(block, x.size() - j);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                a[i] = x[j + i].value;
+                ra[i] = x[j + i].eps;
+            }
+            M::log(a, c, n);
+
+            std::size_t const m = n - n % P::width;
+            for (std::size_t i = 0; i < m; i += P::width)
+                epsilon_arithmetic_detail::log(P::load(a + i), P::load(ra + i), P::load(c + i)).r.store(ra + i);
+            for (std::size_t i = m; i < n; ++i)
+                epsilon_arithmetic_detail::log(S::load(a + i), S::load(ra + i), S::load(c + i)).r.store(ra + i);
+
+            for (std::size_t i = 0; i < n; ++i)
+                z[j + i] = epsilon<T>(c[i], ra[i]);
+        }
+    }
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "epsilon.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+namespace alex::math
+{
+    /**
+     * A static index over a collection of epsilon<T> that answers the
+     * queries
+     *     equal(q)    : the x with x == q
+     *     less(q)     : the x with x < q
+     *     greater(q)  : the x with x > q
+     *     range(a,b)  : the x with a <= x && x <= b
+     * in the partial order of epsilon<T>, without comparing q to every
+     * value.
+     *
+     * Since
+     *     x == q  iff  |x.value - q.value| <= max(x.eps, q.eps),
+     * x is equal to q if x.value is within q.eps of q.value, which is a
+     * contiguous run of the values sorted by value, found by binary
+     * search, or if q.value is within x.eps of x.value, i.e., q.value
+     * stabs the interval [x.value - x.eps, x.value + x.eps]. The
+     * intervals to the left (right) of the run that reach q.value are
+     * found by descending a tree of the maxima of x.value + x.eps (the
+     * minima of x.value - x.eps) over the sorted order, which only enters
+     * subtrees that contain such an interval.
+     *
+     * So equal(q) takes O(log n + k log n) for k results, and O(log n + k)
+     * if the eps are about the same, since then the intervals that reach
+     * q.value are next to the run. less(q) and greater(q) are a prefix
+     * and a suffix of the sorted order without the values equal to q.
+     *
+     * Queries report the positions of the values in the collection the
+     * index was built from, in increasing order of value.
+     *
+     * The index is built by sorting, which runs in parallel on a
+     * thread_pool if one is given: the chunks are sorted by the workers
+     * and merged pairwise.
+     */
+    template <typename T>
+    class epsilon_index
+    {
+    public:
+        explicit epsilon_index(std::span<epsilon<T> const> xs)
+        {
+            thread_pool pool(1);
+            build(xs, pool);
+        }
+
+        epsilon_index(std::span<epsilon<T> const> xs, thread_pool & pool) { build(xs, pool); }
+
+        std::size_t size() const { return value_.size(); }
+
+        // the positions of the x with x == q.
+        std::vector<std::size_t> equal(epsilon<T> const & q) const
+        {
+            std::vector<std::size_t> r;
+            auto const [l, h] = run(q);
+            stab_left(1, 0, leaves_, l, q.value, r);
+            for (auto i = l; i < h; ++i)
+                r.push_back(id_[i]);
+            stab_right(1, 0, leaves_, h, q.value, r);
+            return r;
+        }
+
+        // the positions of the x with x < q.
+        std::vector<std::size_t> less(epsilon<T> const & q) const
+        {
+            std::vector<std::size_t> r;
+            auto const l = run(q).first;
+            for (std::size_t i = 0; i < l; ++i)
+                if (value_[i] + eps_[i] < q.value)
+                    r.push_back(id_[i]);
+            return r;
+        }
+
+        // the positions of the x with x > q.
+        std::vector<std::size_t> greater(epsilon<T> const & q) const
+        {
+            std::vector<std::size_t> r;
+            for (auto i = run(q).second; i < size(); ++i)
+                if (q.value < value_[i] - eps_[i])
+                    r.push_back(id_[i]);
+            return r;
+        }
+
+        // the positions of the x with a <= x && x <= b.
+        std::vector<std::size_t> range(epsilon<T> const & a, epsilon<T> const & b) const
+        {
+            std::vector<std::size_t> r;
+            auto const i0 = std::upper_bound(value_.begin(), value_.end(), a.value) - value_.begin();
+            auto const i1 = std::lower_bound(value_.begin(), value_.end(), b.value) - value_.begin();
+
+            // x == a or x == b, but not strictly between them.
+            auto const at = [&](std::size_t i) { return epsilon<T>(value_[i], eps_[i]); };
+            for (auto const p : equal(a))
+                if (auto const i = rank_[p]; (i < std::size_t(i0) || std::size_t(i1) <= i) && (at(i) <= b))
+                    r.push_back(p);
+            for (auto const p : equal(b))
+                if (auto const i = rank_[p]; (i < std::size_t(i0) || std::size_t(i1) <= i) && !(at(i) == a) && a <= at(i))
+                    r.push_back(p);
+            for (auto i = i0; i < i1; ++i)
+                r.push_back(id_[i]);
+
+            std::sort(r.begin(), r.end(), [&](std::size_t x, std::size_t y) { return rank_[x] < rank_[y]; });
+            return r;
+        }
+
+    private:
+        void build(std::span<epsilon<T> const> xs, thread_pool & pool)
+        {
+            auto const n = xs.size();
+            std::vector<std::size_t> order(n);
+            std::iota(order.begin(), order.end(), std::size_t(0));
+            auto const by_value = [&](std::size_t i, std::size_t j) { return xs[i].value < xs[j].value; };
+
+            // sort chunks in parallel, then merge them pairwise, a round at a time.
+            std::size_t const chunks = std::min<std::size_t>(std::max<std::size_t>(n / 4096, 1), 4 * pool.size());
+            auto const bound = [&](std::size_t c) { return n * c / chunks; };
+            pool.parallel_for(chunks, [&](std::size_t c)
+            {
+                std::sort(order.begin() + bound(c), order.begin() + bound(c + 1), by_value);
+            });
+            for (std::size_t w = 1; w < chunks; w *= 2)
+            {
+                pool.parallel_for((chunks + 2 * w - 1) / (2 * w), [&](std::size_t m)
+                {
+                    auto const c = 2 * w * m;
+                    if (c + w < chunks)
+                        std::inplace_merge(order.begin() + bound(c), order.begin() + bound(c + w),
+                            order.begin() + bound(std::min(chunks, c + 2 * w)), by_value);
+                });
+            }
+
+            value_.resize(n);
+            eps_.resize(n);
+            id_ = std::move(order);
+            rank_.resize(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                value_[i] = xs[id_[i]].value;
+                eps_[i] = xs[id_[i]].eps;
+                rank_[id_[i]] = i;
+            }
+
+            leaves_ = 1;
+            while (leaves_ < n)
+                leaves_ *= 2;
+            hi_.assign(2 * leaves_, -std::numeric_limits<T>::infinity());
+            lo_.assign(2 * leaves_, std::numeric_limits<T>::infinity());
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                hi_[leaves_ + i] = value_[i] + eps_[i];
+                lo_[leaves_ + i] = value_[i] - eps_[i];
+            }
+            for (std::size_t i = leaves_ - 1; i > 0; --i)
+            {
+                hi_[i] = max(hi_[2 * i], hi_[2 * i + 1]);
+                lo_[i] = std::min(lo_[2 * i], lo_[2 * i + 1]);
+            }
+        }
+
+        // the sorted positions of the values within q.eps of q.value.
+        std::pair<std::size_t, std::size_t> run(epsilon<T> const & q) const
+        {
+            auto const l = std::lower_bound(value_.begin(), value_.end(), q.value - q.eps) - value_.begin();
+            auto const h = std::upper_bound(value_.begin(), value_.end(), q.value + q.eps) - value_.begin();
+            return { std::size_t(l), std::size_t(std::max(l, h)) };
+        }
+
+        // reports the i < end in [nl,nr) of node with value_[i] + eps_[i] >= v.
+        void stab_left(std::size_t node, std::size_t nl, std::size_t nr, std::size_t end, T v, std::vector<std::size_t> & r) const
+        {
+            if (end <= nl || hi_[node] < v)
+                return;
+            if (node >= leaves_)
+            {
+                r.push_back(id_[nl]);
+                return;
+            }
+            auto const mid = (nl + nr) / 2;
+            stab_left(2 * node, nl, mid, end, v, r);
+            stab_left(2 * node + 1, mid, nr, end, v, r);
+        }
+
+        // reports the i >= begin in [nl,nr) of node with value_[i] - eps_[i] <= v.
+        void stab_right(std::size_t node, std::size_t nl, std::size_t nr, std::size_t begin, T v, std::vector<std::size_t> & r) const
+        {
+            if (nr <= begin || v < lo_[node] || size() <= nl)
+                return;
+            if (node >= leaves_)
+            {
+                r.push_back(id_[nl]);
+                return;
+            }
+            auto const mid = (nl + nr) / 2;
+            stab_right(2 * node, nl, mid, begin, v, r);
+            stab_right(2 * node + 1, mid, nr, begin, v, r);
+        }
+
+        // the values and eps in increasing order of value.
+        std::vector<T> value_;
+        std::vector<T> eps_;
+        // the position in the collection of each sorted value, and the
+        // sorted position of each value in the collection.
+        std::vector<std::size_t> id_;
+        std::vector<std::size_t> rank_;
+        // the maxima of value + eps and the minima of value - eps over the
+        // subtrees of a complete binary tree over the sorted order.
+        std::size_t leaves_ = 1;
+        std::vector<T> hi_;
+        std::vector<T> lo_;
+    };
+}
@@ -0,0 +1,253 @@
+/**
+ * fast_math is a math policy for lg<T,M>, i.e.,
+ *     lg<double,fast_math>
+ * maps values to and from the log-domain with the polynomial log and exp
+ * kernels below rather than std::log and std::exp.
+ *
+ * The kernels are the classic reductions
+ *     log(x) = e*log(2) + log(m),   x = 2^e * m,  m in [sqrt(2)/2, sqrt(2)),
+ *     exp(x) = 2^k * exp(r),        x = k*log(2) + r, |r| <= log(2)/2,
+ * with minimax polynomials for log(m) and exp(r) (the coefficients of
+ * fdlibm), but written without branches on the argument: special values
+ * (0, negative, subnormal, infinite, NaN and results that overflow or
+ * underflow) are handled by selects. The kernels are written once
+ * against simd::pack (see simd.hpp), so the batch forms
+ *     fast_math::log : (T*,T*,n) -> void
+ *     fast_math::exp : (T*,T*,n) -> void
+ * run pack<T>::width values at a time on the widest enabled instruction
+ * set, and the single value forms used by lg<T,fast_math> are the same
+ * kernels on simd::scalar<T>.
+ *
+ * Accuracy over the full range of T, as measured by test/fast_math.cpp
+ * against std::log and std::exp rather than against the exact values, is
+ *     log<double> : within 1 ulp of std::log
+ *     exp<double> : within 1 ulp of std::exp, where for subnormal
+ *                   results an ulp is the subnormal spacing 2^-1074
+ *     log<float>  : within 1 ulp of std::log
+ *     exp<float>  : within 1 ulp of std::exp, where for subnormal
+ *                   results an ulp is the subnormal spacing 2^-149.
+ * The largest error the test finds is exactly 1 ulp, so it is a bound
+ * and not a strict one.
+ * Special values follow std::log and std::exp, e.g., log(0) = -inf,
+ * log(-1) = NaN and exp(inf) = inf.
+ *
+ * Only float and double are supported, and the kernels assume that
+ * they are evaluated in their own precision, i.e., FLT_EVAL_METHOD == 0
+ * (not the x87 unit).
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace fast_math_detail
+{
+    template <typename P>
+    P log64(P const & x)
+    {
+        auto const c = [](double v) { return P::broadcast(v); };
+        constexpr double inf = std::numeric_limits<double>::infinity();
+
+        auto const ln2_hi = c(6.93147180369123816490e-01);
+        auto const ln2_lo = c(1.90821492927058770002e-10);
+        auto const lg1 = c(6.666666666666735130e-01);
+        auto const lg2 = c(3.999999999940941908e-01);
+        auto const lg3 = c(2.857142874366239149e-01);
+        auto const lg4 = c(2.222219843214978396e-01);
+        auto const lg5 = c(1.818357216161805012e-01);
+        auto const lg6 = c(1.531383769920937332e-01);
+        auto const lg7 = c(1.479819860511658591e-01);
+
+        // bring subnormals into the normal range.
+        auto const sub = x < c(0x1p-1022);
+        auto const y = x * select(sub, c(0x1p54), c(1.0));
+        auto const bias = select(sub, c(-54.0), c(0.0));
+
+        // x = 2^e * m with m in [sqrt(2)/2, sqrt(2)). The biased exponent of
+        // m*sqrt(2) is shifted down and converted to a double by placing it
+        // in the mantissa of 2^52.
+        constexpr std::uint64_t sqrt_half = 0x3fe6a09e667f3bcdull;
+        auto const eb = iadd(y, P::from_bits((0x3ffull << 52) - sqrt_half)).shr(52);
+        auto const m = isub(y, isub(eb, P::from_bits(0x3ff)).shl(52));
+        auto const e = ior(eb, P::from_bits(0x4330000000000000ull)) - c(0x1p52 + 1023.0) + bias;
+
+        auto const f = m - c(1.0);
+        auto const s = f / (c(2.0) + f);
+        auto const z = s * s;
+        auto const w = z * z;
+        auto const t1 = w * (lg2 + w * (lg4 + w * lg6));
+        auto const t2 = z * (lg1 + w * (lg3 + w * (lg5 + w * lg7)));
+        auto const hfsq = c(0.5) * f * f;
+        auto const r = s * (hfsq + (t1 + t2)) + e * ln2_lo - hfsq + f + e * ln2_hi;
+
+        auto const finite = (c(0.0) < x) & (x < c(inf));
+        auto const special = select(x == c(0.0), c(-inf),
+            select(x == c(inf), c(inf), c(std::numeric_limits<double>::quiet_NaN())));
+        return select(finite, r, special);
+    }
+
+    template <typename P>
+    P exp64(P x)
+    {
+        auto const c = [](double v) { return P::broadcast(v); };
+
+        auto const inv_ln2 = c(1.44269504088896338700e+00);
+        auto const ln2_hi = c(6.93147180369123816490e-01);
+        auto const ln2_lo = c(1.90821492927058770002e-10);
+        auto const p1 = c(1.66666666666666019037e-01);
+        auto const p2 = c(-2.77777777770155933842e-03);
+        auto const p3 = c(6.61375632143793436117e-05);
+        auto const p4 = c(-1.65339022054652515390e-06);
+        auto const p5 = c(4.13813679705723846039e-08);
+        auto const shift = c(0x1.8p52);
+
+        // exp overflows above 709.79 and underflows below -745.14. The
+        // comparisons are false for NaN, so NaN propagates.
+        x = select(x < c(-746.0), c(-746.0), x);
+        x = select(c(710.0) < x, c(710.0), x);
+
+        // k = round(x/log(2)) and r = x - k*log(2).
+        auto const k = (x * inv_ln2 + shift) - shift;
+        auto const hi = x - k * ln2_hi;
+        auto const lo = k * ln2_lo;
+        auto const r = hi - lo;
+
+        auto const z = r * r;
+        auto const q = r - z * (p1 + z * (p2 + z * (p3 + z * (p4 + z * p5))));
+        auto const y = c(1.0) - ((lo - (r * q) / (c(2.0) - q)) - hi);
+
+        // 2^k, split as 2^k1 * 2^k2 so that each factor is a normal double
+        // even when the result is subnormal or overflows. y * 2^k1 is exact,
+        // so a subnormal result is rounded once.
+        auto const k1 = (k * c(0.5) + shift) - shift;
+        auto const k2 = k - k1;
+        auto const s1 = (k1 + c(0x1.8p52 + 1023.0)).shl(52);
+        auto const s2 = (k2 + c(0x1.8p52 + 1023.0)).shl(52);
+        return y * s1 * s2;
+    }
+
+    template <typename P>
+    P log32(P const & x)
+    {
+        auto const c = [](float v) { return P::broadcast(v); };
+        constexpr float inf = std::numeric_limits<float>::infinity();
+
+        auto const ln2_hi = c(6.9313812256e-01f);
+        auto const ln2_lo = c(9.0580006145e-06f);
+        auto const lg1 = c(0xaaaaaa.0p-24f);
+        auto const lg2 = c(0xccce13.0p-25f);
+        auto const lg3 = c(0x91e9ee.0p-25f);
+        auto const lg4 = c(0xf89e26.0p-26f);
+
+        auto const sub = x < c(0x1p-126f);
+        auto const y = x * select(sub, c(0x1p25f), c(1.0f));
+        auto const bias = select(sub, c(-25.0f), c(0.0f));
+
+        constexpr std::uint32_t sqrt_half = 0x3f3504f3u;
+        auto const eb = iadd(y, P::from_bits((0x7fu << 23) - sqrt_half)).shr(23);
+        auto const m = isub(y, isub(eb, P::from_bits(0x7f)).shl(23));
+        auto const e = ior(eb, P::from_bits(0x4b000000u)) - c(0x1p23f + 127.0f) + bias;
+
+        auto const f = m - c(1.0f);
+        auto const s = f / (c(2.0f) + f);
+        auto const z = s * s;
+        auto const w = z * z;
+        auto const t1 = w * (lg2 + w * lg4);
+        auto const t2 = z * (lg1 + w * lg3);
+        auto const hfsq = c(0.5f) * f * f;
+        auto const r = s * (hfsq + (t1 + t2)) + e * ln2_lo - hfsq + f + e * ln2_hi;
+
+        auto const finite = (c(0.0f) < x) & (x < c(inf));
+        auto const special = select(x == c(0.0f), c(-inf),
+            select(x == c(inf), c(inf), c(std::numeric_limits<float>::quiet_NaN())));
+        return select(finite, r, special);
+    }
+
+    template <typename P>
+    P exp32(P x)
+    {
+        auto const c = [](float v) { return P::broadcast(v); };
+
+        auto const inv_ln2 = c(1.4426950216e+00f);
+        auto const ln2_hi = c(6.9314575195e-01f);
+        auto const ln2_lo = c(1.4286067653e-06f);
+        auto const p1 = c(1.6666625440e-1f);
+        auto const p2 = c(-2.7667332906e-3f);
+        auto const shift = c(0x1.8p23f);
+
+        x = select(x < c(-104.0f), c(-104.0f), x);
+        x = select(c(89.0f) < x, c(89.0f), x);
+
+        auto const k = (x * inv_ln2 + shift) - shift;
+        auto const hi = x - k * ln2_hi;
+        auto const lo = k * ln2_lo;
+        auto const r = hi - lo;
+
+        auto const z = r * r;
+        auto const q = r - z * (p1 + z * p2);
+        auto const y = c(1.0f) - ((lo - (r * q) / (c(2.0f) - q)) - hi);
+
+        auto const k1 = (k * c(0.5f) + shift) - shift;
+        auto const k2 = k - k1;
+        auto const s1 = (k1 + c(0x1.8p23f + 127.0f)).shl(23);
+        auto const s2 = (k2 + c(0x1.8p23f + 127.0f)).shl(23);
+        return y * s1 * s2;
+    }
+
+    template <typename P>
+    P log(P const & x)
+    {
+        static_assert(std::is_same_v<typename P::value_type, double> || std::is_same_v<typename P::value_type, float>);
+        if constexpr (std::is_same_v<typename P::value_type, double>)
+            return log64(x);
+        else
+            return log32(x);
+    }
+
+    template <typename P>
+    P exp(P const & x)
+    {
+        static_assert(std::is_same_v<typename P::value_type, double> || std::is_same_v<typename P::value_type, float>);
+        if constexpr (std::is_same_v<typename P::value_type, double>)
+            return exp64(x);
+        else
+            return exp32(x);
+    }
+}
+
+struct fast_math
+{
+    template <typename T>
+    static T log(T const & x) { return fast_math_detail::log(simd::scalar<T>{x}).v; }
+
+    template <typename T>
+    static T exp(T const & x) { return fast_math_detail::exp(simd::scalar<T>{x}).v; }
+
+    template <typename T>
+    static void log(T const * x, T * y, std::size_t n)
+    {
+        using P = simd::pack<T>;
+        std::size_t const m = n - n % P::width;
+        for (std::size_t i = 0; i < m; i += P::width)
+            fast_math_detail::log(P::load(x + i)).store(y + i);
+        for (std::size_t i = m; i < n; ++i)
+            y[i] = log(x[i]);
+    }
+
+    template <typename T>
+    static void exp(T const * x, T * y, std::size_t n)
+    {
+        using P = simd::pack<T>;
+        std::size_t const m = n - n % P::width;
+        for (std::size_t i = 0; i < m; i += P::width)
+            fast_math_detail::exp(P::load(x + i)).store(y + i);
+        for (std::size_t i = m; i < n; ++i)
+            y[i] = exp(x[i]);
+    }
+};
@@ -0,0 +1,196 @@
+/**
+ * Integer logarithms, i.e., for an unsigned integer x > 0,
+ *     ilog2 : U -> int,  ilog2(x) := floor(log2(x)),
+ * which is the position of the highest set bit of x, and is computed
+ * exactly with std::bit_width (a single lzcnt or bsr) rather than by
+ * converting x to a floating point number and calling log. By
+ * convention, ilog2(0) = -1.
+ *
+ * ilog2 is constexpr and branchless for 8 to 64-bit integers and for
+ * unsigned __int128 (where the compiler has it), and is also defined
+ * for multi-word integers given as a sequence of limbs, least
+ * significant first, e.g., the digits of a bigint.
+ *
+ * Counts are often bucketed by magnitude, e.g., in a histogram with a
+ * bounded relative error. For that,
+ *     log_bucket<S> : U -> U
+ * maps x to its bucket in a log-linear scale with 2^S buckets per
+ * octave: values below 2^(S+1) have a bucket of their own, and above
+ * that each octave [2^e, 2^(e+1)) is split into 2^S buckets of equal
+ * width, so the bucket of x determines x within a factor of 1 + 2^-S.
+ * The buckets are consecutive integers in the order of the values, and
+ *     log_bucket_floor<S> : U -> U
+ * is the smallest value of a bucket.
+ *
+ * The batch forms over contiguous sequences are plain loops of shifts,
+ * compares and, for 32-bit integers, an exact conversion to double
+ * whose exponent is ilog2, which the compiler vectorizes.
+ *
+ * Finally,
+ *     approx_log2 : uint64 -> double
+ * is log2(x) from ilog2 and a table of log2 over the leading bits of the
+ * mantissa, interpolated linearly, with an absolute error below 3e-6
+ * (and exact to double rounding for x < 512). It is what
+ * lg<T,M>::from_integer uses to map counts to the log-domain without a
+ * call to log.
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace ilog2_detail
+{
+    template <typename U>
+    inline constexpr bool is_unsigned_v = std::is_unsigned_v<U> && std::is_integral_v<U>;
+
+#ifdef __SIZEOF_INT128__
+    using uint128 = unsigned __int128;
+
+    template <>
+    inline constexpr bool is_unsigned_v<uint128> = true;
+#endif
+
+    template <typename U>
+    concept unsigned_integer = is_unsigned_v<U> && !std::is_same_v<U, bool>;
+}
+
+/**
+ * ilog2 : U -> int
+ *
+ * floor(log2(x)) for x > 0, and -1 for x = 0.
+ */
+template <ilog2_detail::unsigned_integer U>
+constexpr int ilog2(U x)
+{
+#ifdef __SIZEOF_INT128__
+    if constexpr (std::is_same_v<U, ilog2_detail::uint128>)
+    {
+        auto const hi = std::uint64_t(x >> 64), lo = std::uint64_t(x);
+        return hi ? 64 + ilog2(hi) : ilog2(lo);
+    }
+    else
+#endif
+        return int(std::bit_width(x)) - 1;
+}
+
+/**
+ * ilog2 : [U] -> int
+ *
+ * floor(log2(x)) of the multi-word integer x whose limbs, least
+ * significant first, are xs, and -1 if x = 0.
+ */
+template <ilog2_detail::unsigned_integer U>
+constexpr std::int64_t ilog2(std::span<U const> xs)
+{
+    constexpr std::int64_t bits = sizeof(U) * 8;
+    for (auto i = std::int64_t(xs.size()) - 1; i >= 0; --i)
+        if (xs[i] != 0)
+            return i * bits + ilog2(xs[i]);
+    return -1;
+}
+
+/**
+ * ilog2 : ([U], [int]) -> void
+ *
+ * ys[i] := ilog2(xs[i]).
+ */
+template <ilog2_detail::unsigned_integer U>
+void ilog2(std::span<U const> xs, std::span<int> ys)
+{
+    if constexpr (sizeof(U) <= 4)
+    {
+        // x is exact as a double, whose biased exponent is 1023 + ilog2(x).
+        for (std::size_t i = 0; i < xs.size(); ++i)
+        {
+            auto const e = int(std::bit_cast<std::uint64_t>(double(xs[i])) >> 52) - 1023;
+            ys[i] = xs[i] == 0 ? -1 : e;
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            ys[i] = ilog2(xs[i]);
+    }
+}
+
+/**
+ * log_bucket<S> : U -> U
+ *
+ * The bucket of x in a log-linear scale with 2^S buckets per octave.
+ */
+template <int S, ilog2_detail::unsigned_integer U>
+constexpr U log_bucket(U x)
+{
+    static_assert(0 <= S && S < int(sizeof(U) * 8) - 1);
+    auto const w = ilog2(x) + 1 - (S + 1);
+    auto const shift = w < 0 ? 0 : w;
+    return (U(shift) << S) + (x >> shift);
+}
+
+/**
+ * log_bucket_floor<S> : U -> U
+ *
+ * The smallest x with log_bucket<S>(x) = b.
+ */
+template <int S, ilog2_detail::unsigned_integer U>
+constexpr U log_bucket_floor(U b)
+{
+    static_assert(0 <= S && S < int(sizeof(U) * 8) - 1);
+    auto const w = int(b >> S) - 1;
+    auto const shift = w < 0 ? 0 : w;
+    return (b - (U(shift) << S)) << shift;
+}
+
+/**
+ * log_bucket<S> : ([U], [U]) -> void
+ *
+ * ys[i] := log_bucket<S>(xs[i]).
+ */
+template <int S, ilog2_detail::unsigned_integer U>
+void log_bucket(std::span<U const> xs, std::span<U> ys)
+{
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        ys[i] = log_bucket<S>(xs[i]);
+}
+
+namespace ilog2_detail
+{
+    // the number of leading mantissa bits that index the table.
+    inline constexpr int table_bits = 8;
+
+    // log2(1 + i/2^table_bits) for i in [0, 2^table_bits].
+    inline std::array<double, (1 << table_bits) + 1> const log2_table = []
+    {
+        std::array<double, (1 << table_bits) + 1> t{};
+        for (std::size_t i = 0; i < t.size(); ++i)
+            t[i] = std::log2(1.0 + double(i) / (1 << table_bits));
+        return t;
+    }();
+}
+
+/**
+ * approx_log2 : uint64 -> double
+ *
+ * log2(x) to within 3e-6, and -inf for x = 0.
+ */
+inline double approx_log2(std::uint64_t x)
+{
+    using namespace ilog2_detail;
+    if (x == 0)
+        return -HUGE_VAL;
+
+    // x = 2^e (1 + f), with f in [0,1) as a 64-bit fixed point fraction.
+    auto const e = ilog2(x);
+    auto const f = (x << (63 - e)) << 1;
+    auto const i = f >> (64 - table_bits);
+    auto const t = double(f << table_bits) * 0x1p-64;
+    return e + log2_table[i] + t * (log2_table[i + 1] - log2_table[i]);
+}
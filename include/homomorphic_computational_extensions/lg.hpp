@@ -42,6 +42,8 @@
  * to lg<T> or T, there are many opportunities to do this conversion without
  * loss, or at least with less loss, e.g.,
  *     (lg<T>(x) + lg<T>(x)) + lg<T>(x) = lg<T>(3)*lg<T>(x).
+ * See lg_expr.hpp, and lns.hpp for a sum of two values from a table
+ * rather than with exp and log.
  * 
  * An interesting underlying type T is one that accumulates
  * very little rounding error on addition, e.g., a type T that
@@ -111,7 +113,12 @@
 
 #pragma once
 
+#include "ilog2.hpp"
+
+#include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
 
 using std::exp;
@@ -119,6 +126,41 @@ using std::log;
 using std::sqrt;
 using std::numeric_limits;
 
+/**
+ * The default math policy of lg<T,M>, which maps values to and from the
+ * log-domain with the log : T -> T and exp : T -> T found for T.
+ *
+ * A math policy M provides
+ *     M::log : T -> T
+ *     M::exp : T -> T
+ * for a single value, and
+ *     M::log : (T*,T*,n) -> void
+ *     M::exp : (T*,T*,n) -> void
+ * for n contiguous values, e.g., see fast_math in fast_math.hpp.
+ */
+struct std_math
+{
+    template <typename T>
+    static T log(T const & x) { using std::log; return log(x); }
+
+    template <typename T>
+    static T exp(T const & x) { using std::exp; return exp(x); }
+
+    template <typename T>
+    static void log(T const * x, T * y, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            y[i] = log(x[i]);
+    }
+
+    template <typename T>
+    static void exp(T const * x, T * y, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            y[i] = exp(x[i]);
+    }
+};
+
 /**
  * Models a computational extension using the fact
  *     exp(log(a*b))==exp(log(a)+log(b)).
@@ -126,14 +168,21 @@ using std::numeric_limits;
  * It has a range of values that is a subset of
  *     (0,e^m]
  * where m := numeric_limits<T>::maximum().
+ *
+ * The math policy M determines how values are mapped to and from the
+ * log-domain, i.e., lg<T,M>(x) stores M::log(x) and (T)lg<T,M> is
+ * M::exp(k). Values with different policies do not mix.
  */
-template <typename T>
+template <typename T, typename M = std_math>
 struct lg
 {
+    using value_type = T;
+    using math = M;
+
     T k;
 
     // log : lg<T> -> lg<T>.
-    auto log() const { return lg<T>{k}; };
+    auto log() const { return lg<T,M>{k}; };
 
     lg(lg const &) = default;
 
@@ -141,111 +190,109 @@ struct lg
     // (i.e., exp(0) = 1).
     lg() : k(T(0)) {}
 
-    lg(T x) : k(log(x)) { assert(0 < x); };
+    lg(T x) : k(M::log(x)) { assert(0 < x); };
+
+    // constructs the value exp(k), i.e., k is stored as is.
+    static constexpr lg<T,M> from_log(T const & k) { return lg<T,M>(k, exponent{}); }
+
+    // constructs the value n, with an exponent within 2.1e-6 of log(n)
+    // computed from the bit width of n rather than M::log (see ilog2.hpp).
+    static lg<T,M> from_integer(std::uint64_t n)
+    {
+        return from_log(T(approx_log2(n) * 0.693147180559945309417232121458176568));
+    }
 
     // operator to convert to type T.
-    operator T() const { return exp(k); }
+    operator T() const { return M::exp(k); }
+
+private:
+    struct exponent {};
+    constexpr lg(T const & k, exponent) : k(k) {}
 };
 
-template <typename T>
-struct ::std::numeric_limits<lg<T>>
+template <typename T, typename M>
+struct std::numeric_limits<lg<T,M>>
 {
-    static constexpr auto max() { return lg<T>{number_limits<T>::max()}; }
-    static constexpr auto min() { return lg<T>{number_limits<T>::min()}; }
+    static constexpr auto max() { return lg<T,M>::from_log(numeric_limits<T>::max()); }
+    static constexpr auto min() { return lg<T,M>::from_log(numeric_limits<T>::min()); }
     static constexpr auto is_signed() { return false; }
     static constexpr auto has_infinity() { return numeric_limits<T>::has_infinity(); }
-    static constexpr auto infinity() { return lg<T>{numeric_limits<T>::infinity()}; }
+    static constexpr auto infinity() { return lg<T,M>::from_log(numeric_limits<T>::infinity()); }
 };
 
-template <typename T>
-auto source_overflows(lg<T> const & x) { return lg<T>(numeric_limits<T>::max()) < x; }
+template <typename T, typename M>
+auto source_overflows(lg<T,M> const & x) { return lg<T,M>(numeric_limits<T>::max()) < x; }
 
-template <typename T>
-auto source_underflows(lg<T> const & x) { return numeric_limits<lg<T>>::max() < x; }
+template <typename T, typename M>
+auto source_underflows(lg<T,M> const & x) { return x < lg<T,M>(numeric_limits<T>::min()); }
 
-template <typename T>
-auto inv(lg<T> const & x) { return lg<T>{-x.k}; }
+template <typename T, typename M>
+auto inv(lg<T,M> const & x) { return lg<T,M>::from_log(-x.k); }
 
-template <typename T>
-auto operator*(lg<T> const & x, lg<T> const & y) { return lg<T>{x.k + y.k}; }
+template <typename T, typename M>
+auto operator*(lg<T,M> const & x, lg<T,M> const & y) { return lg<T,M>::from_log(x.k + y.k); }
 
-template <typename T>
-auto operator/(lg<T> const & x, lg<T> const & y) { return lg<T>{x.k + (-y.k)}; }
+template <typename T, typename M>
+auto operator/(lg<T,M> const & x, lg<T,M> const & y) { return lg<T,M>::from_log(x.k + (-y.k)); }
 
-template <typename T>
-auto operator<(lg<T> const & x, lg<T> const & y) { return x.k < y.k; }
+template <typename T, typename M>
+auto operator<(lg<T,M> const & x, lg<T,M> const & y) { return x.k < y.k; }
 
-template <typename T>
-auto operator<=(lg<T> const & x, lg<T> const & y) { return x.k <= y.k; }
+template <typename T, typename M>
+auto operator<=(lg<T,M> const & x, lg<T,M> const & y) { return x.k <= y.k; }
 
-template <typename T>
-auto operator==(lg<T> const & x, lg<T> const & y) { return x.k == y.k; }
+template <typename T, typename M>
+auto operator==(lg<T,M> const & x, lg<T,M> const & y) { return x.k == y.k; }
 
-template <typename T>
-auto operator!=(lg<T> const & x, lg<T> const & y) { return x.k != y.k; }
+template <typename T, typename M>
+auto operator!=(lg<T,M> const & x, lg<T,M> const & y) { return x.k != y.k; }
 
-template <typename T>
-auto operator>(lg<T> const & x, lg<T> const & y) { return x.k > y.k; }
+template <typename T, typename M>
+auto operator>(lg<T,M> const & x, lg<T,M> const & y) { return x.k > y.k; }
 
-template <typename T>
-auto operator>=(lg<T> const & x, lg<T> const & y) { return x.k >= y.k; }
-
-/**
- * gamma : lg<T> -> lg<T>
- * 
- * Stirling's approximation
- * of the gamma function.
- */
-template <typename T>
-auto gamma(lg<T> const & x)
-{
-    using std::log;
-    using std::sqrt;
-    static const q = log(sqrt((T)2*M_PI));
-    const auto y = (T)x;
-    return lg<T>{q + log(sqrt(y)) + y * (T)(log(x)) + (-y)};
-}
+template <typename T, typename M>
+auto operator>=(lg<T,M> const & x, lg<T,M> const & y) { return x.k >= y.k; }
 
 /**
  * log : lg<T> -> lg<T>
  * 
  * Logarithms are O(1) to compute in lg<T>.
  */
-template <typename T>
-auto log(lg<T> const & x) { return x.log(); }
+template <typename T, typename M>
+auto log(lg<T,M> const & x) { return x.log(); }
 
 /**
  * log : (lg<T>, T) -> lg<T>
  * 
  * log to some base b, i.e., log(x,b) solves y for b^y = x.
  */
-template <typename T, typename U>
-auto log(lg<T> const & x, U const & b)
+template <typename T, typename M, typename U>
+auto log(lg<T,M> const & x, U const & b)
 {
     using std::log;
-    return lg<T>{x.k / (T)log(b)};
+    return lg<T,M>{x.k / (T)log(b)};
 }
 
-template <typename T>
-auto pow(lg<T> const & x, T const & e)
+template <typename T, typename M>
+auto pow(lg<T,M> const & x, T const & e)
 {
-    return lg<T>{e * x.k};
+    return lg<T,M>::from_log(e * x.k);
 }
 
-template <typename T>
-auto sqrt(lg<T> const & x) { return pow(x, T(0.5)); }
+template <typename T, typename M>
+auto sqrt(lg<T,M> const & x) { return pow(x, T(0.5)); }
 
-template <typename T>
-auto nth_root(lg<T> const & x, T const & r) { return pow(x, T(1) / r); }
+template <typename T, typename M>
+auto nth_root(lg<T,M> const & x, T const & r) { return pow(x, T(1) / r); }
 
-template <typename T>
-constexpr auto sign(lg<T> const &) { return 1; }
+template <typename T, typename M>
+constexpr auto sign(lg<T,M> const &) { return 1; }
 
-template <typename T>
-auto abs(lg<T> const & x) { return x; }
+template <typename T, typename M>
+auto abs(lg<T,M> const & x) { return x; }
 
-template <typename T>
-auto floor(lg<T> const & x)
+template <typename T, typename M>
+auto floor(lg<T,M> const & x)
 {
     // Laplace transform of f(t) := floor(e^t) is
     // L(f) = R(s)/s where R is the Riemann zeta
@@ -265,17 +312,6 @@ auto floor(lg<T> const & x)
     return 0;
 }
 
-template <typename T>
-auto fac(int n)
-{
-    T s = T(0);
-    // if T is a floating point type, then adding from smallest to largest
-    // reduces round-off error.
-    for (int i = 2; i <= n; ++i)
-        s += log(i);
-    return lg<T>{s};
-}
-
 /**
  * The exponential function
  *     exp : lg<T> -> lg<T>
@@ -308,8 +344,8 @@ auto fac(int n)
  * 
  * The implementation of exp is trivial.
  */
-template <typename T>
-auto exp(lg<T> const & x) { return lg<T>{(T)x}; }
+template <typename T, typename M>
+auto exp(lg<T,M> const & x) { return lg<T,M>::from_log((T)x); }
 
 /**
  * Many elementary functions in the computational
@@ -352,4 +388,3 @@ auto exp(lg<T> const & x) { return lg<T>{(T)x}; }
  *     (X, +, *, -, X(0)),
  * as required by lg<X>, then they should also work.
  */
-};
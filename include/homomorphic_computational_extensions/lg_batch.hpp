@@ -0,0 +1,178 @@
+/**
+ * Bulk operations over contiguous sequences of lg<T>.
+ *
+ * The most common computation on lg<T> is a long product, e.g., the
+ * likelihood of a sample
+ *     lg<T>(p(x1)) * ... * lg<T>(p(xn)),
+ * which, in the log-domain, is the sum of the exponents
+ *     k1 + ... + kn.
+ *
+ * Folding operator* over the sequence makes each addition depend on
+ * the previous one, so the loop runs at one add per add-latency. The
+ * kernels here instead reduce the exponents with several independent
+ * SIMD accumulators (see simd.hpp), which for float and double is
+ * limited by memory bandwidth rather than by the add latency.
+ *
+ * Note that the result differs from the sequential fold only by the
+ * order of the additions, i.e., it is a different rounding of the
+ * same exact sum.
+ *
+ * Since lg<T> is a standard-layout type whose only member is its
+ * exponent k, a contiguous sequence of lg<T> is viewed as a
+ * contiguous sequence of T without copying.
+ *
+ * For lg<neumaier<T>>, the product is instead the compensated sum of
+ * the exponents (see neumaier.hpp), still computed pack<T>::width
+ * values at a time.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "neumaier.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <ranges>
+#include <span>
+
+namespace lg_batch_detail
+{
+    template <typename T, typename M>
+    T const * exponents(std::span<lg<T,M> const> xs)
+    {
+        static_assert(sizeof(lg<T,M>) == sizeof(T));
+        return reinterpret_cast<T const *>(xs.data());
+    }
+
+    // number of log-transformed values buffered at a time by product_of.
+    inline constexpr std::size_t block = 256;
+}
+
+/**
+ * product : [lg<T>] -> lg<T>
+ *
+ * The product of a sequence of lg<T>, x1 * ... * xn. The empty product
+ * is the multiplicative identity lg<T>().
+ */
+template <typename T, typename M>
+auto product(std::span<lg<T,M> const> xs)
+{
+    return lg<T,M>::from_log(simd::sum(lg_batch_detail::exponents(xs), xs.size()));
+}
+
+/**
+ * product : [lg<neumaier<T>>] -> lg<neumaier<T>>
+ *
+ * Each exponent is the pair (s,c) of T, so a sequence of n exponents is
+ * a sequence of 2n values of type T whose compensated sum is the sum of
+ * the exponents.
+ */
+template <typename T, typename M>
+auto product(std::span<lg<neumaier<T>,M> const> xs)
+{
+    static_assert(sizeof(neumaier<T>) == 2 * sizeof(T));
+    auto const k = reinterpret_cast<T const *>(lg_batch_detail::exponents(xs));
+    return lg<neumaier<T>,M>::from_log(neumaier_sum(k, 2 * xs.size()));
+}
+
+/**
+ * product_of : [T] -> lg<T,M>
+ *
+ * Maps a sequence of positive values of type T to the log-domain and
+ * takes their product, i.e.,
+ *     product_of(x1,...,xn) := lg<T,M>(x1) * ... * lg<T,M>(xn),
+ * without materializing the intermediate sequence of lg<T,M>. The
+ * values are mapped a block at a time with the batch M::log.
+ */
+template <typename M = std_math, typename T>
+auto product_of(std::span<T const> xs)
+{
+    T buf[lg_batch_detail::block];
+    T s = T(0);
+    for (std::size_t i = 0; i < xs.size(); i += lg_batch_detail::block)
+    {
+        auto const m = std::min(lg_batch_detail::block, xs.size() - i);
+        M::log(xs.data() + i, buf, m);
+        s = s + simd::sum(buf, m);
+    }
+    return lg<T,M>::from_log(s);
+}
+
+/**
+ * from_integers : ([U], [lg<T,M>]) -> void
+ *
+ * ys[i] := lg<T,M>::from_integer(xs[i]), e.g., for counts, whose logs
+ * come from their bit widths rather than M::log (see ilog2.hpp).
+ */
+template <typename U, typename T, typename M>
+void from_integers(std::span<U const> xs, std::span<lg<T,M>> ys)
+{
+    assert(xs.size() == ys.size());
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        ys[i] = lg<T,M>::from_integer(xs[i]);
+}
+
+/**
+ * to_source : ([lg<T,M>], [T]) -> void
+ *
+ * ys[i] := T(xs[i]), i.e., M::exp of the exponents, with the batch M::exp
+ * rather than a call per value. Values out of the range of T convert to
+ * whatever M::exp gives, e.g., inf or 0; to_source in safe_batch.hpp
+ * also flags them.
+ */
+template <typename T, typename M>
+void to_source(std::span<lg<T,M> const> xs, std::span<T> ys)
+{
+    assert(xs.size() == ys.size());
+    M::exp(lg_batch_detail::exponents(xs), ys.data(), xs.size());
+}
+
+/**
+ * maximum : [lg<T>] -> lg<T>
+ *
+ * The largest element of a non-empty sequence of lg<T>. Since the
+ * order on lg<T> is the order on the exponents, this is a max-reduction
+ * over the exponents.
+ */
+template <typename T, typename M>
+auto maximum(std::span<lg<T,M> const> xs)
+{
+    assert(!xs.empty());
+    return lg<T,M>::from_log(simd::hmax(lg_batch_detail::exponents(xs), xs.size()));
+}
+
+/**
+ * minimum : [lg<T>] -> lg<T>
+ *
+ * The smallest element of a non-empty sequence of lg<T>.
+ */
+template <typename T, typename M>
+auto minimum(std::span<lg<T,M> const> xs)
+{
+    assert(!xs.empty());
+    return lg<T,M>::from_log(simd::hmin(lg_batch_detail::exponents(xs), xs.size()));
+}
+
+// The overloads below accept any contiguous range, e.g., std::vector<lg<T>>,
+// since a span<lg<T,M> const> parameter is not deduced from one.
+
+template <std::ranges::contiguous_range R>
+auto product(R const & xs) { return product(std::span<std::ranges::range_value_t<R> const>(xs)); }
+
+template <typename M = std_math, std::ranges::contiguous_range R>
+auto product_of(R const & xs) { return product_of<M>(std::span<std::ranges::range_value_t<R> const>(xs)); }
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S>
+void to_source(R const & xs, S & ys)
+{
+    to_source(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys));
+}
+
+template <std::ranges::contiguous_range R>
+auto maximum(R const & xs) { return maximum(std::span<std::ranges::range_value_t<R> const>(xs)); }
+
+template <std::ranges::contiguous_range R>
+auto minimum(R const & xs) { return minimum(std::span<std::ranges::range_value_t<R> const>(xs)); }
@@ -0,0 +1,212 @@
+/**
+ * Expression templates that extend the computational basis of lg<T,M>
+ * with
+ *     + : (L,R) -> sum_expr<L,R>
+ * and, when either operand is an expression,
+ *     * : (L,R) -> product_expr<L,R>,
+ * where L and R are lg<T,M> or expressions over lg<T,M>.
+ *
+ * Nothing is computed until an expression is converted to lg<T,M> (or
+ * to T). At that point, nested sums are flattened into a single sum of
+ * terms
+ *     x1 + ... + xn,
+ * which, in the log-domain, is evaluated in one pass as the max-shifted
+ * log-sum-exp
+ *     m + log(exp(k1 - m) + ... + exp(kn - m)),  m := max(k1,...,kn),
+ * so no term is converted back to T and nothing overflows or underflows
+ * unless the result itself does.
+ *
+ * Terms that are equal are folded before the pass, i.e.,
+ *     x + ... + x (c times) = lg<T,M>(c) * x,
+ * so, e.g., x + x + x is exactly lg<T,M>(3) * x.
+ *
+ * Products of lg<T,M> remain eager, since they are just additions of the
+ * exponents, so
+ *     lg<T,M> r = a*b + c*d + e;
+ * is the sum of the three terms a*b, c*d and e. A product with a sum as
+ * a factor, e.g., (a + b) * c, materializes the sum and adds the
+ * exponents.
+ *
+ * Expressions hold their operands by value, so they may outlive the
+ * values they are built from.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+template <typename L, typename R>
+struct sum_expr;
+
+template <typename L, typename R>
+struct product_expr;
+
+namespace lg_expr_detail
+{
+    template <typename E>
+    struct traits : std::false_type {};
+
+    template <typename T, typename M>
+    struct traits<lg<T,M>> : std::true_type
+    {
+        using result_type = lg<T,M>;
+        static constexpr std::size_t terms = 1;
+    };
+
+    template <typename L, typename R>
+    struct traits<sum_expr<L,R>> : std::true_type
+    {
+        using result_type = typename traits<L>::result_type;
+        static constexpr std::size_t terms = traits<L>::terms + traits<R>::terms;
+    };
+
+    template <typename L, typename R>
+    struct traits<product_expr<L,R>> : std::true_type
+    {
+        using result_type = typename traits<L>::result_type;
+        static constexpr std::size_t terms = 1;
+    };
+
+    template <typename E>
+    concept operand = traits<E>::value;
+
+    template <typename E>
+    concept expression = operand<E> && !std::is_same_v<E, typename traits<E>::result_type>;
+
+    template <typename L, typename R>
+    concept compatible = operand<L> && operand<R> &&
+        std::is_same_v<typename traits<L>::result_type, typename traits<R>::result_type>;
+
+    template <operand E>
+    auto eval(E const & x)
+    {
+        if constexpr (expression<E>)
+            return x.eval();
+        else
+            return x;
+    }
+
+    // writes the exponents of the terms of a sum to out.
+    template <typename T, typename M>
+    T * flatten(lg<T,M> const & x, T * out)
+    {
+        *out = x.k;
+        return out + 1;
+    }
+
+    template <typename L, typename R, typename T>
+    T * flatten(product_expr<L,R> const & x, T * out)
+    {
+        *out = x.eval().k;
+        return out + 1;
+    }
+
+    template <typename L, typename R, typename T>
+    T * flatten(sum_expr<L,R> const & x, T * out)
+    {
+        return flatten(x.r, flatten(x.l, out));
+    }
+
+    /**
+     * The log-sum-exp of N exponents, with equal exponents folded into a
+     * single term with a multiplicity.
+     */
+    template <typename M, typename T, std::size_t N>
+    T log_sum_exp(std::array<T,N> k)
+    {
+        std::array<T,N> c;
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            std::size_t j = 0;
+            while (j < n && !(k[j] == k[i]))
+                ++j;
+            if (j == n)
+            {
+                k[n] = k[i];
+                c[n++] = T(1);
+            }
+            else
+                c[j] = c[j] + T(1);
+        }
+
+        T m = k[0];
+        for (std::size_t i = 1; i < n; ++i)
+            m = m < k[i] ? k[i] : m;
+
+        // every term is 0 or some term is infinite.
+        if (m == -numeric_limits<T>::infinity() || m == numeric_limits<T>::infinity())
+            return m;
+
+        T s = T(0);
+        for (std::size_t i = 0; i < n; ++i)
+            s = s + c[i] * M::exp(k[i] - m);
+        return m + M::log(s);
+    }
+}
+
+template <typename L, typename R>
+struct sum_expr
+{
+    using result_type = typename lg_expr_detail::traits<L>::result_type;
+
+    L l;
+    R r;
+
+    auto eval() const
+    {
+        using T = typename result_type::value_type;
+        using M = typename result_type::math;
+
+        std::array<T, lg_expr_detail::traits<sum_expr>::terms> k;
+        lg_expr_detail::flatten(*this, k.data());
+        return result_type::from_log(lg_expr_detail::log_sum_exp<M>(k));
+    }
+
+    operator result_type() const { return eval(); }
+    explicit operator typename result_type::value_type() const { return eval(); }
+};
+
+template <typename L, typename R>
+struct product_expr
+{
+    using result_type = typename lg_expr_detail::traits<L>::result_type;
+
+    L l;
+    R r;
+
+    auto eval() const { return result_type::from_log(lg_expr_detail::eval(l).k + lg_expr_detail::eval(r).k); }
+
+    operator result_type() const { return eval(); }
+    explicit operator typename result_type::value_type() const { return eval(); }
+};
+
+/**
+ * eval : E -> lg<T,M>
+ *
+ * Materializes an expression over lg<T,M>.
+ */
+template <lg_expr_detail::expression E>
+auto eval(E const & x) { return x.eval(); }
+
+template <typename L, typename R>
+    requires lg_expr_detail::compatible<L,R>
+auto operator+(L const & l, R const & r) { return sum_expr<L,R>{l, r}; }
+
+template <typename L, typename R>
+    requires lg_expr_detail::compatible<L,R> &&
+        (lg_expr_detail::expression<L> || lg_expr_detail::expression<R>)
+auto operator*(L const & l, R const & r) { return product_expr<L,R>{l, r}; }
+
+template <typename L, typename R>
+    requires lg_expr_detail::compatible<L,R> &&
+        (lg_expr_detail::expression<L> || lg_expr_detail::expression<R>)
+auto operator/(L const & l, R const & r)
+{
+    return product_expr<L, typename lg_expr_detail::traits<L>::result_type>{l, inv(lg_expr_detail::eval(r))};
+}
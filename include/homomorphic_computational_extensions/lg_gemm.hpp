@@ -0,0 +1,186 @@
+/**
+ * Matrix multiplication over lg<T,M>, i.e.,
+ *     C := A B,  C[i][j] = A[i][0] B[0][j] + ... + A[i][p-1] B[p-1][j],
+ * where the products are in the computational basis of lg<T,M> and the
+ * sums are the sums of lg<T,M>, so in the log-domain
+ *     C[i][j].k = log(exp(A[i][0].k + B[0][j].k) + ... ),
+ * which is the inner kernel of, e.g., the forward algorithm of an HMM.
+ *
+ * Rather than n*m*p exps and n*m logs, the row maxima a[i] of A and
+ * the column maxima b[j] of B are factored out,
+ *     C[i][j].k = a[i] + b[j] + log(sum_r exp(A[i][r].k - a[i]) exp(B[r][j].k - b[j])),
+ * so A and B are each mapped out of the log-domain once, into matrices
+ * with values in [0,1], and the sums are an ordinary matrix product of
+ * those, which is computed with a cache-blocked, register-blocked
+ * kernel on simd::pack. That is n*p + p*m exps and n*m logs.
+ *
+ * The factored form may underflow if, for some (i,j), the maxima of
+ * row i of A and of column j of B are at different r and no r has
+ * values near both. If the sum is below sqrt(numeric_limits<T>::min()),
+ * where the terms that underflowed may matter, C[i][j] is recomputed
+ * directly with its own maximum.
+ *
+ * Matrices are row-major buffers, e.g., A[i][r] is a[i*p + r]. The rows
+ * of C are split into panels that run on a thread_pool. Each value of
+ * C is summed in the same order whatever the number of threads, so the
+ * result does not depend on it.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "log_exp_sum.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace lg_gemm_detail
+{
+    // rows of C per register block.
+    inline constexpr std::size_t mr = 4;
+    // rows of C per task.
+    inline constexpr std::size_t mc = 64;
+    // columns of C and rows of B per cache block.
+    inline constexpr std::size_t nc = 256;
+    inline constexpr std::size_t kc = 128;
+
+    inline std::size_t round_up(std::size_t n, std::size_t r) { return (n + r - 1) / r * r; }
+
+    /**
+     * c[0..mr)[0..2w) += a[0..mr)[k0..k1) b[k0..k1)[0..2w), where w is the
+     * width of the pack, with the block of c held in registers.
+     */
+    template <typename T>
+    void kernel(T const * a, std::size_t lda, T const * b, std::size_t ldb, T * c, std::size_t ldc, std::size_t kn)
+    {
+        using P = simd::pack<T>;
+        constexpr auto w = P::width;
+        static_assert(mr == 4);
+
+        P c00 = P::load(c), c01 = P::load(c + w);
+        P c10 = P::load(c + ldc), c11 = P::load(c + ldc + w);
+        P c20 = P::load(c + 2 * ldc), c21 = P::load(c + 2 * ldc + w);
+        P c30 = P::load(c + 3 * ldc), c31 = P::load(c + 3 * ldc + w);
+        for (std::size_t r = 0; r < kn; ++r)
+        {
+            auto const b0 = P::load(b + r * ldb), b1 = P::load(b + r * ldb + w);
+            auto a0 = P::broadcast(a[r]);
+            c00 = c00 + a0 * b0;
+            c01 = c01 + a0 * b1;
+            a0 = P::broadcast(a[lda + r]);
+            c10 = c10 + a0 * b0;
+            c11 = c11 + a0 * b1;
+            a0 = P::broadcast(a[2 * lda + r]);
+            c20 = c20 + a0 * b0;
+            c21 = c21 + a0 * b1;
+            a0 = P::broadcast(a[3 * lda + r]);
+            c30 = c30 + a0 * b0;
+            c31 = c31 + a0 * b1;
+        }
+        c00.store(c); c01.store(c + w);
+        c10.store(c + ldc); c11.store(c + ldc + w);
+        c20.store(c + 2 * ldc); c21.store(c + 2 * ldc + w);
+        c30.store(c + 3 * ldc); c31.store(c + 3 * ldc + w);
+    }
+
+    // the shift for a maximum, which is 0 if the maximum is infinite.
+    template <typename T>
+    T shift(T m) { return m == -numeric_limits<T>::infinity() || m == numeric_limits<T>::infinity() ? T(0) : m; }
+}
+
+/**
+ * matmul : ([lg<T,M>], [lg<T,M>], [lg<T,M>], n, p, m, pool) -> void
+ *
+ * c := a b, where a is n x p, b is p x m and c is n x m, all row-major.
+ * c must not alias a or b.
+ */
+template <typename T, typename M>
+void matmul(std::span<lg<T,M> const> a, std::span<lg<T,M> const> b, std::span<lg<T,M>> c,
+    std::size_t n, std::size_t p, std::size_t m, thread_pool & pool)
+{
+    using namespace lg_gemm_detail;
+    using P = simd::pack<T>;
+    assert(a.size() == n * p && b.size() == p * m && c.size() == n * m);
+
+    // the exp-mapped matrices are padded with zeros to whole blocks.
+    auto const np = round_up(std::max<std::size_t>(n, 1), mr);
+    auto const mp = round_up(std::max<std::size_t>(m, 1), 2 * P::width);
+    std::vector<T> ea(np * p, T(0)), eb(p * mp, T(0)), s(np * mp, T(0));
+    std::vector<T> sa(n, T(0)), sb(m, -numeric_limits<T>::infinity());
+
+    // the column maxima of b.
+    for (std::size_t r = 0; r < p; ++r)
+        for (std::size_t j = 0; j < m; ++j)
+            sb[j] = sb[j] < b[r * m + j].k ? b[r * m + j].k : sb[j];
+    for (auto & x : sb)
+        x = shift(x);
+
+    pool.parallel_for(p, [&](std::size_t r)
+    {
+        auto const e = eb.data() + r * mp;
+        for (std::size_t j = 0; j < m; ++j)
+            e[j] = b[r * m + j].k - sb[j];
+        M::exp(e, e, m);
+    });
+
+    pool.parallel_for(n, [&](std::size_t i)
+    {
+        auto const e = ea.data() + i * p;
+        if (p == 0)
+            return;
+        for (std::size_t r = 0; r < p; ++r)
+            e[r] = a[i * p + r].k;
+        sa[i] = shift(simd::hmax(e, p));
+        for (std::size_t r = 0; r < p; ++r)
+            e[r] = e[r] - sa[i];
+        M::exp(e, e, p);
+    });
+
+    pool.parallel_for(np / mc + (np % mc != 0), [&](std::size_t t)
+    {
+        auto const i0 = t * mc, i1 = std::min(np, i0 + mc);
+        for (std::size_t j0 = 0; j0 < mp; j0 += nc)
+        {
+            auto const j1 = std::min(mp, j0 + nc);
+            for (std::size_t r0 = 0; r0 < p; r0 += kc)
+            {
+                auto const kn = std::min(p - r0, kc);
+                for (std::size_t i = i0; i < i1; i += mr)
+                    for (std::size_t j = j0; j < j1; j += 2 * P::width)
+                        kernel(ea.data() + i * p + r0, p, eb.data() + r0 * mp + j, mp, s.data() + i * mp + j, mp, kn);
+            }
+        }
+
+        // back to the log-domain, a row at a time.
+        using std::sqrt;
+        static T const tiny = sqrt(numeric_limits<T>::min());
+        std::vector<char> direct(m);
+        for (std::size_t i = i0; i < std::min(n, i1); ++i)
+        {
+            auto const si = s.data() + i * mp;
+            for (std::size_t j = 0; j < m; ++j)
+                direct[j] = si[j] < tiny;
+            M::log(si, si, m);
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                if (direct[j])
+                {
+                    // terms may have underflowed, so sum them with their own maximum.
+                    log_exp_sum<T,M> acc;
+                    for (std::size_t r = 0; r < p; ++r)
+                        acc += a[i * p + r] * b[r * m + j];
+                    c[i * m + j] = acc.value();
+                }
+                else
+                    c[i * m + j] = lg<T,M>::from_log(sa[i] + sb[j] + si[j]);
+            }
+        }
+    });
+}
@@ -0,0 +1,276 @@
+/**
+ * lg_q<U,N,D,Z> is a quantized lg<T>: the exponent k is stored as an
+ * unsigned 8 or 16-bit code
+ *     q := round(k * N/D) + Z,
+ * i.e., as the fixed-point number of scaled<T,N,D> (N/D codes per unit
+ * of exponent) shifted by the zero point Z, the code of k = 0. The code
+ * 0 is reserved for the value 0 (k = -inf). By default, Z is the
+ * largest code, so the values are the probabilities
+ *     exp(k),  k in [(1 - Z) D/N, 0],
+ * e.g., lg_q<std::uint16_t,1024> covers [e^-64, 1] in 2 bytes rather
+ * than the 8 of lg<double>, and lg_q<std::uint8_t,4> covers [e^-63.5, 1]
+ * in 1 byte.
+ *
+ * Products and quotients are integer additions and subtractions of the
+ * codes, which saturate: a result above the largest code is the largest
+ * code, and one below code 1 is 0, just as a product of floats that
+ * underflows is 0.
+ *
+ * Error bounds:
+ *
+ *     - Quantizing rounds k to the nearest multiple of D/N, so a value in
+ *       range is stored with |k - k'| <= D/(2N), i.e., with a relative
+ *       error of at most exp(D/(2N)) - 1 ~ D/(2N): 4.9e-4 for
+ *       lg_q<std::uint16_t,1024> and 0.13 for lg_q<std::uint8_t,4>. A
+ *       value below the smallest one is 0, and one above the largest is
+ *       the largest. The code is computed in T, so from lg<float> the
+ *       bound grows by the rounding of k * N/D + Z, at most 2^-8 of a
+ *       code for 16-bit codes.
+ *
+ *     - Products and quotients of codes are exact, unless they saturate,
+ *       so the exponent of a product of n quantized values is within
+ *       n D/(2N) of the exact sum of their exponents, and typically
+ *       within sqrt(n/12) D/N.
+ *
+ *     - Dequantizing computes (q - Z) * D/N, where q - Z is exact in
+ *       float, so it is exact when N/D is a power of two (see scaled.hpp)
+ *       and otherwise within half an ulp of the exponent.
+ *
+ * The batch forms quantize and dequantize convert a pack of codes at a
+ * time with simd::pack<T>::widen and narrow, e.g., 16 codes per AVX-512
+ * register, and multiply is a loop of integer additions and clamps,
+ * which the compiler vectorizes. A table of lg_q is a 4-8x smaller
+ * working set than the same table of lg<T>, which is typically the
+ * difference between fitting in L2/L3 and missing it.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "scaled.hpp"
+#include "simd.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+template <typename U, int N, int D = 1, int Z = int(std::numeric_limits<U>::max())>
+struct lg_q
+{
+    static_assert(std::is_unsigned_v<U> && sizeof(U) <= 2, "codes are 8 or 16-bit unsigned integers");
+    static_assert(N > 0 && D > 0 && 0 < Z && Z <= int(std::numeric_limits<U>::max()));
+
+    using code_type = U;
+
+    // the largest code and the zero point.
+    static constexpr int max_code = int(std::numeric_limits<U>::max());
+    static constexpr int zero_point = Z;
+
+    U q;
+
+    // by default, constructs the multiplicative identity, the code Z.
+    constexpr lg_q() : q(U(Z)) {}
+
+    // quantizes x, with saturation.
+    template <typename T, typename M>
+    explicit lg_q(lg<T,M> const & x) : q(quantize(x.k)) {}
+
+    // constructs the value with code q, i.e., q is stored as is.
+    static constexpr lg_q from_code(U q) { return lg_q(q, raw{}); }
+
+    // the code of exponent k, rounded to nearest and saturated. k is not NaN.
+    template <typename T>
+    static U quantize(T const & k)
+    {
+        auto c = scaled_detail::times_scale<T,N,D>(k) + T(Z);
+        c = c < T(0) ? T(0) : (c < T(max_code) ? c : T(max_code));
+        return U(c + T(0.5));
+    }
+
+    // the exponent of code q, -inf for q = 0.
+    template <typename T = float>
+    static T exponent(U q)
+    {
+        return q == 0 ? -numeric_limits<T>::infinity() : scaled_detail::div_scale<T,N,D>(T(q) - T(Z));
+    }
+
+    // dequantizes to lg<T,M>.
+    template <typename T = float, typename M = std_math>
+    lg<T,M> to_lg() const { return lg<T,M>::from_log(exponent<T>(q)); }
+
+    template <typename T, typename M>
+    explicit operator lg<T,M>() const { return to_lg<T,M>(); }
+
+private:
+    struct raw {};
+    constexpr lg_q(U q, raw) : q(q) {}
+};
+
+namespace lg_q_detail
+{
+    // scaled_detail::times_scale and div_scale, for a pack of T.
+    template <typename T, int N, int D, typename P>
+    P times_scale(P const & x)
+    {
+        if constexpr (scaled_detail::power_of_two<N,D>)
+            return x * P::broadcast(scaled_detail::exp2<T>(scaled_detail::exponent<N,D>));
+        else
+            return x * P::broadcast(T(N) / T(D));
+    }
+
+    template <typename T, int N, int D, typename P>
+    P div_scale(P const & x)
+    {
+        if constexpr (scaled_detail::power_of_two<N,D>)
+            return x * P::broadcast(scaled_detail::exp2<T>(-scaled_detail::exponent<N,D>));
+        else
+            return x / P::broadcast(T(N) / T(D));
+    }
+
+    // a + b - Z, saturated, with 0 absorbing.
+    template <int Z, int Max>
+    constexpr int multiply(int a, int b)
+    {
+        auto const r = a + b - Z;
+        auto const s = r < 1 ? 0 : (r < Max ? r : Max);
+        return a == 0 || b == 0 ? 0 : s;
+    }
+
+    // a - b + Z, saturated, with 0 / b = 0 and a / 0 the largest code.
+    template <int Z, int Max>
+    constexpr int divide(int a, int b)
+    {
+        auto const r = a - b + Z;
+        auto const s = r < 1 ? 0 : (r < Max ? r : Max);
+        return a == 0 ? 0 : (b == 0 ? Max : s);
+    }
+}
+
+template <typename U, int N, int D, int Z>
+auto operator*(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y)
+{
+    using Q = lg_q<U,N,D,Z>;
+    return Q::from_code(U(lg_q_detail::multiply<Z, Q::max_code>(x.q, y.q)));
+}
+
+template <typename U, int N, int D, int Z>
+auto operator/(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y)
+{
+    using Q = lg_q<U,N,D,Z>;
+    return Q::from_code(U(lg_q_detail::divide<Z, Q::max_code>(x.q, y.q)));
+}
+
+// the codes are in the order of the values.
+
+template <typename U, int N, int D, int Z>
+auto operator<(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y) { return x.q < y.q; }
+
+template <typename U, int N, int D, int Z>
+auto operator<=(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y) { return x.q <= y.q; }
+
+template <typename U, int N, int D, int Z>
+auto operator==(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y) { return x.q == y.q; }
+
+template <typename U, int N, int D, int Z>
+auto operator!=(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y) { return x.q != y.q; }
+
+template <typename U, int N, int D, int Z>
+auto operator>(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y) { return x.q > y.q; }
+
+template <typename U, int N, int D, int Z>
+auto operator>=(lg_q<U,N,D,Z> const & x, lg_q<U,N,D,Z> const & y) { return x.q >= y.q; }
+
+/**
+ * quantize : ([lg<T,M>], [lg_q<U,N,D,Z>]) -> void
+ *
+ * ys[i] := lg_q<U,N,D,Z>(xs[i]), simd::pack<T>::width values at a time,
+ * as the scaled exponents clamped to [0, max_code] and truncated to U
+ * after adding 1/2 (see simd::narrow).
+ */
+template <typename T, typename M, typename U, int N, int D, int Z>
+void quantize(std::span<lg<T,M> const> xs, std::span<lg_q<U,N,D,Z>> ys)
+{
+    using Q = lg_q<U,N,D,Z>;
+    using P = simd::pack<T>;
+    constexpr auto w = P::width;
+    static_assert(sizeof(Q) == sizeof(U) && sizeof(lg<T,M>) == sizeof(T));
+    assert(xs.size() == ys.size());
+
+    auto const k = reinterpret_cast<T const *>(xs.data());
+    auto const q = reinterpret_cast<U *>(ys.data());
+    auto const z = P::broadcast(T(Z)), lo = P::broadcast(T(0)), hi = P::broadcast(T(Q::max_code)), half = P::broadcast(T(0.5));
+
+    std::size_t i = 0;
+    for (; i + w <= xs.size(); i += w)
+    {
+        auto const c = lg_q_detail::times_scale<T,N,D>(P::load(k + i)) + z;
+        (min(max(c, lo), hi) + half).narrow(q + i);
+    }
+    for (; i < xs.size(); ++i)
+        q[i] = Q::quantize(k[i]);
+}
+
+/**
+ * dequantize : ([lg_q<U,N,D,Z>], [lg<T,M>]) -> void
+ *
+ * ys[i] := lg<T,M>(xs[i]), simd::pack<T>::width values at a time, e.g.,
+ * 16 codes per AVX-512 register for lg<float>.
+ */
+template <typename U, int N, int D, int Z, typename T, typename M>
+void dequantize(std::span<lg_q<U,N,D,Z> const> xs, std::span<lg<T,M>> ys)
+{
+    using Q = lg_q<U,N,D,Z>;
+    using P = simd::pack<T>;
+    constexpr auto w = P::width;
+    static_assert(sizeof(Q) == sizeof(U) && sizeof(lg<T,M>) == sizeof(T));
+    assert(xs.size() == ys.size());
+
+    auto const q = reinterpret_cast<U const *>(xs.data());
+    auto const k = reinterpret_cast<T *>(ys.data());
+    auto const z = P::broadcast(T(Z)), zero = P::broadcast(T(0)), ninf = P::broadcast(-numeric_limits<T>::infinity());
+
+    std::size_t i = 0;
+    for (; i + w <= xs.size(); i += w)
+    {
+        auto const c = P::widen(q + i);
+        select(c == zero, ninf, lg_q_detail::div_scale<T,N,D>(c - z)).store(k + i);
+    }
+    for (; i < xs.size(); ++i)
+        k[i] = Q::template exponent<T>(q[i]);
+}
+
+/**
+ * multiply : ([lg_q<U,N,D,Z>], [lg_q<U,N,D,Z>], [lg_q<U,N,D,Z>]) -> void
+ *
+ * zs[i] := xs[i] * ys[i].
+ */
+template <typename U, int N, int D, int Z>
+void multiply(std::span<lg_q<U,N,D,Z> const> xs, std::span<lg_q<U,N,D,Z> const> ys, std::span<lg_q<U,N,D,Z>> zs)
+{
+    using Q = lg_q<U,N,D,Z>;
+    assert(xs.size() == ys.size() && xs.size() == zs.size());
+
+    auto const a = reinterpret_cast<U const *>(xs.data());
+    auto const b = reinterpret_cast<U const *>(ys.data());
+    auto const c = reinterpret_cast<U *>(zs.data());
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        c[i] = U(lg_q_detail::multiply<Z, Q::max_code>(a[i], b[i]));
+}
+
+// The overloads below accept any contiguous ranges, e.g., std::vector<lg_q<...>>.
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S>
+void quantize(R const & xs, S & ys)
+{
+    quantize(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys));
+}
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S>
+void dequantize(R const & xs, S & ys)
+{
+    dequantize(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys));
+}
@@ -0,0 +1,433 @@
+/**
+ * Prefix products and prefix sums over contiguous sequences of lg<T,M>,
+ * e.g., the running likelihood of a sequential sample or the survival
+ * curve of a sequence of hazards, i.e.,
+ *     inclusive_product : ys[i] := x[0] * ... * x[i]
+ *     exclusive_product : ys[i] := x[0] * ... * x[i-1]
+ *     inclusive_sum     : ys[i] := x[0] + ... + x[i]
+ *     exclusive_sum     : ys[i] := x[0] + ... + x[i-1],
+ * where the empty product is 1 and the empty sum is 0.
+ *
+ * A prefix product is the prefix sum of the exponents, which simd::scan
+ * computes a pack at a time in registers.
+ *
+ * A prefix sum, in the log-domain, is the prefix log-sum-exp of the
+ * exponents. Rather than rescaling a running sum at every new maximum,
+ * as log_exp_sum does, a block of exponents is shifted by a reference
+ * R, the larger of the block maximum and the running maximum, and
+ *     ys[i] = R + log(s + exp(x[0] - R) + ... + exp(x[i] - R))
+ * is computed with the batch M::exp, simd::scan and the batch M::log,
+ * where s is the running sum relative to R. A block whose earliest
+ * exponents are so far below R that their exps would underflow is
+ * instead scanned one value at a time.
+ *
+ * With compensated = true, the running total is carried as a
+ * neumaier<T> (see neumaier.hpp), so the error of ys[i] does not grow
+ * with i, at about twice the cost. The prefix products of a sequence of
+ * lg<neumaier<T>,M> are compensated anyway. Prefix sums need a floating
+ * point T, since the log-sum-exp takes M::exp and M::log of T and shifts
+ * by infinite maxima, so for lg<neumaier<T>,M> they do not compile.
+ *
+ * The overloads taking a thread_pool use a blocked two-pass scan: the
+ * sequence is split into chunks of a fixed size, the first pass reduces
+ * each chunk in parallel, the totals are scanned, and the second pass
+ * scans each chunk in parallel from its carry. Like likelihood, the
+ * result does not depend on the number of threads, but it differs from
+ * the one-thread scan by the order of the additions.
+ *
+ * ys may be the same sequence as xs.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "log_exp_sum.hpp"
+#include "neumaier.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lg_scan_detail
+{
+    // values scanned at a time, e.g., by the batch M::exp and M::log.
+    inline constexpr std::size_t block = 256;
+
+    template <typename T, typename M>
+    T * exponents(std::span<lg<T,M>> xs)
+    {
+        static_assert(sizeof(lg<T,M>) == sizeof(T));
+        return reinterpret_cast<T *>(xs.data());
+    }
+
+    template <typename T, typename M>
+    T const * exponents(std::span<lg<T,M> const> xs)
+    {
+        static_assert(sizeof(lg<T,M>) == sizeof(T));
+        return reinterpret_cast<T const *>(xs.data());
+    }
+
+    // simd::scan with the carry and the last lane of each pack summed by
+    // two-sum, so c is the compensated total. Each y[i] is rounded once,
+    // as c.s + (p[i] + c.c).
+    template <typename T>
+    neumaier<T> compensated_scan(T const * x, T * y, std::size_t n, neumaier<T> c)
+    {
+        using P = simd::pack<T>;
+        constexpr auto w = P::width;
+
+        auto s = P::broadcast(c.s), e = P::broadcast(c.c);
+        std::size_t i = 0;
+        for (; i + w <= n; i += w)
+        {
+            auto const p = P::load(x + i).prefix();
+            (s + (p + e)).store(y + i);
+            neumaier_detail::add(s, e, P::broadcast(p.last()));
+        }
+
+        c = neumaier<T>(s.last(), e.last());
+        for (; i < n; ++i)
+        {
+            c += x[i];
+            y[i] = c.value();
+        }
+        return c;
+    }
+
+    // the carry of a prefix product, C = T or neumaier<T>.
+    template <typename T, typename C>
+    struct product_scan
+    {
+        C c;
+
+        T value() const
+        {
+            if constexpr (std::is_same_v<C, T>)
+                return c;
+            else
+                return c.value();
+        }
+
+        void operator()(T const * x, T * y, std::size_t n)
+        {
+            if constexpr (std::is_same_v<C, T>)
+                c = simd::scan(x, y, n, c);
+            else
+                c = compensated_scan(x, y, n, c);
+        }
+    };
+
+    // the carry of a prefix log-sum-exp, exp(m) s, with C = T or neumaier<T>.
+    template <typename T, typename M, typename C>
+    struct sum_scan
+    {
+        T m = -std::numeric_limits<T>::infinity();
+        C s = C(T(0));
+
+        static T get(C const & s)
+        {
+            if constexpr (std::is_same_v<C, T>)
+                return s;
+            else
+                return s.value();
+        }
+
+        bool finite() const { return m != -std::numeric_limits<T>::infinity() && m != std::numeric_limits<T>::infinity(); }
+
+        T value() const { return finite() ? m + M::log(get(s)) : m; }
+
+        void operator()(T const * x, T * y, std::size_t n)
+        {
+            using std::log;
+            using std::max;
+            if (n == 0)
+                return;
+
+            // exps of exponents within half the normal range of R of the
+            // first prefix maximum do not underflow.
+            static T const range = T(-0.5) * log(std::numeric_limits<T>::min());
+            auto const r = max(m, simd::hmax(x, n));
+            if (r - max(m, x[0]) > range || r == std::numeric_limits<T>::infinity() || r == -std::numeric_limits<T>::infinity())
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    add(x[i]);
+                    y[i] = value();
+                }
+                return;
+            }
+
+            T buf[block];
+            for (std::size_t i = 0; i < n; ++i)
+                buf[i] = x[i] - r;
+            M::exp(buf, buf, n);
+            C t = s * C(M::exp(m - r));
+            if constexpr (std::is_same_v<C, T>)
+                t = simd::scan(buf, buf, n, t);
+            else
+                t = compensated_scan(buf, buf, n, t);
+            M::log(buf, buf, n);
+            for (std::size_t i = 0; i < n; ++i)
+                y[i] = r + buf[i];
+            m = r;
+            s = t;
+        }
+
+        void add(T const & k)
+        {
+            if (m < k)
+            {
+                s = s * C(M::exp(m - k)) + C(T(1));
+                m = k;
+            }
+            else if (k != -std::numeric_limits<T>::infinity() && m != std::numeric_limits<T>::infinity())
+                s = s + C(M::exp(k - m));
+        }
+    };
+
+    // scans n values a block at a time; exclusive scans write the carry
+    // before each value, from a copy of the block so that y may be x.
+    template <typename S, typename T>
+    void run(S & scan, T const * x, T * y, std::size_t n, bool exclusive)
+    {
+        T buf[block];
+        for (std::size_t j = 0; j < n; j += block)
+        {
+            auto const b = std::min(block, n - j);
+            if (!exclusive)
+            {
+                scan(x + j, y + j, b);
+                continue;
+            }
+            std::copy(x + j, x + j + b, buf);
+            y[j] = scan.value();
+            scan(buf, buf, b);
+            std::copy(buf, buf + b - 1, y + j + 1);
+        }
+    }
+
+    template <typename T, typename M>
+    void product(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, bool compensated, bool exclusive)
+    {
+        assert(xs.size() == ys.size());
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (compensated)
+            {
+                product_scan<T, neumaier<T>> scan{neumaier<T>()};
+                return run(scan, exponents(xs), exponents(ys), xs.size(), exclusive);
+            }
+        }
+        product_scan<T, T> scan{T(0)};
+        run(scan, exponents(xs), exponents(ys), xs.size(), exclusive);
+    }
+
+    template <typename T, typename M>
+    void sum(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, bool compensated, bool exclusive)
+    {
+        static_assert(std::is_floating_point_v<T>, "prefix sums of lg<T,M> require a floating point T");
+        assert(xs.size() == ys.size());
+        if (compensated)
+        {
+            sum_scan<T, M, neumaier<T>> scan;
+            return run(scan, exponents(xs), exponents(ys), xs.size(), exclusive);
+        }
+        sum_scan<T, M, T> scan;
+        run(scan, exponents(xs), exponents(ys), xs.size(), exclusive);
+    }
+
+    template <typename T, typename M>
+    void product(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, thread_pool & pool,
+        bool compensated, bool exclusive, std::size_t chunk)
+    {
+        assert(xs.size() == ys.size());
+        chunk = std::max<std::size_t>(chunk, 1);
+        auto const n = xs.size();
+        auto const x = exponents(xs);
+        auto const y = exponents(ys);
+
+        // the totals of the chunks, then their exclusive prefix sums, which
+        // are compensated whenever T is a floating point type, since there
+        // are few of them.
+        using C = std::conditional_t<std::is_floating_point_v<T>, neumaier<T>, T>;
+        std::vector<C> carry((n + chunk - 1) / chunk);
+        pool.parallel_for(carry.size(), [&](std::size_t c)
+        {
+            auto const begin = c * chunk, m = std::min(n, begin + chunk) - begin;
+            if constexpr (std::is_floating_point_v<T>)
+                carry[c] = compensated ? neumaier_sum(x + begin, m) : C(simd::sum(x + begin, m));
+            else
+                carry[c] = simd::sum(x + begin, m);
+        });
+        C total{};
+        for (auto & c : carry)
+        {
+            auto const t = c;
+            c = total;
+            total += t;
+        }
+
+        pool.parallel_for(carry.size(), [&](std::size_t c)
+        {
+            auto const begin = c * chunk, m = std::min(n, begin + chunk) - begin;
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                if (compensated)
+                {
+                    product_scan<T, neumaier<T>> scan{carry[c]};
+                    return run(scan, x + begin, y + begin, m, exclusive);
+                }
+            }
+            product_scan<T, T> scan{T(carry[c])};
+            run(scan, x + begin, y + begin, m, exclusive);
+        });
+    }
+
+    template <typename T, typename M>
+    void sum(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, thread_pool & pool,
+        bool compensated, bool exclusive, std::size_t chunk)
+    {
+        static_assert(std::is_floating_point_v<T>, "prefix sums of lg<T,M> require a floating point T");
+        assert(xs.size() == ys.size());
+        chunk = std::max<std::size_t>(chunk, 1);
+        auto const n = xs.size();
+        auto const x = exponents(xs);
+        auto const y = exponents(ys);
+        std::vector<log_exp_sum<T,M>> carry((n + chunk - 1) / chunk);
+
+        pool.parallel_for(carry.size(), [&](std::size_t c)
+        {
+            auto const begin = c * chunk, m = std::min(n, begin + chunk) - begin;
+            carry[c] += xs.subspan(begin, m);
+        });
+        log_exp_sum<T,M> total;
+        for (auto & c : carry)
+        {
+            auto const t = c;
+            c = total;
+            total += t;
+        }
+
+        pool.parallel_for(carry.size(), [&](std::size_t c)
+        {
+            auto const begin = c * chunk, m = std::min(n, begin + chunk) - begin;
+            if (compensated)
+            {
+                sum_scan<T, M, neumaier<T>> scan{carry[c].m, neumaier<T>(carry[c].s)};
+                return run(scan, x + begin, y + begin, m, exclusive);
+            }
+            sum_scan<T, M, T> scan{carry[c].m, carry[c].s};
+            run(scan, x + begin, y + begin, m, exclusive);
+        });
+    }
+}
+
+/**
+ * inclusive_product : ([lg<T,M>], [lg<T,M>]) -> void
+ *
+ * ys[i] := xs[0] * ... * xs[i].
+ */
+template <typename T, typename M>
+void inclusive_product(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, bool compensated = false)
+{
+    lg_scan_detail::product(xs, ys, compensated, false);
+}
+
+/**
+ * exclusive_product : ([lg<T,M>], [lg<T,M>]) -> void
+ *
+ * ys[i] := xs[0] * ... * xs[i-1], so ys[0] = 1.
+ */
+template <typename T, typename M>
+void exclusive_product(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, bool compensated = false)
+{
+    lg_scan_detail::product(xs, ys, compensated, true);
+}
+
+/**
+ * inclusive_sum : ([lg<T,M>], [lg<T,M>]) -> void
+ *
+ * ys[i] := xs[0] + ... + xs[i].
+ */
+template <typename T, typename M>
+void inclusive_sum(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, bool compensated = false)
+{
+    lg_scan_detail::sum(xs, ys, compensated, false);
+}
+
+/**
+ * exclusive_sum : ([lg<T,M>], [lg<T,M>]) -> void
+ *
+ * ys[i] := xs[0] + ... + xs[i-1], so ys[0] = 0.
+ */
+template <typename T, typename M>
+void exclusive_sum(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, bool compensated = false)
+{
+    lg_scan_detail::sum(xs, ys, compensated, true);
+}
+
+// The two-pass scans on a thread_pool, over chunks of chunk values.
+
+template <typename T, typename M>
+void inclusive_product(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, thread_pool & pool,
+    bool compensated = false, std::size_t chunk = 1 << 16)
+{
+    lg_scan_detail::product(xs, ys, pool, compensated, false, chunk);
+}
+
+template <typename T, typename M>
+void exclusive_product(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, thread_pool & pool,
+    bool compensated = false, std::size_t chunk = 1 << 16)
+{
+    lg_scan_detail::product(xs, ys, pool, compensated, true, chunk);
+}
+
+template <typename T, typename M>
+void inclusive_sum(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, thread_pool & pool,
+    bool compensated = false, std::size_t chunk = 1 << 16)
+{
+    lg_scan_detail::sum(xs, ys, pool, compensated, false, chunk);
+}
+
+template <typename T, typename M>
+void exclusive_sum(std::span<lg<T,M> const> xs, std::span<lg<T,M>> ys, thread_pool & pool,
+    bool compensated = false, std::size_t chunk = 1 << 16)
+{
+    lg_scan_detail::sum(xs, ys, pool, compensated, true, chunk);
+}
+
+// The overloads below accept any contiguous ranges, e.g., std::vector<lg<T>>,
+// since a span<lg<T,M>> parameter is not deduced from one.
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S, typename... Args>
+void inclusive_product(R const & xs, S & ys, Args &&... args)
+{
+    inclusive_product(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys), std::forward<Args>(args)...);
+}
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S, typename... Args>
+void exclusive_product(R const & xs, S & ys, Args &&... args)
+{
+    exclusive_product(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys), std::forward<Args>(args)...);
+}
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S, typename... Args>
+void inclusive_sum(R const & xs, S & ys, Args &&... args)
+{
+    inclusive_sum(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys), std::forward<Args>(args)...);
+}
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range S, typename... Args>
+void exclusive_sum(R const & xs, S & ys, Args &&... args)
+{
+    exclusive_sum(std::span<std::ranges::range_value_t<R> const>(xs), std::span<std::ranges::range_value_t<S>>(ys), std::forward<Args>(args)...);
+}
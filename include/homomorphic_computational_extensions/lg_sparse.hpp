@@ -0,0 +1,476 @@
+/**
+ * Sparse containers of lg<T,M>, for vectors and matrices of probabilities
+ * that are mostly zero.
+ *
+ * Zero is not in the range of the constructor lg<T,M>(x), x > 0, but it
+ * is the value lg<T,M>::from_log(-inf), and it is the identity of the
+ * sums of lg<T,M> (log_exp_sum, lns_add, max), so a zero term can be
+ * skipped rather than summed. The containers store only the nonzeros,
+ * i.e., the values whose exponents are not -inf:
+ *
+ *     lg_sparse_vector<T,M>  the indices of the nonzeros, in increasing
+ *                            order, and their values
+ *     lg_sparse_matrix<T,M>  compressed sparse rows (CSR): the offset of
+ *                            each row, and the column index and the
+ *                            value of each nonzero, row by row
+ *
+ * Every index not stored is an explicit zero, e.g., operator[] returns
+ * lg<T,M>::from_log(-inf) for it. Indices are 32-bit, which halves the
+ * memory traffic of the index arrays, so a dimension is below 2^32. The
+ * values are an lg_vector, so the kernels of lg_batch.hpp and friends
+ * apply to values() as is, e.g., product(x.values()).
+ *
+ * Both are built from dense arrays of lg<T,M>, or of probabilities p >= 0
+ * of type T with from_values, whose nonzeros are mapped with the batch
+ * M::log. A matrix may be built on a thread_pool: the nonzeros of each
+ * row are counted in parallel, their offsets are a prefix sum of the
+ * counts, and then each row is filled in parallel, so the result does
+ * not depend on the number of threads.
+ *
+ * The kernels touch the nonzeros only, so they cost O(nnz) rather than
+ * O(n m):
+ *
+ *     dot      : (sparse, dense) -> lg<T,M>, the log-sum-exp of the
+ *                products of the nonzeros
+ *     sum      : sparse -> lg<T,M>, the log-sum-exp of the nonzeros
+ *     *        : (sparse, dense) -> sparse, elementwise, so the product
+ *                has the nonzeros of the sparse operand at most
+ *     matvec<S>: y := A x over a semiring S of lg<T,M>, e.g., lg_sum for
+ *                the log-sum-exp of each row, or lg_max
+ *     forward<S>: the forward recursion of an HMM with a sparse
+ *                transition matrix.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "lg_vector.hpp"
+#include "log_exp_sum.hpp"
+#include "semiring.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace lg_sparse_detail
+{
+    using index_type = std::uint32_t;
+
+    // products buffered at a time by dot.
+    inline constexpr std::size_t block = 256;
+
+    // rows per task of the parallel kernels.
+    inline constexpr std::size_t rows_per_task = 64;
+
+    template <typename T>
+    bool nonzero(T const & k) { return k != -numeric_limits<T>::infinity(); }
+
+    // f(i) for i in [0,n), on pool if there is one.
+    template <typename F>
+    void for_rows(std::size_t n, thread_pool * pool, F f)
+    {
+        if (!pool)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                f(i);
+            return;
+        }
+        auto const tasks = (n + rows_per_task - 1) / rows_per_task;
+        pool->parallel_for(tasks, [&](std::size_t t)
+        {
+            for (std::size_t i = t * rows_per_task; i < std::min(n, (t + 1) * rows_per_task); ++i)
+                f(i);
+        });
+    }
+
+    /**
+     * The log-sum-exp of v[j] + y[c[j]] for j in [0,n), a block at a time
+     * with the batch M::exp of log_exp_sum.
+     */
+    template <typename T, typename M>
+    lg<T,M> dot(index_type const * c, T const * v, std::size_t n, lg<T,M> const * y)
+    {
+        T buf[block];
+        log_exp_sum<T,M> acc;
+        for (std::size_t i = 0; i < n; i += block)
+        {
+            auto const b = std::min(block, n - i);
+            for (std::size_t j = 0; j < b; ++j)
+                buf[j] = v[i + j] + y[c[i + j]].k;
+            acc += std::span<lg<T,M> const>(reinterpret_cast<lg<T,M> const *>(buf), b);
+        }
+        return acc.value();
+    }
+}
+
+template <typename T, typename M = std_math>
+class lg_sparse_vector
+{
+public:
+    using value_type = lg<T,M>;
+    using size_type = std::size_t;
+    using index_type = lg_sparse_detail::index_type;
+
+    // the zero vector of size n.
+    explicit lg_sparse_vector(size_type n = 0) : n_(n)
+    {
+        assert(n <= numeric_limits<index_type>::max());
+    }
+
+    // the nonzeros of xs.
+    explicit lg_sparse_vector(std::span<lg<T,M> const> xs) : lg_sparse_vector(xs.size())
+    {
+        for (size_type i = 0; i < xs.size(); ++i)
+            if (lg_sparse_detail::nonzero(xs[i].k))
+                push_back(i, xs[i]);
+    }
+
+    // the nonzeros of the probabilities ps >= 0.
+    static lg_sparse_vector from_values(std::span<T const> ps)
+    {
+        lg_sparse_vector v(ps.size());
+        for (size_type i = 0; i < ps.size(); ++i)
+            if (ps[i] != T(0))
+            {
+                v.idx_.push_back(index_type(i));
+                v.val_.push_back(lg<T,M>::from_log(ps[i]));
+            }
+        auto const k = v.val_.exponents();
+        M::log(k.data(), k.data(), k.size());
+        return v;
+    }
+
+    size_type size() const { return n_; }
+    size_type nnz() const { return idx_.size(); }
+
+    // appends x at index i, which is past the last nonzero.
+    void push_back(size_type i, lg<T,M> const & x)
+    {
+        assert(i < n_ && (idx_.empty() || idx_.back() < i));
+        idx_.push_back(index_type(i));
+        val_.push_back(x);
+    }
+
+    // the value at index i, by binary search.
+    lg<T,M> operator[](size_type i) const
+    {
+        auto const p = std::lower_bound(idx_.begin(), idx_.end(), index_type(i));
+        if (p == idx_.end() || *p != i)
+            return lg<T,M>::from_log(-numeric_limits<T>::infinity());
+        return val_[size_type(p - idx_.begin())];
+    }
+
+    std::span<index_type const> indices() const { return idx_; }
+    std::span<lg<T,M> const> values() const { return { val_.data(), val_.size() }; }
+    std::span<lg<T,M>> values() { return { val_.data(), val_.size() }; }
+
+    // ys := this, with the zeros written out.
+    void to_dense(std::span<lg<T,M>> ys) const
+    {
+        assert(ys.size() == n_);
+        std::fill(ys.begin(), ys.end(), lg<T,M>::from_log(-numeric_limits<T>::infinity()));
+        for (size_type j = 0; j < nnz(); ++j)
+            ys[idx_[j]] = val_[j];
+    }
+
+private:
+    size_type n_;
+    std::vector<index_type> idx_;
+    lg_vector<T,M> val_;
+};
+
+template <typename T, typename M = std_math>
+class lg_sparse_matrix
+{
+public:
+    using value_type = lg<T,M>;
+    using size_type = std::size_t;
+    using index_type = lg_sparse_detail::index_type;
+
+    // the zero n x m matrix.
+    explicit lg_sparse_matrix(size_type n = 0, size_type m = 0) : n_(n), m_(m), ptr_(n + 1, 0)
+    {
+        assert(m <= numeric_limits<index_type>::max());
+    }
+
+    // the nonzeros of the n x m row-major a.
+    lg_sparse_matrix(std::span<lg<T,M> const> a, size_type n, size_type m) : lg_sparse_matrix(n, m)
+    {
+        build(a, nullptr);
+    }
+
+    lg_sparse_matrix(std::span<lg<T,M> const> a, size_type n, size_type m, thread_pool & pool) : lg_sparse_matrix(n, m)
+    {
+        build(a, &pool);
+    }
+
+    // the nonzeros of the n x m row-major probabilities a >= 0.
+    static lg_sparse_matrix from_values(std::span<T const> a, size_type n, size_type m)
+    {
+        lg_sparse_matrix r(n, m);
+        r.build(a, nullptr);
+        return r;
+    }
+
+    static lg_sparse_matrix from_values(std::span<T const> a, size_type n, size_type m, thread_pool & pool)
+    {
+        lg_sparse_matrix r(n, m);
+        r.build(a, &pool);
+        return r;
+    }
+
+    size_type rows() const { return n_; }
+    size_type cols() const { return m_; }
+    size_type nnz() const { return idx_.size(); }
+
+    // row i is the nonzeros [offsets()[i], offsets()[i+1]).
+    std::span<size_type const> offsets() const { return ptr_; }
+    std::span<index_type const> indices() const { return idx_; }
+    std::span<lg<T,M> const> values() const { return { val_.data(), val_.size() }; }
+
+    std::span<index_type const> row_indices(size_type i) const { return indices().subspan(ptr_[i], ptr_[i + 1] - ptr_[i]); }
+    std::span<lg<T,M> const> row_values(size_type i) const { return values().subspan(ptr_[i], ptr_[i + 1] - ptr_[i]); }
+
+    // the value at (i,j), by binary search in row i.
+    lg<T,M> operator()(size_type i, size_type j) const
+    {
+        auto const c = row_indices(i);
+        auto const p = std::lower_bound(c.begin(), c.end(), index_type(j));
+        if (p == c.end() || *p != j)
+            return lg<T,M>::from_log(-numeric_limits<T>::infinity());
+        return row_values(i)[size_type(p - c.begin())];
+    }
+
+    // the m x n transpose, e.g., the columns of this as rows.
+    lg_sparse_matrix transpose() const
+    {
+        lg_sparse_matrix t(m_, n_);
+        for (auto const j : idx_)
+            ++t.ptr_[j + 1];
+        for (size_type j = 0; j < m_; ++j)
+            t.ptr_[j + 1] += t.ptr_[j];
+
+        t.idx_.resize(nnz());
+        t.val_.resize(nnz());
+        std::vector<size_type> next(t.ptr_.begin(), t.ptr_.end() - 1);
+        for (size_type i = 0; i < n_; ++i)
+            for (size_type r = ptr_[i]; r < ptr_[i + 1]; ++r)
+            {
+                auto const q = next[idx_[r]]++;
+                t.idx_[q] = index_type(i);
+                t.val_[q] = val_[r];
+            }
+        return t;
+    }
+
+    // a := this, row-major, with the zeros written out.
+    void to_dense(std::span<lg<T,M>> a) const
+    {
+        assert(a.size() == n_ * m_);
+        std::fill(a.begin(), a.end(), lg<T,M>::from_log(-numeric_limits<T>::infinity()));
+        for (size_type i = 0; i < n_; ++i)
+            for (size_type r = ptr_[i]; r < ptr_[i + 1]; ++r)
+                a[i * m_ + idx_[r]] = val_[r];
+    }
+
+private:
+    // counts the nonzeros of each row, then fills each row.
+    template <typename X>
+    void build(std::span<X const> a, thread_pool * pool)
+    {
+        assert(a.size() == n_ * m_);
+        auto const nonzero = [](X const & x)
+        {
+            if constexpr (std::same_as<X, lg<T,M>>)
+                return lg_sparse_detail::nonzero(x.k);
+            else
+                return x != T(0);
+        };
+
+        lg_sparse_detail::for_rows(n_, pool, [&](size_type i)
+        {
+            size_type c = 0;
+            for (size_type j = 0; j < m_; ++j)
+                c += nonzero(a[i * m_ + j]);
+            ptr_[i + 1] = c;
+        });
+        for (size_type i = 0; i < n_; ++i)
+            ptr_[i + 1] += ptr_[i];
+
+        idx_.resize(ptr_[n_]);
+        val_.resize(ptr_[n_]);
+        auto const k = val_.exponents();
+        lg_sparse_detail::for_rows(n_, pool, [&](size_type i)
+        {
+            auto r = ptr_[i];
+            for (size_type j = 0; j < m_; ++j)
+                if (nonzero(a[i * m_ + j]))
+                {
+                    idx_[r] = index_type(j);
+                    if constexpr (std::same_as<X, lg<T,M>>)
+                        k[r] = a[i * m_ + j].k;
+                    else
+                        k[r] = a[i * m_ + j];
+                    ++r;
+                }
+            if constexpr (!std::same_as<X, lg<T,M>>)
+                M::log(k.data() + ptr_[i], k.data() + ptr_[i], ptr_[i + 1] - ptr_[i]);
+        });
+    }
+
+    size_type n_, m_;
+    std::vector<size_type> ptr_;
+    std::vector<index_type> idx_;
+    lg_vector<T,M> val_;
+};
+
+/**
+ * dot : (lg_sparse_vector<T,M>, [lg<T,M>]) -> lg<T,M>
+ *
+ * x[0] y[0] + ... + x[n-1] y[n-1], over the nonzeros of x.
+ */
+template <typename T, typename M>
+lg<T,M> dot(lg_sparse_vector<T,M> const & x, std::span<lg<T,M> const> y)
+{
+    assert(x.size() == y.size());
+    auto const k = x.values();
+    return lg_sparse_detail::dot(x.indices().data(), reinterpret_cast<T const *>(k.data()), x.nnz(), y.data());
+}
+
+template <typename T, typename M>
+lg<T,M> dot(lg_sparse_vector<T,M> const & x, lg_vector<T,M> const & y) { return dot(x, std::span<lg<T,M> const>(y.data(), y.size())); }
+
+/**
+ * sum : lg_sparse_vector<T,M> -> lg<T,M>
+ *
+ * The sum of the nonzeros.
+ */
+template <typename T, typename M>
+lg<T,M> sum(lg_sparse_vector<T,M> const & x) { return sum(x.values()); }
+
+/**
+ * * : (lg_sparse_vector<T,M>, [lg<T,M>]) -> lg_sparse_vector<T,M>
+ *
+ * The elementwise product, whose nonzeros are at the nonzeros of x. A
+ * product that is zero, i.e., at a zero of y, is dropped.
+ */
+template <typename T, typename M>
+lg_sparse_vector<T,M> operator*(lg_sparse_vector<T,M> const & x, std::span<lg<T,M> const> y)
+{
+    assert(x.size() == y.size());
+    lg_sparse_vector<T,M> r(x.size());
+    auto const c = x.indices();
+    auto const v = x.values();
+    for (std::size_t j = 0; j < x.nnz(); ++j)
+    {
+        auto const p = v[j] * y[c[j]];
+        if (lg_sparse_detail::nonzero(p.k))
+            r.push_back(c[j], p);
+    }
+    return r;
+}
+
+template <typename T, typename M>
+lg_sparse_vector<T,M> operator*(lg_sparse_vector<T,M> const & x, lg_vector<T,M> const & y)
+{
+    return x * std::span<lg<T,M> const>(y.data(), y.size());
+}
+
+template <typename T, typename M>
+lg_sparse_vector<T,M> operator*(lg_vector<T,M> const & y, lg_sparse_vector<T,M> const & x) { return x * y; }
+
+namespace lg_sparse_detail
+{
+    template <typename S, typename T, typename M>
+    concept semiring_of = semiring<S> && std::same_as<typename S::value_type, lg<T,M>>;
+
+    // y[i] := S::sum_j(A[i][j] x[j]) over the nonzeros of row i.
+    template <typename S, typename T, typename M>
+    void matvec(lg_sparse_matrix<T,M> const & a, std::span<lg<T,M> const> x, std::span<lg<T,M>> y, thread_pool * pool)
+    {
+        assert(x.size() == a.cols() && y.size() == a.rows());
+        auto const c = a.indices();
+        auto const v = a.values();
+        auto const row = [&](std::size_t i, std::vector<lg<T,M>> & t)
+        {
+            auto const r0 = a.offsets()[i], r1 = a.offsets()[i + 1];
+            t.resize(r1 - r0);
+            for (std::size_t r = r0; r < r1; ++r)
+                t[r - r0] = S::times(v[r], x[c[r]]);
+            y[i] = S::sum(std::span<lg<T,M> const>(t));
+        };
+
+        if (!pool)
+        {
+            std::vector<lg<T,M>> t;
+            for (std::size_t i = 0; i < a.rows(); ++i)
+                row(i, t);
+            return;
+        }
+        auto const tasks = (a.rows() + rows_per_task - 1) / rows_per_task;
+        pool->parallel_for(tasks, [&](std::size_t k)
+        {
+            std::vector<lg<T,M>> t;
+            for (std::size_t i = k * rows_per_task; i < std::min(a.rows(), (k + 1) * rows_per_task); ++i)
+                row(i, t);
+        });
+    }
+}
+
+/**
+ * matvec<S> : (lg_sparse_matrix<T,M>, [lg<T,M>], [lg<T,M>]) -> void
+ *
+ * y := A x over the semiring S, i.e.,
+ *     y[i] := S::sum(A[i][j] x[j] for the nonzeros A[i][j] of row i),
+ * which for lg_sum is the log-sum-exp of each row. A row without
+ * nonzeros is S::zero().
+ */
+template <typename S, typename T, typename M> requires lg_sparse_detail::semiring_of<S,T,M>
+void matvec(lg_sparse_matrix<T,M> const & a, std::span<lg<T,M> const> x, std::span<lg<T,M>> y)
+{
+    lg_sparse_detail::matvec<S>(a, x, y, nullptr);
+}
+
+// the rows are split into tasks on pool; each y[i] is the same for any number of threads.
+template <typename S, typename T, typename M> requires lg_sparse_detail::semiring_of<S,T,M>
+void matvec(lg_sparse_matrix<T,M> const & a, std::span<lg<T,M> const> x, std::span<lg<T,M>> y, thread_pool & pool)
+{
+    lg_sparse_detail::matvec<S>(a, x, y, &pool);
+}
+
+/**
+ * forward<S> : ([lg<T,M>], lg_sparse_matrix<T,M>, [lg<T,M>], [lg<T,M>], n) -> lg<T,M>
+ *
+ * The forward recursion of semiring.hpp for a sparse m x m transition
+ * matrix, i.e., a model whose states have few successors. The matrix is
+ * transposed once, so each step is a sparse matvec of O(nnz) rather than
+ * O(m^2).
+ */
+template <typename S, typename T, typename M> requires lg_sparse_detail::semiring_of<S,T,M>
+lg<T,M> forward(std::span<lg<T,M> const> init, lg_sparse_matrix<T,M> const & trans,
+    std::span<lg<T,M> const> emit, std::span<lg<T,M>> alpha, std::size_t n)
+{
+    using V = lg<T,M>;
+    auto const m = trans.rows();
+    assert(trans.cols() == m && init.size() == m && emit.size() == n * m && alpha.size() == n * m);
+    if (n == 0)
+        return S::zero();
+
+    auto const tt = trans.transpose();
+    for (std::size_t j = 0; j < m; ++j)
+        alpha[j] = S::times(init[j], emit[j]);
+    for (std::size_t t = 1; t < n; ++t)
+    {
+        auto const next = alpha.subspan(t * m, m);
+        matvec<S>(tt, std::span<V const>(alpha.subspan((t - 1) * m, m)), next);
+        for (std::size_t j = 0; j < m; ++j)
+            next[j] = S::times(next[j], emit[t * m + j]);
+    }
+    return S::sum(std::span<V const>(alpha.subspan((n - 1) * m, m)));
+}
@@ -0,0 +1,308 @@
+/**
+ * Containers of lg<T,M> that are contiguous arrays of exponents.
+ *
+ *     lg_vector<T,M> owns its exponents, which are stored 64-byte aligned
+ *                    (a cache line, and an AVX-512 register), so the
+ *                    kernels over them load whole packs from the start.
+ *     lg_view<T,M>   is a non-owning view of n exponents that already
+ *                    exist, e.g., an array of log-probabilities written
+ *                    by some model, so they are used as lg<T,M> without
+ *                    copying. For a read-only buffer, use lg_view<T const,M>.
+ *
+ * Since lg<T,M> is a standard-layout type whose only member is its
+ * exponent, both are also contiguous ranges of lg<T,M>, so the kernels
+ * in lg_batch.hpp, log_exp_sum.hpp and friends work on them as is,
+ * e.g., product(v) or sum(v).
+ *
+ * The elementwise operations
+ *     *, /      : (V, V) -> lg_vector<T,M>,  (V, lg<T,M>) -> lg_vector<T,M>
+ *     pow       : (V, T) -> lg_vector<T,M>
+ *     <, <=, >, >=, ==, != : (V, V) -> std::vector<std::uint64_t>,
+ * where V is lg_vector<T,M> or lg_view<T,M>, are additions, subtractions,
+ * multiplications and comparisons of the exponents, computed
+ * simd::pack<T>::width values at a time. A comparison is a packed
+ * bitmask, as in safe_batch.hpp: bit i%64 of word i/64 is set if the
+ * comparison holds for the values i, so the comparison masks of the
+ * packs are stored as is rather than a bool at a time.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "simd.hpp"
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace lg_vector_detail
+{
+    // the alignment of the exponents of an lg_vector.
+    inline constexpr std::size_t alignment = 64;
+
+    template <typename T>
+    struct aligned_allocator
+    {
+        using value_type = T;
+
+        aligned_allocator() = default;
+
+        template <typename U>
+        aligned_allocator(aligned_allocator<U> const &) {}
+
+        T * allocate(std::size_t n)
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+        }
+
+        void deallocate(T * p, std::size_t) { ::operator delete(p, std::align_val_t(alignment)); }
+
+        template <typename U>
+        bool operator==(aligned_allocator<U> const &) const { return true; }
+    };
+
+    /**
+     * r[i] := f(x[i], y[i]) for i in [0,n), where f maps packs (or
+     * simd::scalar<T>, for the tail) to packs.
+     */
+    template <typename T, typename F>
+    void transform(T const * x, T const * y, T * r, std::size_t n, F f)
+    {
+        using P = simd::pack<T>;
+        using S = simd::scalar<T>;
+        std::size_t const m = n - n % P::width;
+        for (std::size_t i = 0; i < m; i += P::width)
+            f(P::load(x + i), P::load(y + i)).store(r + i);
+        for (std::size_t i = m; i < n; ++i)
+            f(S::load(x + i), S::load(y + i)).store(r + i);
+    }
+}
+
+template <typename T, typename M = std_math>
+class lg_vector
+{
+public:
+    using value_type = lg<T,M>;
+    using size_type = std::size_t;
+    using iterator = lg<T,M> *;
+    using const_iterator = lg<T,M> const *;
+
+    lg_vector() = default;
+
+    // n copies of x, by default the multiplicative identity.
+    explicit lg_vector(size_type n, lg<T,M> const & x = lg<T,M>()) : k_(n, x.k) {}
+
+    lg_vector(std::initializer_list<lg<T,M>> xs) : k_(xs.size())
+    {
+        auto i = k_.begin();
+        for (auto const & x : xs)
+            *i++ = x.k;
+    }
+
+    explicit lg_vector(std::span<lg<T,M> const> xs) : lg_vector(from_log(exponents_of(xs))) {}
+
+    // copies of the exponents ks.
+    static lg_vector from_log(std::span<T const> ks)
+    {
+        lg_vector v;
+        v.k_.assign(ks.begin(), ks.end());
+        return v;
+    }
+
+    size_type size() const { return k_.size(); }
+    bool empty() const { return k_.empty(); }
+    void resize(size_type n, lg<T,M> const & x = lg<T,M>()) { k_.resize(n, x.k); }
+    void reserve(size_type n) { k_.reserve(n); }
+    void push_back(lg<T,M> const & x) { k_.push_back(x.k); }
+
+    lg<T,M> * data() { return reinterpret_cast<lg<T,M> *>(k_.data()); }
+    lg<T,M> const * data() const { return reinterpret_cast<lg<T,M> const *>(k_.data()); }
+
+    lg<T,M> & operator[](size_type i) { return data()[i]; }
+    lg<T,M> const & operator[](size_type i) const { return data()[i]; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + size(); }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+
+    // the exponents, i.e., the logs of the values.
+    std::span<T> exponents() { return k_; }
+    std::span<T const> exponents() const { return k_; }
+
+private:
+    static_assert(sizeof(lg<T,M>) == sizeof(T));
+
+    static std::span<T const> exponents_of(std::span<lg<T,M> const> xs)
+    {
+        return { reinterpret_cast<T const *>(xs.data()), xs.size() };
+    }
+
+    std::vector<T, lg_vector_detail::aligned_allocator<T>> k_;
+};
+
+template <typename T, typename M = std_math>
+class lg_view
+{
+    using U = std::remove_const_t<T>;
+
+public:
+    using element_type = std::conditional_t<std::is_const_v<T>, lg<U,M> const, lg<U,M>>;
+    using value_type = lg<U,M>;
+    using size_type = std::size_t;
+    using iterator = element_type *;
+
+    // views the n exponents (logs of the values) starting at k.
+    lg_view(T * k, size_type n) : k_(k), n_(n) {}
+
+    explicit lg_view(std::span<T> ks) : lg_view(ks.data(), ks.size()) {}
+
+    lg_view(lg_vector<U,M> & v) requires (!std::is_const_v<T>) : lg_view(v.exponents()) {}
+    lg_view(lg_vector<U,M> const & v) requires std::is_const_v<T> : lg_view(v.exponents()) {}
+
+    size_type size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+
+    element_type * data() const { return reinterpret_cast<element_type *>(k_); }
+    element_type & operator[](size_type i) const { return data()[i]; }
+    iterator begin() const { return data(); }
+    iterator end() const { return data() + n_; }
+
+    std::span<T> exponents() const { return { k_, n_ }; }
+
+private:
+    static_assert(sizeof(lg<U,M>) == sizeof(U));
+
+    T * k_;
+    size_type n_;
+};
+
+namespace lg_vector_detail
+{
+    template <typename V>
+    struct traits : std::false_type {};
+
+    template <typename T, typename M>
+    struct traits<lg_vector<T,M>> : std::true_type
+    {
+        using value_type = T;
+        using math = M;
+    };
+
+    template <typename T, typename M>
+    struct traits<lg_view<T,M>> : std::true_type
+    {
+        using value_type = std::remove_const_t<T>;
+        using math = M;
+    };
+
+    template <typename V>
+    concept array = traits<std::remove_cvref_t<V>>::value;
+
+    // arrays over the same lg<T,M>.
+    template <typename V, typename W>
+    concept compatible = array<V> && array<W> &&
+        std::is_same_v<typename traits<std::remove_cvref_t<V>>::value_type, typename traits<std::remove_cvref_t<W>>::value_type> &&
+        std::is_same_v<typename traits<std::remove_cvref_t<V>>::math, typename traits<std::remove_cvref_t<W>>::math>;
+
+    template <typename V>
+    using vector_of = lg_vector<typename traits<std::remove_cvref_t<V>>::value_type, typename traits<std::remove_cvref_t<V>>::math>;
+
+    template <typename V, typename W, typename F>
+    auto elementwise(V const & x, W const & y, F f)
+    {
+        assert(x.size() == y.size());
+        vector_of<V> r(x.size());
+        transform(x.exponents().data(), y.exponents().data(), r.exponents().data(), x.size(), f);
+        return r;
+    }
+
+    template <typename V, typename F>
+    auto broadcast(V const & x, typename traits<V>::value_type k, F f)
+    {
+        vector_of<V> r(x.size());
+        auto const xs = x.exponents();
+        auto const rs = r.exponents();
+        using P = simd::pack<typename traits<V>::value_type>;
+        using S = simd::scalar<typename traits<V>::value_type>;
+        std::size_t const m = x.size() - x.size() % P::width;
+        for (std::size_t i = 0; i < m; i += P::width)
+            f(P::load(xs.data() + i), P::broadcast(k)).store(rs.data() + i);
+        for (std::size_t i = m; i < x.size(); ++i)
+            f(S::load(xs.data() + i), S::broadcast(k)).store(rs.data() + i);
+        return r;
+    }
+
+    // the bitmask of c(x[i], y[i]), from the comparison masks of the packs.
+    template <typename V, typename W, typename C>
+    std::vector<std::uint64_t> compare(V const & x, W const & y, C c)
+    {
+        assert(x.size() == y.size());
+        using P = simd::pack<typename traits<V>::value_type>;
+        using S = simd::scalar<typename traits<V>::value_type>;
+        static_assert(64 % P::width == 0);
+
+        auto const xs = x.exponents().data();
+        auto const ys = y.exponents().data();
+        std::vector<std::uint64_t> r((x.size() + 63) / 64, 0);
+        std::size_t const m = x.size() - x.size() % P::width;
+        for (std::size_t i = 0; i < m; i += P::width)
+            r[i / 64] |= std::uint64_t(c(P::load(xs + i), P::load(ys + i)).bits()) << (i % 64);
+        for (std::size_t i = m; i < x.size(); ++i)
+            r[i / 64] |= std::uint64_t(c(S::load(xs + i), S::load(ys + i)).bits()) << (i % 64);
+        return r;
+    }
+}
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator*(V const & x, W const & y) { return lg_vector_detail::elementwise(x, y, [](auto a, auto b) { return a + b; }); }
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator/(V const & x, W const & y) { return lg_vector_detail::elementwise(x, y, [](auto a, auto b) { return a - b; }); }
+
+template <lg_vector_detail::array V>
+auto operator*(V const & x, lg<typename lg_vector_detail::traits<V>::value_type, typename lg_vector_detail::traits<V>::math> const & y)
+{
+    return lg_vector_detail::broadcast(x, y.k, [](auto a, auto b) { return a + b; });
+}
+
+template <lg_vector_detail::array V>
+auto operator/(V const & x, lg<typename lg_vector_detail::traits<V>::value_type, typename lg_vector_detail::traits<V>::math> const & y)
+{
+    return lg_vector_detail::broadcast(x, y.k, [](auto a, auto b) { return a - b; });
+}
+
+/**
+ * pow : (V, T) -> lg_vector<T,M>
+ *
+ * x[i]^e, i.e., the exponents times e.
+ */
+template <lg_vector_detail::array V>
+auto pow(V const & x, typename lg_vector_detail::traits<V>::value_type const & e)
+{
+    return lg_vector_detail::broadcast(x, e, [](auto a, auto b) { return a * b; });
+}
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator<(V const & x, W const & y) { return lg_vector_detail::compare(x, y, [](auto a, auto b) { return a < b; }); }
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator<=(V const & x, W const & y) { return lg_vector_detail::compare(x, y, [](auto a, auto b) { return a <= b; }); }
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator>(V const & x, W const & y) { return lg_vector_detail::compare(x, y, [](auto a, auto b) { return b < a; }); }
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator>=(V const & x, W const & y) { return lg_vector_detail::compare(x, y, [](auto a, auto b) { return b <= a; }); }
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator==(V const & x, W const & y) { return lg_vector_detail::compare(x, y, [](auto a, auto b) { return a == b; }); }
+
+template <typename V, typename W> requires lg_vector_detail::compatible<V,W>
+auto operator!=(V const & x, W const & y) { return lg_vector_detail::compare(x, y, [](auto a, auto b) { return !(a == b); }); }
@@ -0,0 +1,90 @@
+/**
+ * Parallel evaluation of the likelihood of a sample,
+ *     L(x1,...,xn) := p(x1) * ... * p(xn),
+ * where the pdf p : X -> lg<T,M> is evaluated in the log-domain, as in
+ * the example use of lg<T> in lg.hpp.
+ *
+ * The sample is split into chunks of a fixed number of rows. Each chunk
+ * is a task on a thread_pool, which evaluates p on the rows of the chunk
+ * and reduces their exponents with simd::sum into the chunk's slot.
+ * After all chunks are done, the slots are combined by a pairwise sum
+ * whose shape only depends on the number of chunks.
+ *
+ * Since neither the chunks nor the order in which anything is added
+ * depend on which thread runs a chunk, the result is bit-for-bit the
+ * same for any number of threads (for a fixed chunk size and
+ * instruction set).
+ *
+ * The pdf is called concurrently from several threads, so it must be
+ * safe to do so, e.g., a const function object.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace likelihood_detail
+{
+    template <typename T>
+    T pairwise_sum(T const * x, std::size_t n)
+    {
+        if (n == 0)
+            return T(0);
+        if (n == 1)
+            return x[0];
+        auto const h = n / 2;
+        return pairwise_sum(x, h) + pairwise_sum(x + h, n - h);
+    }
+
+    // rows evaluated per call to simd::sum within a chunk.
+    inline constexpr std::size_t block = 256;
+}
+
+/**
+ * likelihood : ([X], p, pool, chunk) -> lg<T,M>
+ *
+ * The likelihood of the sample under p, where p(x) returns lg<T,M>.
+ */
+template <typename X, typename F>
+auto likelihood(std::span<X const> sample, F const & pdf, thread_pool & pool, std::size_t chunk = 4096)
+{
+    using L = std::remove_cvref_t<std::invoke_result_t<F const &, X const &>>;
+    using T = typename L::value_type;
+
+    chunk = std::max<std::size_t>(chunk, 1);
+    auto const n = sample.size();
+    std::vector<T> partial((n + chunk - 1) / chunk);
+
+    pool.parallel_for(partial.size(), [&](std::size_t c)
+    {
+        T buf[likelihood_detail::block];
+        T s = T(0);
+        auto const end = std::min(n, (c + 1) * chunk);
+        for (std::size_t i = c * chunk; i < end; i += likelihood_detail::block)
+        {
+            auto const m = std::min(likelihood_detail::block, end - i);
+            for (std::size_t j = 0; j < m; ++j)
+                buf[j] = std::invoke(pdf, sample[i + j]).k;
+            s = s + simd::sum(buf, m);
+        }
+        partial[c] = s;
+    });
+
+    return L::from_log(likelihood_detail::pairwise_sum(partial.data(), partial.size()));
+}
+
+template <std::ranges::contiguous_range R, typename F>
+auto likelihood(R const & sample, F const & pdf, thread_pool & pool, std::size_t chunk = 4096)
+{
+    return likelihood(std::span<std::ranges::range_value_t<R> const>(sample), pdf, pool, chunk);
+}
@@ -0,0 +1,277 @@
+/**
+ * Addition of lg<T,M> as in a logarithmic number system (LNS), i.e.,
+ * without exp and log. For exponents a >= b,
+ *     log(exp(a) + exp(b)) = a + sb(a - b),  sb(d) := log(1 + exp(-d)),
+ * where sb, the Gaussian logarithm, is a smooth function of d >= 0 that
+ * falls from log(2) to 0 like exp(-d). Rather than an exp and a log1p per
+ * addition, sb is evaluated from a table computed at compile time:
+ *
+ *     - The nodes are d = j h, h := 2^-P, up to the d past which sb is
+ *       below 2^-(digits + 2) of T, and sb is 0 beyond.
+ *
+ *     - Each node holds the Taylor coefficients sb^(k)(jh) / k!, k <= K,
+ *       which are polynomials in s := 1 / (1 + exp(d)), since sb' = -s
+ *       and s' = s^2 - s. K is 3 for float and 7 for double, so the
+ *       coefficients of a node are 16 and 64 bytes and the table is
+ *       64-byte aligned, i.e., a lookup touches a single cache line.
+ *
+ *     - sb(d) is the Taylor polynomial of the nearest node, evaluated at
+ *       t := d - jh, |t| <= h/2, which is exact.
+ *
+ * P is the precision knob. The truncation error of the polynomial is at
+ * most
+ *     max |sb^(K+1)| / (K+1)! (h/2)^(K+1),
+ * i.e., 5.2e-3 16^-(P+1) for float and 2.6e-5 256^-(P+1) for double:
+ *
+ *         P    float     double    table (float, double)
+ *         2    2.0e-6    1.6e-12   1.2 KB, 9.8 KB
+ *         3    8.0e-8    6.1e-15   2.3 KB, 20 KB
+ *         4    5.0e-9    2.4e-17   4.6 KB, 39 KB
+ *
+ * The default, P = 4, is below the rounding of the result for both, so
+ * a sum is within a few ulps of log(exp(a) + exp(b)), and the table is
+ * cache-resident. The error is an absolute error of the exponent, i.e.,
+ * a relative error of the value.
+ *
+ * The batch forms run simd::pack<T>::width additions at a time, with a
+ * gather per coefficient (see simd.hpp); lns_sum folds a sequence with
+ * simd::lanes independent accumulators, so a log-domain sum costs a few
+ * multiply-adds per value rather than an exp, as in log_exp_sum, or an
+ * exp and a log1p, as in a fold of lg_expr.hpp's +.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "simd.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+namespace lns_detail
+{
+    // exp(-x) for x >= 0, to long double precision, at compile time.
+    constexpr long double exp_neg(long double x)
+    {
+        constexpr long double inv_e = 0.367879441171442321595523770161460867L;
+        long double r = 1;
+        for (; x >= 1; x -= 1)
+            r *= inv_e;
+
+        long double s = 0, t = 1;
+        for (int i = 1; i < 30; ++i)
+        {
+            s += t;
+            t *= -x / i;
+        }
+        return r * s;
+    }
+
+    // log(1 + y) for 0 <= y <= 1 = 2 atanh(z), z = y / (2 + y) <= 1/3.
+    constexpr long double log1p(long double y)
+    {
+        auto const z = y / (2 + y);
+        auto const z2 = z * z;
+        long double s = 0, t = z;
+        for (int i = 1; i < 80; i += 2, t *= z2)
+            s += t / i;
+        return 2 * s;
+    }
+
+    // p[k] are the coefficients of sb^(k) as a polynomial in s, k >= 1.
+    template <int K>
+    constexpr auto derivatives()
+    {
+        std::array<std::array<long double, K + 2>, K + 1> p{};
+        p[1][1] = -1;
+        for (int k = 2; k <= K; ++k)
+            for (int i = 1; i <= k; ++i)
+            {
+                auto const c = i * p[k - 1][i];
+                p[k][i + 1] += c;
+                p[k][i] -= c;
+            }
+        return p;
+    }
+
+    template <typename T>
+    inline constexpr int degree = sizeof(T) <= 4 ? 3 : 7;
+
+    // (x + shift) - shift rounds x to an integer, for 0 <= x < 2^(digits-2).
+    template <typename T>
+    inline constexpr T shift = T(3) * T(std::uint64_t(1) << (numeric_limits<T>::digits - 2));
+
+    // number of nodes before the zero node.
+    template <typename T, int P>
+    inline constexpr std::size_t nodes = std::size_t((numeric_limits<T>::digits + 2) * 0.693147180559945309L * (1 << P)) + 1;
+
+    // the coefficients of node j, then those of the zero node. The table
+    // is aligned to a cache line, and the coefficients of a node are 16 or
+    // 64 bytes, so no node straddles two lines.
+    template <typename T, int P>
+    alignas(64) inline constexpr auto table = []
+    {
+        constexpr int K = degree<T>;
+        constexpr auto p = derivatives<K>();
+        std::array<T, (nodes<T,P> + 1) * (K + 1)> c{};
+        for (std::size_t j = 0; j < nodes<T,P>; ++j)
+        {
+            auto const e = exp_neg((long double)j / (1 << P));
+            auto const s = e / (1 + e);
+            c[j * (K + 1)] = T(log1p(e));
+
+            long double f = 1;
+            for (int k = 1; k <= K; ++k)
+            {
+                f *= k;
+                long double y = 0;
+                for (int i = k + 1; i >= 0; --i)
+                    y = y * s + p[k][i];
+                c[j * (K + 1) + k] = T(y / f);
+            }
+        }
+        return c;
+    }();
+}
+
+/**
+ * gaussian_log<T,P>::sb : T -> T
+ *
+ * sb(d) := log(1 + exp(-d)) for d >= 0, from a table with 2^P nodes per
+ * unit of d. NaN and inf give 0, so that a sum with an exponent of -inf
+ * is the other term, and a sum of two infinities is that infinity.
+ */
+template <typename T, int P = 4>
+struct gaussian_log
+{
+    static_assert(std::is_floating_point_v<T> && 0 <= P && P <= 10);
+
+    static constexpr int degree = lns_detail::degree<T>;
+    static constexpr std::size_t stride = degree + 1;
+    static constexpr T step = T(1) / T(1 << P);
+    // sb is 0 from range on.
+    static constexpr T range = T(lns_detail::nodes<T,P>) * step;
+
+    // the pack form, for any pack V of T, e.g., simd::pack<T>.
+    template <typename V>
+    static V sb(V d)
+    {
+        auto const & c = lns_detail::table<T,P>;
+        auto const r = V::broadcast(range), s = V::broadcast(lns_detail::shift<T>);
+        d = select(d < r, d, r);
+        auto const j = (d * V::broadcast(T(1 << P)) + s) - s;
+        auto const t = d - j * V::broadcast(step);
+        auto const i = j * V::broadcast(T(stride));
+
+        auto y = V::gather(c.data() + degree, i);
+        for (int k = degree - 1; k >= 0; --k)
+            y = y * t + V::gather(c.data() + k, i);
+        return y;
+    }
+
+    static T sb(T d) { return sb(simd::scalar<T>{d}).v; }
+};
+
+namespace lns_detail
+{
+    // a + b in the log-domain, for packs of exponents.
+    template <int P, typename V>
+    V add(V const & a, V const & b)
+    {
+        auto const m = max(a, b);
+        return m + gaussian_log<typename V::value_type, P>::sb(m - min(a, b));
+    }
+}
+
+/**
+ * lns_add : (lg<T,M>, lg<T,M>) -> lg<T,M>
+ *
+ * x + y, as max(kx, ky) + sb(|kx - ky|).
+ */
+template <int P = 4, typename T, typename M>
+lg<T,M> lns_add(lg<T,M> const & x, lg<T,M> const & y)
+{
+    using V = simd::scalar<T>;
+    return lg<T,M>::from_log(lns_detail::add<P>(V{x.k}, V{y.k}).v);
+}
+
+/**
+ * lns_add : ([lg<T,M>], [lg<T,M>], [lg<T,M>]) -> void
+ *
+ * zs[i] := xs[i] + ys[i], simd::pack<T>::width sums at a time.
+ */
+template <int P = 4, typename T, typename M>
+void lns_add(std::span<lg<T,M> const> xs, std::span<lg<T,M> const> ys, std::span<lg<T,M>> zs)
+{
+    using V = simd::pack<T>;
+    constexpr auto w = V::width;
+    static_assert(sizeof(lg<T,M>) == sizeof(T));
+    assert(xs.size() == ys.size() && xs.size() == zs.size());
+
+    auto const a = reinterpret_cast<T const *>(xs.data());
+    auto const b = reinterpret_cast<T const *>(ys.data());
+    auto const c = reinterpret_cast<T *>(zs.data());
+
+    std::size_t i = 0;
+    for (; i + w <= xs.size(); i += w)
+        lns_detail::add<P>(V::load(a + i), V::load(b + i)).store(c + i);
+    for (; i < xs.size(); ++i)
+        zs[i] = lns_add<P>(xs[i], ys[i]);
+}
+
+/**
+ * lns_sum : [lg<T,M>] -> lg<T,M>
+ *
+ * x1 + ... + xn, folded with simd::lanes pack accumulators, which are
+ * then added lane by lane. The empty sum is 0.
+ */
+template <int P = 4, typename T, typename M>
+lg<T,M> lns_sum(std::span<lg<T,M> const> xs)
+{
+    using V = simd::pack<T>;
+    using lns_detail::add;
+    constexpr auto w = V::width;
+    static_assert(sizeof(lg<T,M>) == sizeof(T));
+
+    auto const k = reinterpret_cast<T const *>(xs.data());
+    auto const n = xs.size();
+
+    auto s0 = V::broadcast(-numeric_limits<T>::infinity()), s1 = s0, s2 = s0, s3 = s0;
+    std::size_t i = 0;
+    for (; i + simd::lanes * w <= n; i += simd::lanes * w)
+    {
+        s0 = add<P>(s0, V::load(k + i));
+        s1 = add<P>(s1, V::load(k + i + w));
+        s2 = add<P>(s2, V::load(k + i + 2 * w));
+        s3 = add<P>(s3, V::load(k + i + 3 * w));
+    }
+    for (; i + w <= n; i += w)
+        s0 = add<P>(s0, V::load(k + i));
+
+    T buf[w];
+    add<P>(add<P>(s0, s1), add<P>(s2, s3)).store(buf);
+    auto s = lg<T,M>::from_log(-numeric_limits<T>::infinity());
+    for (std::size_t j = 0; j < w; ++j)
+        s = lns_add<P>(s, lg<T,M>::from_log(buf[j]));
+    for (; i < n; ++i)
+        s = lns_add<P>(s, xs[i]);
+    return s;
+}
+
+// The overloads below accept any contiguous ranges, e.g., std::vector<lg<T>>.
+
+template <int P = 4, std::ranges::contiguous_range R>
+auto lns_sum(R const & xs) { return lns_sum<P>(std::span<std::ranges::range_value_t<R> const>(xs)); }
+
+template <int P = 4, std::ranges::contiguous_range R, std::ranges::contiguous_range S>
+void lns_add(R const & xs, R const & ys, S & zs)
+{
+    using L = std::ranges::range_value_t<R>;
+    lns_add<P>(std::span<L const>(xs), std::span<L const>(ys), std::span<L>(zs));
+}
@@ -0,0 +1,132 @@
+/**
+ * log_exp_sum<T,M> is a one-pass accumulator for sums of values of type
+ * lg<T,M>,
+ *     x1 + ... + xn,
+ * which are not in the computational basis of lg<T,M>.
+ *
+ * In the log-domain, the sum is
+ *     log(exp(k1) + ... + exp(kn)) = m + log(exp(k1 - m) + ... + exp(kn - m)),
+ * where m := max(k1,...,kn) keeps every exp in [0,1]. Rather than finding
+ * m in a first pass and summing in a second, the accumulator keeps the
+ * running maximum m and the running sum s of exp(ki - m). When a value
+ * with a larger exponent k arrives, s is rescaled by exp(m - k) and m
+ * becomes k.
+ *
+ * Values may be added one at a time or a sequence at a time. A sequence
+ * is added a block at a time: the block maximum rescales s at most once
+ * per block, and the exps of the block are computed with the batch
+ * M::exp and summed with simd::sum.
+ *
+ * Two accumulators over disjoint parts of a sequence, e.g., from
+ * different threads or chunks, merge into the accumulator of the whole
+ * sequence, since
+ *     (m1,s1) + (m2,s2) = (m1, s1 + s2 exp(m2 - m1)),  m2 <= m1.
+ *
+ * The empty sum is 0, i.e., lg<T,M>::from_log(-inf).
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <ranges>
+#include <span>
+
+template <typename T, typename M = std_math>
+struct log_exp_sum
+{
+    // running maximum of the exponents.
+    T m = -numeric_limits<T>::infinity();
+    // running sum of exp(k - m).
+    T s = T(0);
+
+    log_exp_sum & operator+=(lg<T,M> const & x)
+    {
+        auto const k = x.k;
+        if (m < k)
+        {
+            s = s * M::exp(m - k) + T(1);
+            m = k;
+        }
+        else if (k != -numeric_limits<T>::infinity() && m != numeric_limits<T>::infinity())
+            s = s + M::exp(k - m);
+        return *this;
+    }
+
+    log_exp_sum & operator+=(std::span<lg<T,M> const> xs)
+    {
+        static_assert(sizeof(lg<T,M>) == sizeof(T));
+        auto const k = reinterpret_cast<T const *>(xs.data());
+
+        constexpr std::size_t block = 256;
+        T buf[block];
+        for (std::size_t i = 0; i < xs.size(); i += block)
+        {
+            auto const n = std::min(block, xs.size() - i);
+            auto const bm = simd::hmax(k + i, n);
+            if (m < bm)
+            {
+                s = s * M::exp(m - bm);
+                m = bm;
+            }
+            if (m == -numeric_limits<T>::infinity() || m == numeric_limits<T>::infinity())
+                continue;
+
+            for (std::size_t j = 0; j < n; ++j)
+                buf[j] = k[i + j] - m;
+            M::exp(buf, buf, n);
+            s = s + simd::sum(buf, n);
+        }
+        return *this;
+    }
+
+    log_exp_sum & operator+=(log_exp_sum const & rhs)
+    {
+        if (m < rhs.m)
+        {
+            s = s * M::exp(m - rhs.m) + rhs.s;
+            m = rhs.m;
+        }
+        else if (rhs.m != -numeric_limits<T>::infinity() && m != numeric_limits<T>::infinity())
+            s = s + rhs.s * M::exp(rhs.m - m);
+        return *this;
+    }
+
+    // the sum of the values added so far.
+    auto value() const
+    {
+        if (m == -numeric_limits<T>::infinity() || m == numeric_limits<T>::infinity())
+            return lg<T,M>::from_log(m);
+        return lg<T,M>::from_log(m + M::log(s));
+    }
+
+    operator lg<T,M>() const { return value(); }
+};
+
+/**
+ * + : (log_exp_sum<T,M>, log_exp_sum<T,M>) -> log_exp_sum<T,M>
+ *
+ * Merges two partial sums.
+ */
+template <typename T, typename M>
+auto operator+(log_exp_sum<T,M> x, log_exp_sum<T,M> const & y) { return x += y; }
+
+/**
+ * sum : [lg<T,M>] -> lg<T,M>
+ *
+ * The sum of a sequence of lg<T,M> in one pass.
+ */
+template <typename T, typename M>
+auto sum(std::span<lg<T,M> const> xs)
+{
+    log_exp_sum<T,M> acc;
+    acc += xs;
+    return acc.value();
+}
+
+template <std::ranges::contiguous_range R>
+auto sum(R const & xs) { return sum(std::span<std::ranges::range_value_t<R> const>(xs)); }
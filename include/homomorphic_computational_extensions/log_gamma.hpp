@@ -0,0 +1,377 @@
+/**
+ * The gamma function and its relatives in the log-domain, i.e.,
+ *     log_factorial : n -> lg<T,M>,     n!
+ *     log_gamma     : T -> lg<T,M>,     gamma(x), x > 0
+ *     log_binomial  : (n,k) -> lg<T,M>, n choose k
+ *     log_beta      : (T,T) -> lg<T,M>, beta(a,b), a,b > 0,
+ * whose values overflow T long before their logs do, so they are
+ * returned as lg<T,M>, whose exponent is the log of the value.
+ *
+ * Every call is O(1):
+ *
+ *     - log(n!) for n < 256 is a table computed at compile time, in
+ *       long double, with a constexpr log.
+ *
+ *     - Otherwise, for x >= 16, Stirling's series
+ *           log(gamma(x)) = (x - 1/2) log(x) - x + log(2 pi)/2 + w(x),
+ *           w(x) = sum B_2j / (2j (2j - 1) x^(2j-1)),  j = 1..8,
+ *       whose truncation is below double precision there.
+ *
+ *     - For x < 16, the recurrence gamma(x+1) = x gamma(x) shifts x to
+ *       2 + z, |z| <= 1/2, where the Taylor series
+ *           log(gamma(2 + z)) = (1 - gamma) z + sum (-1)^k (zeta(k) - 1) z^k / k
+ *       converges like 4^-k; its coefficients are computed at compile
+ *       time too. Since z is exact, the zeros of log(gamma(x)) at 1 and 2
+ *       keep their relative accuracy.
+ *
+ * Computing log_binomial and log_beta as a difference of three
+ * log-gammas would cancel most of the digits of a small result of
+ * large arguments, e.g., log(C(10^6, 1)) = 13.8 as a difference of terms
+ * of size 10^7. Instead, following Loader's method for binomial
+ * probabilities, the large terms are combined analytically first, e.g.,
+ *     log(C(n,k)) = k log(n/k) - (n-k) log1p(-k/n)
+ *                   - log(2 pi k (n-k) / n) / 2 + w(n) - w(k) - w(n-k),
+ * with w(m) from a compile-time table for m < 16, so the results are
+ * within a few ulps.
+ *
+ * The batch forms over spans map the logs they need with the batch
+ * M::log, so with fast_math they run pack<T>::width values at a time.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace log_gamma_detail
+{
+    // the natural log of x > 0 to long double precision, at compile time.
+    constexpr long double log(long double x)
+    {
+        constexpr long double ln2 = 0.693147180559945309417232121458176568L;
+        int e = 0;
+        for (; x >= 2; x /= 2)
+            ++e;
+        for (; x < 1; x *= 2)
+            --e;
+        if (x > 1.41421356237309504880L)
+        {
+            x /= 2;
+            ++e;
+        }
+
+        // log(x) = 2 atanh(z), z = (x-1)/(x+1), |z| < 0.172.
+        auto const z = (x - 1) / (x + 1);
+        auto const z2 = z * z;
+        long double s = 0, t = z;
+        for (int i = 1; i < 60; i += 2, t *= z2)
+            s += t / i;
+        return 2 * s + e * ln2;
+    }
+
+    inline constexpr long double half_log_2pi = 0.918938533204672741780329736405617639L;
+
+    // the table of log(n!) and where Stirling's series takes over.
+    inline constexpr std::size_t table_size = 256;
+    inline constexpr double stirling = 16;
+
+    // log(n!) for n < table_size.
+    inline constexpr auto log_factorials = []
+    {
+        std::array<double, table_size> t{};
+        long double s = 0;
+        for (std::size_t n = 2; n < table_size; ++n)
+        {
+            s += log(n);
+            t[n] = double(s);
+        }
+        return t;
+    }();
+
+    // w(m) := log(m!) - (m + 1/2) log(m) + m - log(2 pi)/2 for 0 < m < 16.
+    inline constexpr auto correction = []
+    {
+        std::array<double, 16> t{};
+        long double s = 0;
+        for (int m = 1; m < 16; ++m)
+        {
+            s += log(m);
+            t[m] = double(s - ((m + 0.5L) * log(m) - m + half_log_2pi));
+        }
+        return t;
+    }();
+
+    // w(x), the remainder of Stirling's series, for x >= 16.
+    template <typename T>
+    T omega(T const & x)
+    {
+        auto const y = T(1) / x;
+        auto const z = y * y;
+        return y * (T(1.0 / 12) + z * (T(-1.0 / 360) + z * (T(1.0 / 1260) + z * (T(-1.0 / 1680) +
+            z * (T(1.0 / 1188) + z * (T(-691.0 / 360360) + z * (T(1.0 / 156) + z * T(-3617.0 / 122400))))))));
+    }
+
+    // w(m) for any integer m > 0.
+    template <typename T>
+    T omega(std::uint64_t m) { return m < 16 ? T(correction[m]) : omega(T(m)); }
+
+    // (x + h) log(x) - x + log(2 pi)/2 + w(x) for x >= 16, given log(x),
+    // which is log(gamma(x)) for h = -1/2 and log(x!) for h = 1/2.
+    template <typename T>
+    T stirling_series(T const & x, T const & h, T const & log_x)
+    {
+        using std::fma;
+        return fma(x + h, log_x, -x) + T(half_log_2pi) + omega(x);
+    }
+
+    // zeta(s) - 1 for s >= 2, summed to n = 31 with the Euler-Maclaurin
+    // formula for the tail.
+    constexpr long double zeta_minus_one(int s)
+    {
+        constexpr int N = 32;
+        long double z = 0;
+        for (int n = 2; n < N; ++n)
+        {
+            long double t = 1;
+            for (int i = 0; i < s; ++i)
+                t /= n;
+            z += t;
+        }
+
+        // N^(1-s) / (s-1) + N^-s / 2 + sum B_2j / (2j)! s (s+1) ... (s+2j-2) N^(1-s-2j).
+        constexpr long double bernoulli[] = {1.0L / 6, -1.0L / 30, 1.0L / 42, -1.0L / 30, 5.0L / 66};
+        long double p = 1;
+        for (int i = 1; i < s; ++i)
+            p /= N;
+        z += p / (s - 1) + p / N / 2;
+        long double f = (long double)s / N / N * p, fac = 2;
+        for (int j = 0; j < 5; ++j)
+        {
+            z += bernoulli[j] / fac * f;
+            f *= (long double)(s + 2 * j + 1) * (s + 2 * j + 2) / N / N;
+            fac *= (2 * j + 3) * (2 * j + 4);
+        }
+        return z;
+    }
+
+    // the Taylor coefficients of log(gamma(2 + z)), i.e.,
+    //     log(gamma(2 + z)) = (1 - gamma) z + sum_k (-1)^k (zeta(k) - 1) z^k / k,
+    // where gamma is the Euler-Mascheroni constant, to k = 31, which for
+    // |z| <= 1/2 is accurate to double precision.
+    inline constexpr auto taylor = []
+    {
+        std::array<double, 32> c{};
+        c[1] = double(1 - 0.577215664901532860606512090082402431L);
+        for (int k = 2; k < 32; ++k)
+            c[k] = double((k % 2 ? -1 : 1) * zeta_minus_one(k) / k);
+        return c;
+    }();
+
+    // log(gamma(x)) for x > 0.
+    template <typename T, typename M>
+    T log_gamma_of(T x)
+    {
+        // gamma(n) = (n-1)!.
+        if (x == std::floor(x) && x < T(table_size + 1))
+            return T(log_factorials[std::size_t(x) - 1]);
+        if (x >= T(stirling))
+            return stirling_series(x, T(-0.5), M::log(x));
+
+        // gamma(x) = gamma(x - m) (x-1) ... (x-m), or gamma(x + m) / (x (x+1) ... (x+m-1)),
+        // with z = x -/+ m - 2 in [-1/2, 1/2) computed exactly.
+        T z, shift;
+        if (x < T(0.5))
+        {
+            shift = -M::log(x * (x + T(1)));
+            z = x;
+        }
+        else if (x < T(1.5))
+        {
+            shift = -M::log(x);
+            z = x - T(1);
+        }
+        else
+        {
+            T p = T(1);
+            for (; x >= T(2.5); x = x - T(1))
+                p = p * (x - T(1));
+            shift = M::log(p);
+            z = x - T(2);
+        }
+
+        // the odd and even terms as two independent chains in z^2.
+        using std::fma;
+        auto const z2 = z * z;
+        auto odd = T(taylor[31]), even = T(taylor[30]);
+        for (int k = 29; k > 1; k -= 2)
+        {
+            odd = fma(odd, z2, T(taylor[k]));
+            even = fma(even, z2, T(taylor[k - 1]));
+        }
+        odd = fma(odd, z2, T(taylor[1]));
+        return fma(even, z, odd) * z + shift;
+    }
+
+    // log(n!) for any n.
+    template <typename T, typename M>
+    T log_factorial_of(std::uint64_t n)
+    {
+        if (n < table_size)
+            return T(log_factorials[n]);
+        auto const x = T(n);
+        return stirling_series(x, T(0.5), M::log(x));
+    }
+
+    // log(gamma(a)) - log(gamma(a + b)) for a >= 16, b > 0, without
+    // cancellation, since a/(a+b) = 1 - b/(a+b).
+    template <typename T, typename M>
+    T log_gamma_ratio(T const & a, T const & b)
+    {
+        using std::log1p;
+        auto const p = a + b;
+        return (a - T(0.5)) * log1p(-b / p) - b * M::log(p) + b + omega(a) - omega(p);
+    }
+}
+
+/**
+ * log_factorial : uint64 -> lg<T,M>
+ *
+ * n!.
+ */
+template <typename T = double, typename M = std_math>
+auto log_factorial(std::uint64_t n) { return lg<T,M>::from_log(log_gamma_detail::log_factorial_of<T,M>(n)); }
+
+/**
+ * log_gamma : T -> lg<T,M>
+ *
+ * gamma(x) for x > 0.
+ */
+template <typename M = std_math, typename T>
+auto log_gamma(T const & x)
+{
+    assert(T(0) < x);
+    return lg<T,M>::from_log(log_gamma_detail::log_gamma_of<T,M>(x));
+}
+
+/**
+ * gamma : lg<T,M> -> lg<T,M>
+ *
+ * gamma(x) for x > 0, where x is in the range of T.
+ */
+template <typename T, typename M>
+auto gamma(lg<T,M> const & x) { return log_gamma<M>((T)x); }
+
+/**
+ * log_binomial : (uint64, uint64) -> lg<T,M>
+ *
+ * n choose k for k <= n.
+ */
+template <typename T = double, typename M = std_math>
+auto log_binomial(std::uint64_t n, std::uint64_t k)
+{
+    using namespace log_gamma_detail;
+    using std::log1p;
+    assert(k <= n);
+
+    if (k == 0 || k == n)
+        return lg<T,M>::from_log(T(0));
+
+    // log(n!) - log(k!) - log((n-k)!), with the terms of Stirling's
+    // formula combined, i.e.,
+    //     n log n - k log k - (n-k) log(n-k) = k log(n/k) + (n-k) log(n/(n-k)).
+    auto const x = T(n), y = T(k), z = T(n - k);
+    auto const main = y * M::log(x / y) - z * log1p(-y / x);
+    auto const half = T(0.5) * M::log(x / (T(2) * T(3.14159265358979323846264338327950288L) * y * z));
+    return lg<T,M>::from_log(main + half + omega<T>(n) - omega<T>(k) - omega<T>(n - k));
+}
+
+/**
+ * log_beta : (T, T) -> lg<T,M>
+ *
+ * beta(a,b) := gamma(a) gamma(b) / gamma(a+b) for a, b > 0.
+ */
+template <typename M = std_math, typename T>
+auto log_beta(T a, T b)
+{
+    using namespace log_gamma_detail;
+    using std::log1p;
+    assert(T(0) < a && T(0) < b);
+
+    if (a < b)
+        std::swap(a, b);
+    auto const p = a + b;
+
+    // a >= b, so log(a/p) = log1p(-b/p) does not cancel.
+    if (b >= T(stirling))
+    {
+        auto const r = (a - T(0.5)) * log1p(-b / p) + (b - T(0.5)) * M::log(b / p) - T(0.5) * M::log(p) + T(half_log_2pi);
+        return lg<T,M>::from_log(r + omega(a) + omega(b) - omega(p));
+    }
+    if (a >= T(stirling))
+        return lg<T,M>::from_log(log_gamma_of<T,M>(b) + log_gamma_ratio<T,M>(a, b));
+    return lg<T,M>::from_log(log_gamma_of<T,M>(a) + log_gamma_of<T,M>(b) - log_gamma_of<T,M>(p));
+}
+
+/**
+ * log_factorial : ([uint64], [lg<T,M>]) -> void
+ *
+ * ys[i] := log_factorial(ns[i]), with the logs of the n beyond the table
+ * mapped by the batch M::log.
+ */
+template <typename T, typename M>
+void log_factorial(std::span<std::uint64_t const> ns, std::span<lg<T,M>> ys)
+{
+    using namespace log_gamma_detail;
+    assert(ns.size() == ys.size());
+
+    constexpr std::size_t block = 256;
+    T x[block], l[block];
+    for (std::size_t j = 0; j < ns.size(); j += block)
+    {
+        auto const n = std::min(block, ns.size() - j);
+        for (std::size_t i = 0; i < n; ++i)
+            x[i] = T(std::max<std::uint64_t>(ns[j + i], 1));
+        M::log(x, l, n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const k = ns[j + i] < table_size ? T(log_factorials[ns[j + i]])
+                : stirling_series(x[i], T(0.5), l[i]);
+            ys[j + i] = lg<T,M>::from_log(k);
+        }
+    }
+}
+
+/**
+ * log_gamma : ([T], [lg<T,M>]) -> void
+ *
+ * ys[i] := log_gamma(xs[i]), with the logs of the x >= 16 mapped by the
+ * batch M::log.
+ */
+template <typename T, typename M>
+void log_gamma(std::span<T const> xs, std::span<lg<T,M>> ys)
+{
+    using namespace log_gamma_detail;
+    assert(xs.size() == ys.size());
+
+    constexpr std::size_t block = 256;
+    T x[block], l[block];
+    for (std::size_t j = 0; j < xs.size(); j += block)
+    {
+        auto const n = std::min(block, xs.size() - j);
+        for (std::size_t i = 0; i < n; ++i)
+            x[i] = std::max(xs[j + i], T(stirling));
+        M::log(x, l, n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const k = xs[j + i] < T(stirling) ? log_gamma_detail::log_gamma_of<T,M>(xs[j + i]) : stirling_series(x[i], T(-0.5), l[i]);
+            ys[j + i] = lg<T,M>::from_log(k);
+        }
+    }
+}
@@ -0,0 +1,330 @@
+/**
+ * A binary file format for arrays of lg<T,M> and scaled<T,N,D>, and a
+ * memory-mapped reader for it, so arrays larger than memory are used in
+ * place and only the pages that are touched are read.
+ *
+ * A file is a 64-byte header followed by the payload, the stored
+ * values of the array (the exponents k for lg<T,M>, the scaled values k
+ * for scaled<T,N,D>), in the byte order of the writer. The payload
+ * starts at header::offset, which is a multiple of 64, so a mapped
+ * payload is as aligned as the exponents of an lg_vector.
+ *
+ * The header records what the payload is:
+ *     magic       "HCEARRAY"
+ *     version     of the format, currently 1
+ *     byte_order  0x01020304 as written by the writer
+ *     kind        1 for lg, 2 for scaled
+ *     value_kind  1 for IEEE floating point T, 0 otherwise
+ *     value_size  sizeof(T)
+ *     num, den    the scale N/D of scaled<T,N,D>, 1/1 for lg
+ *     count       number of values
+ *     offset      of the payload from the start of the file.
+ * The math policy M of lg<T,M> is not recorded, since it does not
+ * change the exponents.
+ *
+ * mapped_array<E> maps a file and checks that its header matches E and
+ * the byte order of the reader, or throws std::runtime_error. The
+ * values are then a std::span<E const> (or an lg_view<T const,M>) over
+ * the mapping. chunks(n) iterates over the values n at a time, and
+ * tells the kernel to read the next chunks ahead of the iterator
+ * (madvise with MADV_WILLNEED), so a streaming pass over a file does
+ * not wait on each page fault.
+ *
+ * The reader uses POSIX mmap.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "lg_vector.hpp"
+#include "scaled.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct array_file_header
+{
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t native_order = 0x01020304;
+
+    char magic[8] = { 'H', 'C', 'E', 'A', 'R', 'R', 'A', 'Y' };
+    std::uint32_t version = current_version;
+    std::uint32_t byte_order = native_order;
+    std::uint32_t kind = 0;
+    std::uint32_t value_kind = 0;
+    std::uint32_t value_size = 0;
+    std::uint32_t reserved = 0;
+    std::int64_t num = 1;
+    std::int64_t den = 1;
+    std::uint64_t count = 0;
+    std::uint64_t offset = 64;
+};
+
+static_assert(sizeof(array_file_header) == 64 && std::is_trivially_copyable_v<array_file_header>);
+
+namespace mapped_array_detail
+{
+    template <typename E>
+    struct traits;
+
+    template <typename T, typename M>
+    struct traits<lg<T,M>>
+    {
+        using value_type = T;
+        static constexpr std::uint32_t kind = 1;
+        static constexpr std::int64_t num = 1;
+        static constexpr std::int64_t den = 1;
+    };
+
+    template <typename T, int N, int D>
+    struct traits<scaled<T,N,D>>
+    {
+        using value_type = T;
+        static constexpr std::uint32_t kind = 2;
+        static constexpr std::int64_t num = N;
+        static constexpr std::int64_t den = D;
+    };
+
+    // the header of a file of n values of type E.
+    template <typename E>
+    array_file_header header_of(std::uint64_t n)
+    {
+        using T = typename traits<E>::value_type;
+        static_assert(sizeof(E) == sizeof(T));
+
+        array_file_header h;
+        h.kind = traits<E>::kind;
+        h.value_kind = std::numeric_limits<T>::is_iec559;
+        h.value_size = sizeof(T);
+        h.num = traits<E>::num;
+        h.den = traits<E>::den;
+        h.count = n;
+        return h;
+    }
+
+    inline std::size_t page_size()
+    {
+        static std::size_t const n = ::sysconf(_SC_PAGESIZE);
+        return n;
+    }
+}
+
+/**
+ * write_array_file : (path, [E]) -> void
+ *
+ * Writes the values of xs, where E is lg<T,M> or scaled<T,N,D>, to a
+ * new file at path. Throws std::runtime_error if the file cannot be
+ * written.
+ */
+template <typename E>
+void write_array_file(std::string const & path, std::span<E const> xs)
+{
+    auto const h = mapped_array_detail::header_of<E>(xs.size());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+    out.write(reinterpret_cast<char const *>(xs.data()), xs.size_bytes());
+    out.close();
+    if (!out)
+        throw std::runtime_error("write_array_file: cannot write " + path);
+}
+
+template <std::ranges::contiguous_range R>
+void write_array_file(std::string const & path, R const & xs)
+{
+    write_array_file(path, std::span<std::ranges::range_value_t<R> const>(xs));
+}
+
+template <typename E>
+class mapped_array
+{
+public:
+    using value_type = E;
+    using size_type = std::size_t;
+
+    explicit mapped_array(std::string const & path)
+    {
+        int const fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "mapped_array: cannot open " + path);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            auto const e = errno;
+            ::close(fd);
+            throw std::system_error(e, std::generic_category(), "mapped_array: cannot stat " + path);
+        }
+
+        bytes_ = st.st_size;
+        if (bytes_ >= sizeof(array_file_header))
+            base_ = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        auto const e = errno;
+        ::close(fd);
+        if (base_ == MAP_FAILED || base_ == nullptr)
+        {
+            base_ = nullptr;
+            if (bytes_ < sizeof(array_file_header))
+                throw std::runtime_error("mapped_array: " + path + " is too short to be an array file");
+            throw std::system_error(e, std::generic_category(), "mapped_array: cannot map " + path);
+        }
+
+        std::memcpy(&header_, base_, sizeof(header_));
+        if (auto const error = check(); error)
+        {
+            unmap();
+            throw std::runtime_error("mapped_array: " + path + ": " + error);
+        }
+        data_ = reinterpret_cast<E const *>(static_cast<char const *>(base_) + header_.offset);
+    }
+
+    mapped_array(mapped_array && other) noexcept :
+        header_(other.header_), base_(other.base_), bytes_(other.bytes_), data_(other.data_)
+    {
+        other.base_ = nullptr;
+    }
+
+    mapped_array(mapped_array const &) = delete;
+    mapped_array & operator=(mapped_array const &) = delete;
+
+    ~mapped_array() { unmap(); }
+
+    array_file_header const & header() const { return header_; }
+
+    size_type size() const { return header_.count; }
+    bool empty() const { return size() == 0; }
+    E const * data() const { return data_; }
+    E const & operator[](size_type i) const { return data_[i]; }
+    E const * begin() const { return data_; }
+    E const * end() const { return data_ + size(); }
+
+    std::span<E const> values() const { return { data_, size() }; }
+
+    // the values as lg<T,M>, without copying.
+    auto view() const requires (mapped_array_detail::traits<E>::kind == 1)
+    {
+        using T = typename mapped_array_detail::traits<E>::value_type;
+        return lg_view<T const, typename E::math>(reinterpret_cast<T const *>(data_), size());
+    }
+
+    /**
+     * Advises the kernel about the pages of the values [first, first + n),
+     * e.g., MADV_WILLNEED to read them ahead or MADV_DONTNEED to drop
+     * them after a pass.
+     */
+    void advise(size_type first, size_type n, int advice) const
+    {
+        first = std::min(first, size());
+        n = std::min(n, size() - first);
+        if (n == 0)
+            return;
+        auto const page = mapped_array_detail::page_size();
+        auto const begin = reinterpret_cast<std::uintptr_t>(data_ + first) / page * page;
+        auto const end = reinterpret_cast<std::uintptr_t>(data_ + first + n);
+        ::madvise(reinterpret_cast<void *>(begin), end - begin, advice);
+    }
+
+    class chunk_iterator
+    {
+    public:
+        using value_type = std::span<E const>;
+        using difference_type = std::ptrdiff_t;
+
+        chunk_iterator() = default;
+        chunk_iterator(mapped_array const * a, size_type i, size_type n, size_type ahead) :
+            a_(a), i_(i), n_(n), ahead_(ahead) {}
+
+        value_type operator*() const { return a_->values().subspan(i_, std::min(n_, a_->size() - i_)); }
+
+        chunk_iterator & operator++()
+        {
+            i_ = std::min(a_->size(), i_ + n_);
+            a_->advise(i_ + ahead_ * n_, n_, MADV_WILLNEED);
+            return *this;
+        }
+
+        chunk_iterator operator++(int)
+        {
+            auto const c = *this;
+            ++*this;
+            return c;
+        }
+
+        bool operator==(chunk_iterator const & rhs) const { return i_ == rhs.i_; }
+
+    private:
+        mapped_array const * a_ = nullptr;
+        size_type i_ = 0;
+        size_type n_ = 1;
+        size_type ahead_ = 0;
+    };
+
+    struct chunk_range
+    {
+        chunk_iterator first, last;
+        chunk_iterator begin() const { return first; }
+        chunk_iterator end() const { return last; }
+    };
+
+    /**
+     * chunks : (n, ahead) -> [span<E const>]
+     *
+     * The values n at a time (the last chunk may be shorter), where the
+     * ahead chunks after the current one are read ahead.
+     */
+    chunk_range chunks(size_type n, size_type ahead = 2) const
+    {
+        n = std::max<size_type>(n, 1);
+        advise(0, (ahead + 1) * n, MADV_WILLNEED);
+        return { chunk_iterator(this, 0, n, ahead), chunk_iterator(this, size(), n, ahead) };
+    }
+
+private:
+    // a description of what is wrong with the header, or nullptr.
+    char const * check() const
+    {
+        auto const expected = mapped_array_detail::header_of<E>(header_.count);
+        if (std::memcmp(header_.magic, expected.magic, sizeof(header_.magic)) != 0)
+            return "not an array file";
+        if (header_.version != array_file_header::current_version)
+            return "unsupported version";
+        if (header_.byte_order != array_file_header::native_order)
+            return "byte order differs from this machine";
+        if (header_.kind != expected.kind || header_.value_kind != expected.value_kind ||
+            header_.value_size != expected.value_size)
+            return "value type differs from the requested type";
+        if (header_.num != expected.num || header_.den != expected.den)
+            return "scale differs from the requested scale";
+        if (header_.offset % alignof(E) != 0 || header_.offset > bytes_ ||
+            header_.count > (bytes_ - header_.offset) / sizeof(E))
+            return "file is truncated";
+        return nullptr;
+    }
+
+    void unmap()
+    {
+        if (base_)
+            ::munmap(base_, bytes_);
+        base_ = nullptr;
+    }
+
+    array_file_header header_;
+    void * base_ = nullptr;
+    std::size_t bytes_ = 0;
+    E const * data_ = nullptr;
+};
@@ -0,0 +1,194 @@
+/**
+ * neumaier<T> is a floating point number type T that accumulates very
+ * little rounding error on addition, as suggested in lg.hpp for the
+ * exponent type of lg<T>, i.e., the product
+ *     lg<neumaier<T>>(x1) * ... * lg<neumaier<T>>(xn)
+ * is the compensated sum
+ *     log(x1) + ... + log(xn)
+ * and its error does not grow with n.
+ *
+ * A value is the unevaluated sum s + c, where s is the running sum and
+ * c is the running compensation, i.e., the sum of the rounding errors
+ * of the additions into s (Neumaier's improvement of Kahan summation).
+ * The rounding error of a + b is computed exactly with Knuth's branch
+ * free two-sum
+ *     t := a + b,  e := (a - (t - (t - a))) + (b - (t - a)),
+ * rather than Neumaier's comparison of |a| and |b|, so that the same
+ * code runs on simd::pack (see neumaier_sum below and product in
+ * lg_batch.hpp).
+ *
+ * neumaier<T> models the ring required by lg<T>, with
+ *     log : neumaier<T> -> neumaier<T>
+ *     exp : neumaier<T> -> neumaier<T>
+ * found by argument-dependent lookup, so std_math works with it. The
+ * products, quotients, log and exp carry the compensation through to
+ * first order, so they are about as accurate as the same operation on
+ * T applied to the exact value s + c.
+ *
+ * The two-sum is only exact if additions are evaluated in the precision
+ * of T, i.e., FLT_EVAL_METHOD == 0 (not the x87 unit), and are not
+ * reassociated, so do not compile with -ffast-math.
+ */
+
+#pragma once
+
+#include "simd.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+template <typename T>
+struct neumaier
+{
+    using value_type = T;
+
+    // running sum.
+    T s;
+    // running compensation.
+    T c;
+
+    neumaier() : s(T(0)), c(T(0)) {}
+    neumaier(T x) : s(x), c(T(0)) {}
+    neumaier(T s, T c) : s(s), c(c) {}
+
+    // the value s + c, rounded to T.
+    T value() const { return s + c; }
+
+    explicit operator T() const { return value(); }
+
+    // the same value with |c| at most half an ulp of s.
+    neumaier normalized() const
+    {
+        auto const t = s + c;
+        return neumaier(t, c - (t - s));
+    }
+
+    neumaier & operator+=(neumaier const & y)
+    {
+        auto const t = s + y.s;
+        auto const b = t - s;
+        c = c + y.c + ((s - (t - b)) + (y.s - b));
+        s = t;
+        return *this;
+    }
+
+    neumaier & operator-=(neumaier const & y) { return *this += -y; }
+
+    friend neumaier operator-(neumaier const & x) { return neumaier(-x.s, -x.c); }
+    friend neumaier operator+(neumaier x, neumaier const & y) { return x += y; }
+    friend neumaier operator-(neumaier x, neumaier const & y) { return x += -y; }
+
+    friend neumaier operator*(neumaier const & x, neumaier const & y)
+    {
+        using std::fma;
+        auto const p = x.s * y.s;
+        return neumaier(p, fma(x.s, y.s, -p) + (x.s * y.c + x.c * y.s));
+    }
+
+    friend neumaier operator/(neumaier const & x, neumaier const & y)
+    {
+        using std::fma;
+        auto const q = x.s / y.s;
+        return neumaier(q, (fma(-q, y.s, x.s) + x.c - q * y.c) / y.s);
+    }
+
+    friend bool operator<(neumaier const & x, neumaier const & y) { return x.value() < y.value(); }
+    friend bool operator<=(neumaier const & x, neumaier const & y) { return x.value() <= y.value(); }
+    friend bool operator>(neumaier const & x, neumaier const & y) { return x.value() > y.value(); }
+    friend bool operator>=(neumaier const & x, neumaier const & y) { return x.value() >= y.value(); }
+    friend bool operator==(neumaier const & x, neumaier const & y) { return x.value() == y.value(); }
+    friend bool operator!=(neumaier const & x, neumaier const & y) { return x.value() != y.value(); }
+
+    /**
+     * log : neumaier<T> -> neumaier<T>
+     *
+     * log(s + c) = log(s) + log(1 + c/s) ~ log(s) + c/s.
+     */
+    friend neumaier log(neumaier const & x)
+    {
+        using std::log;
+        auto const y = x.normalized();
+        return neumaier(log(y.s), y.c / y.s);
+    }
+
+    /**
+     * exp : neumaier<T> -> neumaier<T>
+     *
+     * exp(s + c) = exp(s) * exp(c) ~ exp(s) + exp(s) * c.
+     */
+    friend neumaier exp(neumaier const & x)
+    {
+        using std::exp;
+        auto const y = x.normalized();
+        auto const e = exp(y.s);
+        return neumaier(e, e * y.c);
+    }
+};
+
+template <typename T>
+struct std::numeric_limits<neumaier<T>>
+{
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool has_infinity = numeric_limits<T>::has_infinity;
+    static auto max() { return neumaier<T>(numeric_limits<T>::max()); }
+    static auto min() { return neumaier<T>(numeric_limits<T>::min()); }
+    static auto lowest() { return neumaier<T>(numeric_limits<T>::lowest()); }
+    static auto infinity() { return neumaier<T>(numeric_limits<T>::infinity()); }
+    static auto epsilon() { return neumaier<T>(numeric_limits<T>::epsilon()); }
+};
+
+/**
+ * neumaier_sum : (T*,n) -> neumaier<T>
+ *
+ * The compensated sum of n contiguous values. Like simd::sum, it uses
+ * simd::lanes independent pack accumulators, each with its own pack of
+ * compensations, so the two-sum runs pack<T>::width values at a time
+ * and costs a few independent additions per pack rather than a longer
+ * dependency chain.
+ */
+namespace neumaier_detail
+{
+    // s + y by two-sum, with the rounding error added to c.
+    template <typename P>
+    void add(P & s, P & c, P const & y)
+    {
+        auto const t = s + y;
+        auto const b = t - s;
+        c = c + ((s - (t - b)) + (y - b));
+        s = t;
+    }
+}
+
+template <typename T>
+neumaier<T> neumaier_sum(T const * x, std::size_t n)
+{
+    using P = simd::pack<T>;
+    constexpr auto w = P::width;
+
+    auto s0 = P::broadcast(T(0)), s1 = s0, s2 = s0, s3 = s0;
+    auto c0 = s0, c1 = s0, c2 = s0, c3 = s0;
+    std::size_t i = 0;
+    for (; i + simd::lanes * w <= n; i += simd::lanes * w)
+    {
+        neumaier_detail::add(s0, c0, P::load(x + i));
+        neumaier_detail::add(s1, c1, P::load(x + i + w));
+        neumaier_detail::add(s2, c2, P::load(x + i + 2 * w));
+        neumaier_detail::add(s3, c3, P::load(x + i + 3 * w));
+    }
+
+    // the lanes of the sums are combined by two-sum as well.
+    neumaier<T> r;
+    T buf[w];
+    for (auto const & s : { s0, s1, s2, s3 })
+    {
+        s.store(buf);
+        for (std::size_t k = 0; k < w; ++k)
+            r += buf[k];
+    }
+    r.c = r.c + ((c0 + c1) + (c2 + c3)).sum();
+    for (; i < n; ++i)
+        r += x[i];
+    return r;
+}
@@ -24,30 +24,40 @@
 #include <functional>
 using std::function;
 
+/**
+ * The state of a safe<T> is computed on construction by the predicates
+ *     source_overflows : T -> bool
+ *     source_underflows : T -> bool,
+ * which are found by argument-dependent lookup, e.g., those of lg<T> in
+ * lg.hpp.
+ */
 template <typename T>
 struct safe
 {
-    enum State { valid, overflow, underflow };
-    State state; 
-    T value;
+    enum class State { valid, overflow, underflow };
+    State state;
+    T x;
 
-    safe() : state(valid), value(T::value_type(0)) {}
+    safe() : state(State::valid), x() {}
 
-    safe(T const & x) : value(x)
+    safe(T const & x) : x(x)
     {
-        if (typename T::overflow_to<T::value_type>(x))
-            state = overflow;
-        else if (typename T::underflow_to<T::value_type>(x))
-            state = underflow;
+        if (source_overflows(x))
+            state = State::overflow;
+        else if (source_underflows(x))
+            state = State::underflow;
         else
-            state = valid;
+            state = State::valid;
     }
 
-    bool invalid() const { return state != valid; }
-    bool valid() const { return state == valid; }
-    bool overflow() const { return state == overflow; }
-    bool underflow() const { return state == underflow; }
-    T value() const { return value; }
+    // an invalid value in state s.
+    explicit safe(State s) : state(s), x() {}
+
+    bool invalid() const { return state != State::valid; }
+    bool valid() const { return state == State::valid; }
+    bool overflow() const { return state == State::overflow; }
+    bool underflow() const { return state == State::underflow; }
+    T value() const { return x; }
 };
 
 /**
@@ -55,27 +65,29 @@ struct safe
  * In some cases, it may just know that it's possible, in other
  * cases it may detect exactly when.
  */
-template <template <typename> typename Safe, class X, class Y>
-safe<Safe<Y>> fmap(function<Y(X)> f, safe<Safe<X>> x) 
+template <template <typename, typename...> typename Safe, typename X, typename Y, typename... A>
+safe<Safe<Y,A...>> fmap(function<Y(X)> f, safe<Safe<X,A...>> x)
 {
+    using R = safe<Safe<Y,A...>>;
+
     if (x.invalid())
-        return safe<Safe<Y>>{ x.state };
+        return R(typename R::State(x.state));
+
+    if (source_overflows(x.value()))
+        return R(R::State::overflow);
 
-    if (typename Safe<X>::overflow_to<X>(x))
-        return safe<Safe<Y>>{ overflow };
-    
-    if (typename Safe<X>::underflow_to<X>(x))
-        return safe<Safe<Y>>{ underflow };        
+    if (source_underflows(x.value()))
+        return R(R::State::underflow);
 
     // we can safely convert x of type Safe<X> to X.
 
-    auto unsafe_x = (X)x;
+    auto unsafe_x = (X)x.value();
     // we denote the value of type X unsafe_x, since
     // X is an unsafe type.
 
     auto y = f(unsafe_x);
-    // y is a B, also an unsafe type.
-    // if f : A -> B has a problem on unsafe_x,
+    // y is a Y, also an unsafe type.
+    // if f : X -> Y has a problem on unsafe_x,
     // such as overflowing, then y is in an
     // invalid state.
 
@@ -84,7 +96,7 @@ safe<Safe<Y>> fmap(function<Y(X)> f, safe<Safe<X>> x)
     // be able to detect invalid states),
     // a precondition on Safe types is that the
     // function to be lifted, f, is total.
-    
+
     // now we convert the unsafe type Y to Safe<Y>.
-    return safe<Safe<B>>(y);
+    return R(Safe<Y,A...>(y));
 }
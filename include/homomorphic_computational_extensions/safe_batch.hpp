@@ -0,0 +1,242 @@
+/**
+ * safe_batch<lg<T,M>> is a batch of values of type safe<lg<T,M>> (see
+ * safe.hpp), stored as a structure of arrays: the exponents are an
+ * lg_vector<T,M>, and the states are two packed bitmasks, one bit per
+ * value for overflow and one for underflow. So a batch of n values of
+ * safe<lg<float>> takes 4n bytes and n/4 bytes rather than the 8n bytes
+ * of n values of safe<lg<float>> with their State enum.
+ *
+ * A value overflows (underflows) if converting it to T does, i.e., if
+ * its exponent is above M::log(numeric_limits<T>::max()) (below
+ * M::log(numeric_limits<T>::min())). The states are computed a pack at
+ * a time, from the comparison masks of the packs (see simd.hpp). A NaN
+ * exponent is not in the range either, and underflows.
+ *
+ * fmap lifts a function f : T -> T to the whole batch,
+ *     fmap f : safe_batch<lg<T,M>> -> safe_batch<lg<T,M>>.
+ * f is called on packs, e.g., f := [](auto x) { return x * x; }, since
+ * simd::pack<T> (and simd::scalar<T>, for the tail) model T. Every
+ * value is mapped to T with the batch M::exp, passed through f, and
+ * mapped back with the batch M::log, whether or not it is valid. The
+ * invalid values are then restored by selects on the bitmasks and keep
+ * their state, so an invalid value propagates without a branch:
+ *     overflow'  := overflow  | (valid & overflows(f(x)))
+ *     underflow' := underflow | (valid & underflows(f(x))).
+ * f(x) <= 0 is not a value of lg<T,M>: its M::log is -inf or NaN, so the
+ * value underflows, as if f(x) were too small for T.
+ *
+ * to_source converts a sequence of lg<T,M> back to T and classifies it
+ * in the same pass, a block at a time: the batch M::exp of a block is
+ * followed by the comparisons of its exponents while they are still in
+ * cache, and the states are written as the same packed bitmasks, so a
+ * caller checks 64 values per word rather than branching per value.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "lg_vector.hpp"
+#include "safe.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+template <typename E>
+class safe_batch;
+
+namespace safe_batch_detail
+{
+    // values per block, a multiple of the 64 bits of a word of a mask.
+    inline constexpr std::size_t block = 256;
+
+    inline std::size_t words(std::size_t n) { return (n + 63) / 64; }
+
+    inline bool bit(std::vector<std::uint64_t> const & m, std::size_t i) { return (m[i / 64] >> (i % 64)) & 1; }
+
+    /**
+     * Sets the bits of over (under) for the n exponents k, which start at
+     * a multiple of 64, that are above hi (below lo, or NaN).
+     */
+    template <typename T>
+    void classify(T const * k, std::size_t n, T lo, T hi, std::uint64_t * over, std::uint64_t * under)
+    {
+        using P = simd::pack<T>;
+        using S = simd::scalar<T>;
+        static_assert(64 % P::width == 0);
+
+        std::fill(over, over + words(n), 0);
+        std::fill(under, under + words(n), 0);
+        std::size_t const m = n - n % P::width;
+        for (std::size_t i = 0; i < m; i += P::width)
+        {
+            auto const x = P::load(k + i);
+            over[i / 64] |= std::uint64_t((P::broadcast(hi) < x).bits()) << (i % 64);
+            under[i / 64] |= std::uint64_t((!(P::broadcast(lo) <= x)).bits()) << (i % 64);
+        }
+        for (std::size_t i = m; i < n; ++i)
+        {
+            auto const x = S::load(k + i);
+            over[i / 64] |= std::uint64_t((S::broadcast(hi) < x).bits()) << (i % 64);
+            under[i / 64] |= std::uint64_t((!(S::broadcast(lo) <= x)).bits()) << (i % 64);
+        }
+    }
+}
+
+template <typename T, typename M>
+class safe_batch<lg<T,M>>
+{
+public:
+    using value_type = safe<lg<T,M>>;
+    using size_type = std::size_t;
+
+    safe_batch() = default;
+
+    explicit safe_batch(std::span<lg<T,M> const> xs) : k_(xs), over_(safe_batch_detail::words(xs.size())),
+        under_(safe_batch_detail::words(xs.size()))
+    {
+        safe_batch_detail::classify(k_.exponents().data(), size(), lo(), hi(), over_.data(), under_.data());
+    }
+
+    explicit safe_batch(lg_vector<T,M> xs) : k_(std::move(xs)), over_(safe_batch_detail::words(k_.size())),
+        under_(safe_batch_detail::words(k_.size()))
+    {
+        safe_batch_detail::classify(k_.exponents().data(), size(), lo(), hi(), over_.data(), under_.data());
+    }
+
+    size_type size() const { return k_.size(); }
+    bool empty() const { return k_.empty(); }
+
+    // the value i as a safe<lg<T,M>>.
+    value_type operator[](size_type i) const
+    {
+        if (overflow(i))
+            return value_type(value_type::State::overflow);
+        if (underflow(i))
+            return value_type(value_type::State::underflow);
+        return value_type(k_[i]);
+    }
+
+    bool overflow(size_type i) const { return safe_batch_detail::bit(over_, i); }
+    bool underflow(size_type i) const { return safe_batch_detail::bit(under_, i); }
+    bool invalid(size_type i) const { return overflow(i) || underflow(i); }
+    bool valid(size_type i) const { return !invalid(i); }
+
+    // the number of valid values.
+    size_type count_valid() const
+    {
+        size_type n = size();
+        for (std::size_t w = 0; w < over_.size(); ++w)
+            n -= std::popcount(over_[w] | under_[w]);
+        return n;
+    }
+
+    // the values, which are only meaningful where they are valid.
+    lg_vector<T,M> const & values() const { return k_; }
+
+    // bit i%64 of word i/64 is set if value i overflows (underflows).
+    std::span<std::uint64_t const> overflow_mask() const { return over_; }
+    std::span<std::uint64_t const> underflow_mask() const { return under_; }
+
+    // the range of exponents that convert to T.
+    static T lo() { return M::log(numeric_limits<T>::min()); }
+    static T hi() { return M::log(numeric_limits<T>::max()); }
+
+    template <typename F>
+    friend safe_batch fmap(F f, safe_batch const & x)
+    {
+        using P = simd::pack<T>;
+        using S = simd::scalar<T>;
+        constexpr auto block = safe_batch_detail::block;
+
+        auto const n = x.size();
+        safe_batch r;
+        r.k_.resize(n);
+        r.over_.resize(x.over_.size());
+        r.under_.resize(x.under_.size());
+
+        auto const k = x.k_.exponents().data();
+        auto const rk = r.k_.exponents().data();
+        T buf[block];
+        std::uint64_t over[block / 64], under[block / 64];
+        for (std::size_t i = 0; i < n; i += block)
+        {
+            auto const bn = std::min(block, n - i);
+            M::exp(k + i, buf, bn);
+            std::size_t const m = bn - bn % P::width;
+            for (std::size_t j = 0; j < m; j += P::width)
+                f(P::load(buf + j)).store(buf + j);
+            for (std::size_t j = m; j < bn; ++j)
+                f(S::load(buf + j)).store(buf + j);
+            M::log(buf, buf, bn);
+            safe_batch_detail::classify(buf, bn, lo(), hi(), over, under);
+
+            for (std::size_t w = 0; w < safe_batch_detail::words(bn); ++w)
+            {
+                auto const invalid = x.over_[i / 64 + w] | x.under_[i / 64 + w];
+                r.over_[i / 64 + w] = x.over_[i / 64 + w] | (~invalid & over[w]);
+                r.under_[i / 64 + w] = x.under_[i / 64 + w] | (~invalid & under[w]);
+            }
+            for (std::size_t j = 0; j < bn; ++j)
+            {
+                auto const w = (i + j) / 64, b = (i + j) % 64;
+                rk[i + j] = ((x.over_[w] | x.under_[w]) >> b) & 1 ? k[i + j] : buf[j];
+            }
+        }
+        return r;
+    }
+
+private:
+    lg_vector<T,M> k_;
+    std::vector<std::uint64_t> over_;
+    std::vector<std::uint64_t> under_;
+};
+
+/**
+ * to_source : ([lg<T,M>], [T], [uint64], [uint64]) -> size_t
+ *
+ * ys[i] := T(xs[i]) by the batch M::exp, with bit i%64 of word i/64 of
+ * over (under) set if xs[i] overflows (underflows) as in safe_batch,
+ * and returns the number of values that do either. over and under hold
+ * at least (n + 63)/64 words.
+ */
+template <typename T, typename M>
+std::size_t to_source(std::span<lg<T,M> const> xs, std::span<T> ys, std::span<std::uint64_t> over, std::span<std::uint64_t> under)
+{
+    using namespace safe_batch_detail;
+    static_assert(sizeof(lg<T,M>) == sizeof(T));
+    auto const n = xs.size();
+    assert(ys.size() == n && over.size() >= words(n) && under.size() >= words(n));
+
+    auto const k = reinterpret_cast<T const *>(xs.data());
+    auto const lo = safe_batch<lg<T,M>>::lo(), hi = safe_batch<lg<T,M>>::hi();
+    std::size_t invalid = 0;
+    for (std::size_t i = 0; i < n; i += block)
+    {
+        auto const bn = std::min(block, n - i);
+        M::exp(k + i, ys.data() + i, bn);
+        classify(k + i, bn, lo, hi, over.data() + i / 64, under.data() + i / 64);
+        for (std::size_t w = i / 64; w < i / 64 + words(bn); ++w)
+            invalid += std::popcount(over[w] | under[w]);
+    }
+    return invalid;
+}
+
+/**
+ * to_source : (safe_batch<lg<T,M>>, [T]) -> void
+ *
+ * ys[i] := T(x[i]) for the values of a batch, whose states are already
+ * known; the invalid values convert to whatever M::exp gives.
+ */
+template <typename T, typename M>
+void to_source(safe_batch<lg<T,M>> const & x, std::span<T> ys)
+{
+    assert(ys.size() == x.size());
+    M::exp(x.values().exponents().data(), ys.data(), x.size());
+}
@@ -0,0 +1,182 @@
+/**
+ * Pipelines of functions lifted into safe<Safe<X>> (see safe.hpp) as one
+ * function, i.e., for stages
+ *     f1 : X -> X,  ...,  fn : X -> Y,
+ * pipe(f1,...,fn) is the composition fn . ... . f1, and
+ *     fmap(pipe(f1,...,fn), x) : safe<Safe<X>> -> safe<Safe<Y>>
+ * converts x to X once, runs every stage inline on the unsafe value and
+ * converts the result back to Safe<Y> once. So there is one check of
+ * the state of x before the chain and one check of the result after
+ * it, rather than a conversion to X, a conversion back to Safe<X> and a
+ * check of the state around each stage, as in the composition
+ *     fmap(fn, ... fmap(f1, x)),
+ * and the stages are inlined rather than called through std::function.
+ *
+ * As with fmap, the stages are required to be total on the values they
+ * are applied to, so a stage that overflows must do so visibly in the
+ * result, e.g., as inf.
+ *
+ * Range analysis
+ * --------------
+ * A stage may declare a bound on its growth,
+ *     log|f(x)| in a*log|x| + [lo,hi],
+ * e.g., x*x has the bound (2,0,0) and x+x the bound (1,log(2),log(2)).
+ * If every stage declares one, the pipeline maps the interval of log|x|
+ * through the stages, and if every intermediate value and the result
+ * provably convert to T, the check of the result is skipped. For
+ * Safe := lg, log|x| is the exponent of x, so the analysis is a few
+ * multiply-adds per stage and no transcendental function.
+ *
+ * The stages are called with X, or with simd::pack<X>, so a pipeline is
+ * also a function that fmap of safe_batch accepts.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "safe.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * A bound on the growth of a function f, i.e.,
+ *     a*log|x| + lo <= log|f(x)| <= a*log|x| + hi.
+ */
+struct growth
+{
+    double a = 1;
+    double lo = 0;
+    double hi = 0;
+};
+
+template <typename F>
+struct bounded_stage
+{
+    F f;
+    growth bound;
+
+    template <typename X>
+    auto operator()(X const & x) const { return f(x); }
+};
+
+/**
+ * bounded : (f, growth) -> stage
+ *
+ * Declares the growth of f to a pipeline.
+ */
+template <typename F>
+auto bounded(F f, growth g) { return bounded_stage<F>{ std::move(f), g }; }
+
+namespace safe_pipeline_detail
+{
+    template <typename F>
+    struct is_bounded : std::false_type {};
+
+    template <typename F>
+    struct is_bounded<bounded_stage<F>> : std::true_type {};
+
+    template <typename X, typename F>
+    auto chain(X const & x, F const & f) { return f(x); }
+
+    template <typename X, typename F, typename... G>
+    auto chain(X const & x, F const & f, G const & ... g) { return chain(f(x), g...); }
+
+    // log|x| for the types where it is exact and cheap.
+    template <typename T, typename M>
+    T log_abs(lg<T,M> const & x) { return x.k; }
+
+    template <typename S>
+    concept has_log_abs = requires(S const & x) { log_abs(x); };
+}
+
+template <typename... F>
+struct pipeline
+{
+    std::tuple<F...> stages;
+
+    // whether every stage declares its growth.
+    static constexpr bool bounded = (safe_pipeline_detail::is_bounded<F>::value && ...);
+
+    template <typename X>
+    auto operator()(X const & x) const
+    {
+        return std::apply([&](auto const & ... f) { return safe_pipeline_detail::chain(x, f...); }, stages);
+    }
+
+    /**
+     * Whether, given log|x| = k, log|y| stays in [lo,hi] for the value y
+     * after every stage. Requires bounded.
+     */
+    template <typename T>
+    bool in_range(T k, T lo, T hi) const requires bounded
+    {
+        T l = k, h = k;
+        bool ok = lo <= k && k <= hi;
+        std::apply([&](auto const & ... f)
+        {
+            ((ok = ok && step(f.bound, l, h, lo, hi)), ...);
+        }, stages);
+        return ok;
+    }
+
+private:
+    template <typename T>
+    static bool step(growth const & g, T & l, T & h, T lo, T hi)
+    {
+        auto const a = T(g.a);
+        auto const nl = (a < T(0) ? a * h : a * l) + T(g.lo);
+        auto const nh = (a < T(0) ? a * l : a * h) + T(g.hi);
+        l = nl;
+        h = nh;
+        return lo <= l && h <= hi;
+    }
+};
+
+/**
+ * pipe : (f1,...,fn) -> pipeline
+ *
+ * The composition fn . ... . f1.
+ */
+template <typename... F>
+auto pipe(F... fs) { return pipeline<F...>{ std::tuple<F...>(std::move(fs)...) }; }
+
+/**
+ * fmap : (pipeline, safe<Safe<X>>) -> safe<Safe<Y>>
+ */
+template <template <typename, typename...> typename Safe, typename X, typename... A, typename... F>
+auto fmap(pipeline<F...> const & p, safe<Safe<X,A...>> const & x)
+{
+    using Y = std::remove_cvref_t<decltype(p(std::declval<X>()))>;
+    using R = safe<Safe<Y,A...>>;
+
+    if (x.invalid())
+        return R(typename R::State(x.state));
+
+    auto const y = p((X)x.value());
+
+    if constexpr (pipeline<F...>::bounded && safe_pipeline_detail::has_log_abs<Safe<X,A...>>)
+    {
+        using std::log;
+        static X const lo = log(numeric_limits<X>::min());
+        static X const hi = log(numeric_limits<X>::max());
+        if (p.in_range(safe_pipeline_detail::log_abs(x.value()), lo, hi))
+        {
+            R r;
+            r.x = Safe<Y,A...>(y);
+            return r;
+        }
+    }
+    return R(Safe<Y,A...>(y));
+}
+
+/**
+ * fmap : (f, safe<Safe<X>>) -> safe<Safe<Y>>
+ *
+ * A single stage, without std::function.
+ */
+template <template <typename, typename...> typename Safe, typename X, typename... A, typename F>
+auto fmap(F f, safe<Safe<X,A...>> const & x) { return fmap(pipe(std::move(f)), x); }
@@ -26,6 +26,23 @@
  * 
  * Most operations on T can be lifted to operations
  * on scaled<T> trivially.
+ *
+ * When N/D is a power of two, 2^p, scaling by it is an
+ * adjustment of the exponent rather than a rounded
+ * multiply or divide. This is detected at compile time,
+ * and then a value x is scaled as x * 2^p (or x << p for
+ * integral T), which is exact unless it overflows or
+ * underflows T. As a result, *, /, inv and the conversions
+ * round at most once, like the same operations on T, and
+ * the constant log(D/N) = -p log(2) in log is folded at
+ * compile time. A fixed-point Q8 value, for example, is
+ * scaled<std::int32_t,256,1>. For integral T, * and / are
+ * computed in a type twice as wide, * divides the product by
+ * the scale rather than shifting it, and / and inv scale the
+ * numerator before dividing, so the only rounding of each is
+ * the truncation of a quotient toward 0, like integer / on T,
+ * e.g., -1.5 is -1 either way. An integral T requires a power
+ * of two N/D, since T(N)/T(D) has no fraction to scale by.
  * 
  * TODO: Is this a category? I think so. Investigate.
  * 
@@ -76,27 +93,146 @@
  * 
  */
 
+#pragma once
+
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
 using std::log;
 using std::exp;
 using std::numeric_limits;
 
+namespace scaled_detail
+{
+    constexpr bool is_power_of_two(int n) { return n > 0 && std::has_single_bit(unsigned(n)); }
+
+    // N/D in lowest terms is 2^p / 1 or 1 / 2^p.
+    template <int N, int D>
+    inline constexpr bool power_of_two =
+        is_power_of_two(N / std::gcd(N, D)) && is_power_of_two(D / std::gcd(N, D));
+
+    // p, where N/D = 2^p.
+    template <int N, int D>
+    inline constexpr int exponent =
+        std::bit_width(unsigned(N / std::gcd(N, D))) - std::bit_width(unsigned(D / std::gcd(N, D)));
+
+    // 2^p, computed exactly.
+    template <typename T>
+    constexpr T exp2(int p)
+    {
+        T r = T(1);
+        for (; p > 0; --p)
+            r = r * T(2);
+        for (; p < 0; ++p)
+            r = r / T(2);
+        return r;
+    }
+
+    // an integral type wide enough for the product of two T.
+    template <typename T>
+    struct wide_of { using type = std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>; };
+
+#ifdef __SIZEOF_INT128__
+    template <typename T> requires (sizeof(T) >= sizeof(std::int64_t))
+    struct wide_of<T> { using type = std::conditional_t<std::is_signed_v<T>, __int128, unsigned __int128>; };
+#endif
+
+    template <typename T>
+    using wide = typename wide_of<T>::type;
+
+    // x * N/D.
+    template <typename T, int N, int D>
+    constexpr T times_scale(T const & x)
+    {
+        if constexpr (!power_of_two<N,D>)
+            return x * (T(N) / T(D));
+        else if constexpr (std::is_integral_v<T>)
+            return exponent<N,D> < 0 ? T(x >> -exponent<N,D>) : T(x << exponent<N,D>);
+        else
+        {
+            constexpr T s = exp2<T>(exponent<N,D>);
+            return x * s;
+        }
+    }
+
+    // x * D/N.
+    template <typename T, int N, int D>
+    constexpr T div_scale(T const & x)
+    {
+        if constexpr (!power_of_two<N,D>)
+            return x / (T(N) / T(D));
+        else if constexpr (std::is_integral_v<T>)
+            return exponent<N,D> < 0 ? T(x << -exponent<N,D>) : T(x >> exponent<N,D>);
+        else
+        {
+            constexpr T s = exp2<T>(-exponent<N,D>);
+            return x * s;
+        }
+    }
+
+    // x * y * D/N, the scaled value of the product of x and y. For
+    // integral T and N/D > 1, the product is divided by N/D rather than
+    // shifted, so that it truncates toward 0, as quotient does.
+    template <typename T, int N, int D>
+    constexpr T product(T const & x, T const & y)
+    {
+        if constexpr (!std::is_integral_v<T>)
+            return div_scale<T,N,D>(x * y);
+        else if constexpr (exponent<N,D> > 0)
+            return T(wide<T>(x) * wide<T>(y) / (wide<T>(1) << exponent<N,D>));
+        else
+            return T(div_scale<wide<T>,N,D>(wide<T>(x) * wide<T>(y)));
+    }
+
+    // x / y * N/D, the scaled value of the quotient of x and y. For
+    // integral T, the scale is applied before dividing, to x when N/D >= 1
+    // and to y otherwise, so that the fraction of x / y is not lost.
+    template <typename T, int N, int D>
+    constexpr T quotient(T const & x, T const & y)
+    {
+        if constexpr (!std::is_integral_v<T>)
+            return times_scale<T,N,D>(x / y);
+        else if constexpr (exponent<N,D> >= 0)
+            return T(times_scale<wide<T>,N,D>(wide<T>(x)) / wide<T>(y));
+        else
+            return T(wide<T>(x) / div_scale<wide<T>,N,D>(wide<T>(y)));
+    }
+}
+
 template <typename T, int N, int D>
 struct scaled
 {
+    static_assert(scaled_detail::power_of_two<N,D> || !std::is_integral_v<T>,
+        "scaled<T,N,D> with an integral T requires N/D to be a power of two");
+
+    // the value times scale().
     T k;
 
-    static constexpr auto scale() const { return T(N) / T(D); }
+    static constexpr auto scale() { return T(N) / T(D); }
+
+    // N/D is a power of two, so scaling is exact.
+    static constexpr bool exact = scaled_detail::power_of_two<N,D>;
 
-    // by default, construct a value equal to 1.
-    scaled(T x = 0) : k(x * scale()) {}
+    // by default, construct a value equal to 0.
+    constexpr scaled(T x = 0) : k(scaled_detail::times_scale<T,N,D>(x)) {}
+
+    // constructs the value k / scale(), i.e., k is stored as is.
+    static constexpr scaled from_scaled(T const & k) { return scaled(k, raw{}); }
 
     // operator to convert to type T.
-    operator T() const { return x / scale(); }
+    constexpr operator T() const { return scaled_detail::div_scale<T,N,D>(k); }
+
+private:
+    struct raw {};
+    constexpr scaled(T const & k, raw) : k(k) {}
 };
 
 template <typename T, int N, int D>
-struct numeric_limits<scaled<T,N,D>>
+struct std::numeric_limits<scaled<T,N,D>>
 {
     // If T has max() of M, then scaled<T,N,D> has max of M * D / N.
     // Thus, if D > N, then max<scaled<T,N,D>> is greater than max<T>.
@@ -104,43 +240,68 @@ struct numeric_limits<scaled<T,N,D>>
     // working with really small ill-conditioned numbers, in which case
     // D < N to scale up the internal representation of the number in
     // scaled<T,N,D>.
-    static constexpr auto max() { return scaled<T,N,D>{number_limits<T>::max()}; }
+    static constexpr auto max() { return scaled<T,N,D>::from_scaled(numeric_limits<T>::max()); }
     static constexpr auto is_signed() { return true; }
-    static constexpr auto has_infinity() { return numeric_limits<T>::has_infinity(); }
-    static constexpr auto infinity() { return scaled<T,N,D>{numeric_limits<T>::infinity()}; }
+    static constexpr auto has_infinity() { return numeric_limits<T>::has_infinity; }
+    static constexpr auto infinity() { return scaled<T,N,D>::from_scaled(numeric_limits<T>::infinity()); }
 };
 
 template <typename T, int N, int D>
 auto log(scaled<T,N,D> const & x)
 {
-    static constexpr alpha = log(T(D)) - log(T(N));
-    return scaled<T,N,D>{log(x.k) + alpha};
+    if constexpr (scaled<T,N,D>::exact)
+    {
+        static constexpr T alpha = T(-scaled_detail::exponent<N,D> * 0.693147180559945309417232121458176568L);
+        return scaled<T,N,D>{log(x.k) + alpha};
+    }
+    else
+    {
+        static const T alpha = log(T(D)) - log(T(N));
+        return scaled<T,N,D>{log(x.k) + alpha};
+    }
 }
 
 template <typename T, int N, int D>
 auto exp(scaled<T,N,D> const & x)
 {
-    static constexpr alpha = T(D) / T(N);
-    return scaled<T,N,D>{exp(alpha * x.k)};
+    return scaled<T,N,D>{exp(scaled_detail::div_scale<T,N,D>(x.k))};
+}
+
+template <typename T, int N, int D>
+auto overflow_to(scaled<T,N,D> const & x)
+{
+    using std::abs;
+    return numeric_limits<T>::max() < abs(scaled_detail::div_scale<T,N,D>(x.k));
 }
 
+// the multiplicative inverse, as inv : scaled<T,N,D> -> scaled<T,N,D>.
 template <typename T, int N, int D>
-auto overflow_to(scaled<T,N,D> const & x) { return numeric_limits<T>::max() <= x.k * x.scale(); }
+auto inv(scaled<T,N,D> const & x)
+{
+    using scaled_detail::times_scale;
+    return scaled<T,N,D>::from_scaled(scaled_detail::quotient<T,N,D>(times_scale<T,N,D>(T(1)), x.k));
+}
 
 template <typename T, int N, int D>
-auto inv(scaled<T,N,D> const & x) { return scaled<T,N,D>{-x.k}; }
+auto operator-(scaled<T,N,D> const & x) { return scaled<T,N,D>::from_scaled(-x.k); }
 
 template <typename T, int N, int D>
-auto operator*(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return scaled<T,N,D>{x.k * y.k * x.scale()}; }
+auto operator*(scaled<T,N,D> const & x, scaled<T,N,D> const & y)
+{
+    return scaled<T,N,D>::from_scaled(scaled_detail::product<T,N,D>(x.k, y.k));
+}
 
 template <typename T, int N, int D>
-auto operator/(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return scaled<T,N,D>{x.k / y.k * x.scale()}; }
+auto operator/(scaled<T,N,D> const & x, scaled<T,N,D> const & y)
+{
+    return scaled<T,N,D>::from_scaled(scaled_detail::quotient<T,N,D>(x.k, y.k));
+}
 
 template <typename T, int N, int D>
-auto operator+(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return scaled<T,N,D>{x.k + y.k}; }
+auto operator+(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return scaled<T,N,D>::from_scaled(x.k + y.k); }
 
 template <typename T, int N, int D>
-auto operator-(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return scaled<T,N,D>{x.k - y.k}; }
+auto operator-(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return scaled<T,N,D>::from_scaled(x.k - y.k); }
 
 template <typename T, int N, int D>
 auto operator<(scaled<T,N,D> const & x, scaled<T,N,D> const & y) { return x.k < y.k; }
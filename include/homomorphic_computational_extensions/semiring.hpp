@@ -0,0 +1,182 @@
+/**
+ * Semirings over lg<T,M>, and kernels that are generic over them.
+ *
+ * A semiring S is a type with
+ *     S::value_type
+ *     S::zero  : () -> value_type            identity of plus
+ *     S::one   : () -> value_type            identity of times
+ *     S::plus  : (value_type, value_type) -> value_type
+ *     S::times : (value_type, value_type) -> value_type
+ *     S::sum   : [value_type] -> value_type  plus over a sequence
+ * where sum is the kernels' hook for a fast reduction, e.g., a SIMD
+ * max-reduction rather than a fold of plus.
+ *
+ * The instances are
+ *     lg_sum<T,M>  : (lg<T,M>, +, *),  the sum-product semiring, where
+ *                    + is the log-sum-exp of the exponents
+ *     lg_lns<T,M,P>: (lg<T,M>, +, *), the sum-product semiring with +
+ *                    from the Gaussian-log table of lns.hpp
+ *     lg_max<T,M>  : (lg<T,M>, max, *), the max-product (Viterbi)
+ *                    semiring, whose order is the order on lg<T,M>
+ *     min_plus<T>  : (T, min, +), the tropical semiring over costs,
+ *                    e.g., negative log-probabilities.
+ *
+ * The kernels
+ *     matvec  : y[i] := sum_j A[i][j] x[j]
+ *     forward : the forward recursion of an HMM
+ *     scan    : y[i] := x[0] + ... + x[i]
+ * take S as a template parameter, so, e.g., the forward algorithm and
+ * the Viterbi algorithm are the same code, forward<lg_sum<T>> and
+ * forward<lg_max<T>>, each compiled with its own inner loop and
+ * nothing dispatched per value.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "lg_batch.hpp"
+#include "lg_expr.hpp"
+#include "lns.hpp"
+#include "log_exp_sum.hpp"
+#include "simd.hpp"
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+template <typename S>
+concept semiring = requires(typename S::value_type const & x, std::span<typename S::value_type const> xs)
+{
+    { S::zero() } -> std::same_as<typename S::value_type>;
+    { S::one() } -> std::same_as<typename S::value_type>;
+    { S::plus(x, x) } -> std::same_as<typename S::value_type>;
+    { S::times(x, x) } -> std::same_as<typename S::value_type>;
+    { S::sum(xs) } -> std::same_as<typename S::value_type>;
+};
+
+template <typename T, typename M = std_math>
+struct lg_sum
+{
+    using value_type = lg<T,M>;
+
+    static value_type zero() { return value_type::from_log(-numeric_limits<T>::infinity()); }
+    static value_type one() { return value_type(); }
+    static value_type plus(value_type const & x, value_type const & y) { return eval(x + y); }
+    static value_type times(value_type const & x, value_type const & y) { return x * y; }
+    static value_type sum(std::span<value_type const> xs) { return ::sum(xs); }
+};
+
+template <typename T, typename M = std_math, int P = 4>
+struct lg_lns
+{
+    using value_type = lg<T,M>;
+
+    static value_type zero() { return value_type::from_log(-numeric_limits<T>::infinity()); }
+    static value_type one() { return value_type(); }
+    static value_type plus(value_type const & x, value_type const & y) { return lns_add<P>(x, y); }
+    static value_type times(value_type const & x, value_type const & y) { return x * y; }
+    static value_type sum(std::span<value_type const> xs) { return lns_sum<P>(xs); }
+};
+
+template <typename T, typename M = std_math>
+struct lg_max
+{
+    using value_type = lg<T,M>;
+
+    static value_type zero() { return value_type::from_log(-numeric_limits<T>::infinity()); }
+    static value_type one() { return value_type(); }
+    static value_type plus(value_type const & x, value_type const & y) { return x < y ? y : x; }
+    static value_type times(value_type const & x, value_type const & y) { return x * y; }
+    static value_type sum(std::span<value_type const> xs) { return xs.empty() ? zero() : maximum(xs); }
+};
+
+template <typename T>
+struct min_plus
+{
+    using value_type = T;
+
+    static value_type zero() { return numeric_limits<T>::infinity(); }
+    static value_type one() { return T(0); }
+    static value_type plus(value_type const & x, value_type const & y) { return y < x ? y : x; }
+    static value_type times(value_type const & x, value_type const & y) { return x + y; }
+    static value_type sum(std::span<value_type const> xs) { return xs.empty() ? zero() : simd::hmin(xs.data(), xs.size()); }
+};
+
+/**
+ * matvec<S> : ([S::value_type], [S::value_type], [S::value_type], n, m) -> void
+ *
+ * y := A x over the semiring S, where A is n x m and row-major, i.e.,
+ *     y[i] := S::sum(A[i][0] x[0], ..., A[i][m-1] x[m-1]).
+ * The products of a row are written to a buffer, which S::sum reduces.
+ */
+template <semiring S>
+void matvec(std::span<typename S::value_type const> a, std::span<typename S::value_type const> x,
+    std::span<typename S::value_type> y, std::size_t n, std::size_t m)
+{
+    assert(a.size() == n * m && x.size() == m && y.size() == n);
+    std::vector<typename S::value_type> t(m, S::one());
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < m; ++j)
+            t[j] = S::times(a[i * m + j], x[j]);
+        y[i] = S::sum(std::span<typename S::value_type const>(t));
+    }
+}
+
+/**
+ * forward<S> : ([S::value_type], [S::value_type], [S::value_type], [S::value_type], m, n) -> S::value_type
+ *
+ * The forward recursion of a hidden Markov model with m states over n
+ * observations,
+ *     alpha[0][j]   := init[j] emit[0][j]
+ *     alpha[t+1][j] := S::sum_i(alpha[t][i] trans[i][j]) emit[t+1][j],
+ * where trans is m x m, emit is n x m and alpha is n x m, all row-major.
+ * Returns S::sum_j(alpha[n-1][j]), which for lg_sum is the likelihood of
+ * the observations and for lg_max is the probability of the most likely
+ * path (the Viterbi score).
+ *
+ * trans is transposed once, so each step is a matvec.
+ */
+template <semiring S>
+auto forward(std::span<typename S::value_type const> init, std::span<typename S::value_type const> trans,
+    std::span<typename S::value_type const> emit, std::span<typename S::value_type> alpha, std::size_t m, std::size_t n)
+{
+    using V = typename S::value_type;
+    assert(init.size() == m && trans.size() == m * m && emit.size() == n * m && alpha.size() == n * m);
+    if (n == 0)
+        return S::zero();
+
+    std::vector<V> tt(m * m, S::one());
+    for (std::size_t i = 0; i < m; ++i)
+        for (std::size_t j = 0; j < m; ++j)
+            tt[j * m + i] = trans[i * m + j];
+
+    for (std::size_t j = 0; j < m; ++j)
+        alpha[j] = S::times(init[j], emit[j]);
+    for (std::size_t t = 1; t < n; ++t)
+    {
+        auto const next = alpha.subspan(t * m, m);
+        matvec<S>(std::span<V const>(tt), std::span<V const>(alpha.subspan((t - 1) * m, m)), next, m, m);
+        for (std::size_t j = 0; j < m; ++j)
+            next[j] = S::times(next[j], emit[t * m + j]);
+    }
+    return S::sum(std::span<V const>(alpha.subspan((n - 1) * m, m)));
+}
+
+/**
+ * scan<S> : ([S::value_type], [S::value_type]) -> void
+ *
+ * The inclusive scan y[i] := x[0] + ... + x[i] over the plus of S. y may
+ * alias x.
+ */
+template <semiring S>
+void scan(std::span<typename S::value_type const> x, std::span<typename S::value_type> y)
+{
+    assert(x.size() == y.size());
+    auto s = S::zero();
+    for (std::size_t i = 0; i < x.size(); ++i)
+        y[i] = s = S::plus(s, x[i]);
+}
@@ -0,0 +1,249 @@
+/**
+ * signed_lg<T,M> extends lg<T,M> to signed values, i.e., a value is
+ *     sign * exp(k),
+ * where sign is +1 or -1, and extends its computational basis with
+ *     + : (signed_lg<T,M>, signed_lg<T,M>) -> signed_lg<T,M>
+ *     - : (signed_lg<T,M>, signed_lg<T,M>) -> signed_lg<T,M>.
+ *
+ * In the log-domain, with m := max(k1,k2) and d := -|k1 - k2|,
+ *     s1 exp(k1) + s2 exp(k2) = s exp(m + log1p(s1 s2 exp(d))),
+ * where s is the sign of the operand with the larger exponent. Since
+ * exp(d) is in [0,1], nothing overflows, and the sum is computed
+ * without branches on the operands (the selects compile to blends), so
+ * the same formula runs a block at a time in the batch forms below.
+ *
+ * The math policy M only provides log and exp, so log1p is computed as
+ *     log1p(t) = log(u) * t / (u - 1),  u := 1 + t,
+ * which is accurate to a few ulps (Goldberg, 1991), rather than as
+ * log(1 + t), which loses the low bits of t.
+ *
+ * Zero is exp(-inf) with either sign, and x - x is zero.
+ *
+ * The sign is stored as a value of type T, so a sequence of
+ * signed_lg<T,M> is a sequence of pairs of T and the batch forms
+ * multiply by the signs rather than branch on them.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <ranges>
+#include <span>
+
+template <typename T, typename M = std_math>
+struct signed_lg
+{
+    using value_type = T;
+    using math = M;
+
+    // log of the magnitude.
+    T k;
+    // +1 or -1.
+    T sign;
+
+    // by default, constructs a value equal to 1.
+    signed_lg() : k(T(0)), sign(T(1)) {}
+
+    signed_lg(T x) : k(M::log(x < T(0) ? -x : x)), sign(x < T(0) ? T(-1) : T(1)) {}
+
+    signed_lg(lg<T,M> const & x) : k(x.k), sign(T(1)) {}
+
+    // constructs the value sign * exp(k), i.e., k is stored as is.
+    static constexpr signed_lg from_log(T const & k, T const & sign = T(1)) { return signed_lg(k, sign, exponent{}); }
+
+    // operator to convert to type T.
+    operator T() const { return sign * M::exp(k); }
+
+    friend signed_lg operator-(signed_lg const & x) { return from_log(x.k, -x.sign); }
+
+    friend signed_lg operator*(signed_lg const & x, signed_lg const & y) { return from_log(x.k + y.k, x.sign * y.sign); }
+    friend signed_lg operator/(signed_lg const & x, signed_lg const & y) { return from_log(x.k - y.k, x.sign * y.sign); }
+
+    friend signed_lg operator+(signed_lg const & x, signed_lg const & y)
+    {
+        auto const c = x.k < y.k;
+        auto const m = c ? y.k : x.k;
+        // for equal exponents, including infinite ones, d = 0 rather than NaN.
+        auto const d = x.k == y.k ? T(0) : (c ? x.k - y.k : y.k - x.k);
+        return from_log(m + log1p(x.sign * y.sign * M::exp(d)), c ? y.sign : x.sign);
+    }
+
+    friend signed_lg operator-(signed_lg const & x, signed_lg const & y) { return x + (-y); }
+
+    friend bool operator==(signed_lg const & x, signed_lg const & y)
+    {
+        return x.k == y.k && (x.sign == y.sign || x.k == -numeric_limits<T>::infinity());
+    }
+
+    friend bool operator!=(signed_lg const & x, signed_lg const & y) { return !(x == y); }
+
+    friend bool operator<(signed_lg const & x, signed_lg const & y)
+    {
+        if (x.sign != y.sign)
+            return x.sign < y.sign && !(x.k == -numeric_limits<T>::infinity() && y.k == -numeric_limits<T>::infinity());
+        return x.sign < T(0) ? y.k < x.k : x.k < y.k;
+    }
+
+    friend bool operator>(signed_lg const & x, signed_lg const & y) { return y < x; }
+    friend bool operator<=(signed_lg const & x, signed_lg const & y) { return !(y < x); }
+    friend bool operator>=(signed_lg const & x, signed_lg const & y) { return !(x < y); }
+
+    /**
+     * log1p : T -> T
+     *
+     * log(1 + t) for t in [-1,1].
+     */
+    static T log1p(T const & t)
+    {
+        auto const u = T(1) + t;
+        return u == T(1) ? t : M::log(u) * t / (u - T(1));
+    }
+
+private:
+    struct exponent {};
+    constexpr signed_lg(T const & k, T const & sign, exponent) : k(k), sign(sign) {}
+};
+
+template <typename T, typename M>
+auto inv(signed_lg<T,M> const & x) { return signed_lg<T,M>::from_log(-x.k, x.sign); }
+
+// the magnitude |x| as a value of type lg<T,M>.
+template <typename T, typename M>
+auto abs(signed_lg<T,M> const & x) { return lg<T,M>::from_log(x.k); }
+
+template <typename T, typename M>
+auto sign(signed_lg<T,M> const & x) { return x.k == -numeric_limits<T>::infinity() ? 0 : (x.sign < T(0) ? -1 : 1); }
+
+template <typename T, typename M>
+auto pow(signed_lg<T,M> const & x, int e) { return signed_lg<T,M>::from_log(T(e) * x.k, e % 2 ? x.sign : T(1)); }
+
+namespace signed_lg_detail
+{
+    inline constexpr std::size_t block = 256;
+
+    /**
+     * The batch form of + over a block of n <= block values, i.e.,
+     *     z[i] := x[i] + s * y[i],
+     * where s is +1 for + and -1 for -.
+     */
+    template <typename T, typename M>
+    void add(signed_lg<T,M> const * x, signed_lg<T,M> const * y, signed_lg<T,M> * z, std::size_t n, T s)
+    {
+        T m[block], t[block], u[block], l[block], r[block];
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const c = x[i].k < y[i].k;
+            m[i] = c ? y[i].k : x[i].k;
+            t[i] = x[i].k == y[i].k ? T(0) : (c ? x[i].k - y[i].k : y[i].k - x[i].k);
+            r[i] = c ? s * y[i].sign : x[i].sign;
+        }
+        M::exp(t, t, n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            t[i] = s * x[i].sign * y[i].sign * t[i];
+            u[i] = T(1) + t[i];
+        }
+        M::log(u, l, n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const p = u[i] == T(1) ? t[i] : l[i] * t[i] / (u[i] - T(1));
+            z[i] = signed_lg<T,M>::from_log(m[i] + p, r[i]);
+        }
+    }
+}
+
+/**
+ * add : ([signed_lg<T,M>], [signed_lg<T,M>], [signed_lg<T,M>]) -> void
+ *
+ * z[i] := x[i] + y[i], a block at a time with the batch M::log and
+ * M::exp. z may alias x or y.
+ */
+template <typename T, typename M>
+void add(std::span<signed_lg<T,M> const> x, std::span<signed_lg<T,M> const> y, std::span<signed_lg<T,M>> z)
+{
+    assert(x.size() == y.size() && x.size() == z.size());
+    for (std::size_t i = 0; i < x.size(); i += signed_lg_detail::block)
+    {
+        auto const n = std::min(signed_lg_detail::block, x.size() - i);
+        signed_lg_detail::add(x.data() + i, y.data() + i, z.data() + i, n, T(1));
+    }
+}
+
+/**
+ * sub : ([signed_lg<T,M>], [signed_lg<T,M>], [signed_lg<T,M>]) -> void
+ *
+ * z[i] := x[i] - y[i].
+ */
+template <typename T, typename M>
+void sub(std::span<signed_lg<T,M> const> x, std::span<signed_lg<T,M> const> y, std::span<signed_lg<T,M>> z)
+{
+    assert(x.size() == y.size() && x.size() == z.size());
+    for (std::size_t i = 0; i < x.size(); i += signed_lg_detail::block)
+    {
+        auto const n = std::min(signed_lg_detail::block, x.size() - i);
+        signed_lg_detail::add(x.data() + i, y.data() + i, z.data() + i, n, T(-1));
+    }
+}
+
+/**
+ * dot : ([signed_lg<T,M>], [signed_lg<T,M>]) -> signed_lg<T,M>
+ *
+ * The dot product x1 y1 + ... + xn yn in one pass. As in log_exp_sum,
+ * the exponents ki of the products are shifted by the running maximum
+ * m, so the sum is
+ *     exp(m) * (s1 exp(k1 - m) + ... + sn exp(kn - m)),
+ * and each block of terms is mapped by the batch M::exp and reduced by
+ * simd::sum.
+ */
+template <typename T, typename M>
+auto dot(std::span<signed_lg<T,M> const> x, std::span<signed_lg<T,M> const> y)
+{
+    assert(x.size() == y.size());
+    constexpr auto inf = numeric_limits<T>::infinity();
+    constexpr auto block = signed_lg_detail::block;
+
+    T m = -inf, s = T(0);
+    T k[block], e[block];
+    for (std::size_t i = 0; i < x.size(); i += block)
+    {
+        auto const n = std::min(block, x.size() - i);
+        for (std::size_t j = 0; j < n; ++j)
+            k[j] = x[i + j].k + y[i + j].k;
+
+        auto const bm = simd::hmax(k, n);
+        if (m < bm)
+        {
+            s = s * M::exp(m - bm);
+            m = bm;
+        }
+        if (m == -inf || m == inf)
+            continue;
+
+        for (std::size_t j = 0; j < n; ++j)
+            e[j] = k[j] - m;
+        M::exp(e, e, n);
+        for (std::size_t j = 0; j < n; ++j)
+            e[j] = x[i + j].sign * y[i + j].sign * e[j];
+        s = s + simd::sum(e, n);
+    }
+
+    if (m == -inf || m == inf)
+        return signed_lg<T,M>::from_log(m);
+    return signed_lg<T,M>::from_log(m + M::log(s < T(0) ? -s : s), s < T(0) ? T(-1) : T(1));
+}
+
+// The overloads below accept any contiguous range, e.g.,
+// std::vector<signed_lg<T>>.
+
+template <std::ranges::contiguous_range R>
+auto dot(R const & x, R const & y)
+{
+    using S = std::span<std::ranges::range_value_t<R> const>;
+    return dot(S(x), S(y));
+}
@@ -0,0 +1,770 @@
+/**
+ * A minimal portable SIMD pack for the bulk kernels over lg<T> and
+ * friends.
+ *
+ * pack<T> models a register of pack<T>::width values of type T with
+ * the operations
+ *     load, store, broadcast : T* -> pack<T>, pack<T> -> T*, T -> pack<T>
+ *     widen, narrow          : U* -> pack<T>, pack<T> -> U*
+ *     gather                 : (T*,pack<T>) -> pack<T>
+ *     +, -, *, /             : (pack<T>,pack<T>) -> pack<T>
+ *     max, min               : (pack<T>,pack<T>) -> pack<T>
+ *     sum, hmax, hmin        : pack<T> -> T
+ *     prefix                 : pack<T> -> pack<T>
+ *     last                   : pack<T> -> T
+ *     <, <=, ==              : (pack<T>,pack<T>) -> pack<T>::mask
+ *     select                 : (pack<T>::mask,pack<T>,pack<T>) -> pack<T>.
+ * For float and double, the lanes may also be treated as their bit
+ * patterns, i.e., as unsigned integers of the same width, with
+ *     from_bits              : U -> pack<T>
+ *     iadd, isub, iand, ior  : (pack<T>,pack<T>) -> pack<T>
+ *     shl, shr               : (pack<T>,int) -> pack<T>,
+ * which is what the kernels in fast_math.hpp are built from.
+ *
+ * widen and narrow convert to and from width contiguous codes of type
+ * U = std::uint8_t or std::uint16_t, e.g., for lg_q.hpp. narrow
+ * truncates toward zero, and the truncated lanes must be in the range
+ * of U.
+ *
+ * gather(p, i) loads the lanes p[i[0]], p[i[1]], ..., for lanes of i that
+ * are integers in [0, 2^31), e.g., to look up a table (see lns.hpp).
+ * AVX2 and AVX-512 have gather instructions; SSE2 loads lane by lane.
+ *
+ * For float and double, the widest instruction set enabled at compile
+ * time is used, i.e., AVX-512, then AVX2, then SSE2. Any other T, or
+ * a build without those instruction sets, gets scalar<T>, a pack of
+ * width 1, so generic code written against pack<T> works for any T
+ * that models the ring required by lg<T>. scalar<T> is also what the
+ * kernels use for the tail of a sequence that does not fill a pack.
+ *
+ * The kernels are written against pack<T> with several independent
+ * accumulators, e.g.,
+ *     s0 += x[i], s1 += x[i+w], s2 += x[i+2w], s3 += x[i+3w],
+ * so that the dependency chain on a single accumulator does not bound
+ * the throughput of a reduction.
+ *
+ * A prefix sum cannot be split that way, so scan instead computes the
+ * prefix sums of each pack in registers, with prefix, and carries the
+ * running total from pack to pack as a pack of equal lanes, which
+ * leaves a single add per pack on the dependency chain.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace simd
+{
+    // number of independent accumulators used by the reduction kernels.
+    inline constexpr std::size_t lanes = 4;
+
+    template <typename T>
+    struct scalar
+    {
+        using value_type = T;
+        using bits_type = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+        static constexpr std::size_t width = 1;
+        T v;
+
+        struct mask
+        {
+            bool m;
+
+            friend mask operator&(mask a, mask b) { return mask{a.m && b.m}; }
+            friend mask operator|(mask a, mask b) { return mask{a.m || b.m}; }
+            friend mask operator!(mask a) { return mask{!a.m}; }
+            std::uint32_t bits() const { return m; }
+        };
+
+        static scalar load(T const * p) { return scalar{*p}; }
+        static scalar broadcast(T const & x) { return scalar{x}; }
+        static scalar from_bits(bits_type u) { return scalar{std::bit_cast<T>(u)}; }
+        void store(T * p) const { *p = v; }
+
+        static scalar widen(std::uint8_t const * p) { return scalar{T(*p)}; }
+        static scalar widen(std::uint16_t const * p) { return scalar{T(*p)}; }
+        void narrow(std::uint8_t * p) const { *p = std::uint8_t(v); }
+        void narrow(std::uint16_t * p) const { *p = std::uint16_t(v); }
+        static scalar gather(T const * p, scalar i) { return scalar{p[std::size_t(i.v)]}; }
+
+        T sum() const { return v; }
+        T hmax() const { return v; }
+        T hmin() const { return v; }
+        scalar prefix() const { return *this; }
+        T last() const { return v; }
+
+        friend scalar operator+(scalar const & a, scalar const & b) { return scalar{a.v + b.v}; }
+        friend scalar operator-(scalar const & a, scalar const & b) { return scalar{a.v - b.v}; }
+        friend scalar operator*(scalar const & a, scalar const & b) { return scalar{a.v * b.v}; }
+        friend scalar operator/(scalar const & a, scalar const & b) { return scalar{a.v / b.v}; }
+        friend scalar max(scalar const & a, scalar const & b) { return scalar{a.v < b.v ? b.v : a.v}; }
+        friend scalar min(scalar const & a, scalar const & b) { return scalar{b.v < a.v ? b.v : a.v}; }
+
+        friend mask operator<(scalar const & a, scalar const & b) { return mask{a.v < b.v}; }
+        friend mask operator<=(scalar const & a, scalar const & b) { return mask{a.v <= b.v}; }
+        friend mask operator==(scalar const & a, scalar const & b) { return mask{a.v == b.v}; }
+        friend scalar select(mask m, scalar const & a, scalar const & b) { return m.m ? a : b; }
+
+        bits_type bits() const { return std::bit_cast<bits_type>(v); }
+        friend scalar iadd(scalar a, scalar b) { return from_bits(a.bits() + b.bits()); }
+        friend scalar isub(scalar a, scalar b) { return from_bits(a.bits() - b.bits()); }
+        friend scalar iand(scalar a, scalar b) { return from_bits(a.bits() & b.bits()); }
+        friend scalar ior(scalar a, scalar b) { return from_bits(a.bits() | b.bits()); }
+        scalar shl(int n) const { return from_bits(bits() << n); }
+        scalar shr(int n) const { return from_bits(bits() >> n); }
+    };
+
+    template <typename T>
+    struct native { using type = scalar<T>; };
+
+    /**
+     * The widest pack of T for the enabled instruction set.
+     */
+    template <typename T>
+    using pack = typename native<T>::type;
+
+#if defined(__AVX512F__)
+    struct f64x8
+    {
+        using value_type = double;
+        using bits_type = std::uint64_t;
+        static constexpr std::size_t width = 8;
+        __m512d v;
+
+        struct mask
+        {
+            __mmask8 m;
+
+            friend mask operator&(mask a, mask b) { return mask{__mmask8(a.m & b.m)}; }
+            friend mask operator|(mask a, mask b) { return mask{__mmask8(a.m | b.m)}; }
+            friend mask operator!(mask a) { return mask{__mmask8(~a.m)}; }
+            std::uint32_t bits() const { return m; }
+        };
+
+        static f64x8 load(double const * p) { return f64x8{_mm512_loadu_pd(p)}; }
+        static f64x8 broadcast(double x) { return f64x8{_mm512_set1_pd(x)}; }
+        static f64x8 from_bits(bits_type u) { return f64x8{_mm512_castsi512_pd(_mm512_set1_epi64((long long)u))}; }
+        void store(double * p) const { _mm512_storeu_pd(p, v); }
+
+        static f64x8 widen(std::uint8_t const * p) { return f64x8{_mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const *)p)))}; }
+        static f64x8 widen(std::uint16_t const * p) { return f64x8{_mm512_cvtepi32_pd(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *)p)))}; }
+
+        void narrow(std::uint8_t * p) const
+        {
+            auto const i = _mm512_cvttpd_epi32(v);
+            auto const w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+            _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(w, w));
+        }
+
+        void narrow(std::uint16_t * p) const
+        {
+            auto const i = _mm512_cvttpd_epi32(v);
+            _mm_storeu_si128((__m128i *)p, _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+        }
+
+        static f64x8 gather(double const * p, f64x8 i) { return f64x8{_mm512_i32gather_pd(_mm512_cvttpd_epi32(i.v), p, 8)}; }
+
+        double sum() const { return _mm512_reduce_add_pd(v); }
+        double hmax() const { return _mm512_reduce_max_pd(v); }
+        double hmin() const { return _mm512_reduce_min_pd(v); }
+
+        // lane i := v[0] + ... + v[i], by shifting in zero lanes.
+        f64x8 prefix() const
+        {
+            auto const z = _mm512_setzero_si512();
+            auto u = _mm512_castpd_si512(v);
+            u = _mm512_castpd_si512(_mm512_add_pd(_mm512_castsi512_pd(u), _mm512_castsi512_pd(_mm512_alignr_epi64(u, z, 7))));
+            u = _mm512_castpd_si512(_mm512_add_pd(_mm512_castsi512_pd(u), _mm512_castsi512_pd(_mm512_alignr_epi64(u, z, 6))));
+            u = _mm512_castpd_si512(_mm512_add_pd(_mm512_castsi512_pd(u), _mm512_castsi512_pd(_mm512_alignr_epi64(u, z, 4))));
+            return f64x8{_mm512_castsi512_pd(u)};
+        }
+
+        double last() const { return _mm_cvtsd_f64(_mm512_castpd512_pd128(_mm512_permutexvar_pd(_mm512_set1_epi64(7), v))); }
+
+        friend f64x8 operator+(f64x8 a, f64x8 b) { return f64x8{_mm512_add_pd(a.v, b.v)}; }
+        friend f64x8 operator-(f64x8 a, f64x8 b) { return f64x8{_mm512_sub_pd(a.v, b.v)}; }
+        friend f64x8 operator*(f64x8 a, f64x8 b) { return f64x8{_mm512_mul_pd(a.v, b.v)}; }
+        friend f64x8 operator/(f64x8 a, f64x8 b) { return f64x8{_mm512_div_pd(a.v, b.v)}; }
+        friend f64x8 max(f64x8 a, f64x8 b) { return f64x8{_mm512_max_pd(a.v, b.v)}; }
+        friend f64x8 min(f64x8 a, f64x8 b) { return f64x8{_mm512_min_pd(a.v, b.v)}; }
+
+        friend mask operator<(f64x8 a, f64x8 b) { return mask{_mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ)}; }
+        friend mask operator<=(f64x8 a, f64x8 b) { return mask{_mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ)}; }
+        friend mask operator==(f64x8 a, f64x8 b) { return mask{_mm512_cmp_pd_mask(a.v, b.v, _CMP_EQ_OQ)}; }
+        friend f64x8 select(mask m, f64x8 a, f64x8 b) { return f64x8{_mm512_mask_blend_pd(m.m, b.v, a.v)}; }
+
+        __m512i bits() const { return _mm512_castpd_si512(v); }
+        static f64x8 of(__m512i u) { return f64x8{_mm512_castsi512_pd(u)}; }
+        friend f64x8 iadd(f64x8 a, f64x8 b) { return of(_mm512_add_epi64(a.bits(), b.bits())); }
+        friend f64x8 isub(f64x8 a, f64x8 b) { return of(_mm512_sub_epi64(a.bits(), b.bits())); }
+        friend f64x8 iand(f64x8 a, f64x8 b) { return of(_mm512_and_si512(a.bits(), b.bits())); }
+        friend f64x8 ior(f64x8 a, f64x8 b) { return of(_mm512_or_si512(a.bits(), b.bits())); }
+        f64x8 shl(int n) const { return of(_mm512_slli_epi64(bits(), n)); }
+        f64x8 shr(int n) const { return of(_mm512_srli_epi64(bits(), n)); }
+    };
+
+    struct f32x16
+    {
+        using value_type = float;
+        using bits_type = std::uint32_t;
+        static constexpr std::size_t width = 16;
+        __m512 v;
+
+        struct mask
+        {
+            __mmask16 m;
+
+            friend mask operator&(mask a, mask b) { return mask{__mmask16(a.m & b.m)}; }
+            friend mask operator|(mask a, mask b) { return mask{__mmask16(a.m | b.m)}; }
+            friend mask operator!(mask a) { return mask{__mmask16(~a.m)}; }
+            std::uint32_t bits() const { return m; }
+        };
+
+        static f32x16 load(float const * p) { return f32x16{_mm512_loadu_ps(p)}; }
+        static f32x16 broadcast(float x) { return f32x16{_mm512_set1_ps(x)}; }
+        static f32x16 from_bits(bits_type u) { return f32x16{_mm512_castsi512_ps(_mm512_set1_epi32((int)u))}; }
+        void store(float * p) const { _mm512_storeu_ps(p, v); }
+
+        static f32x16 widen(std::uint8_t const * p) { return f32x16{_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i const *)p)))}; }
+        static f32x16 widen(std::uint16_t const * p) { return f32x16{_mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const *)p)))}; }
+        void narrow(std::uint8_t * p) const { _mm_storeu_si128((__m128i *)p, _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(v))); }
+        void narrow(std::uint16_t * p) const { _mm256_storeu_si256((__m256i *)p, _mm512_cvtepi32_epi16(_mm512_cvttps_epi32(v))); }
+        static f32x16 gather(float const * p, f32x16 i) { return f32x16{_mm512_i32gather_ps(_mm512_cvttps_epi32(i.v), p, 4)}; }
+
+        float sum() const { return _mm512_reduce_add_ps(v); }
+        float hmax() const { return _mm512_reduce_max_ps(v); }
+        float hmin() const { return _mm512_reduce_min_ps(v); }
+
+        f32x16 prefix() const
+        {
+            auto const z = _mm512_setzero_si512();
+            auto u = _mm512_castps_si512(v);
+            u = _mm512_castps_si512(_mm512_add_ps(_mm512_castsi512_ps(u), _mm512_castsi512_ps(_mm512_alignr_epi32(u, z, 15))));
+            u = _mm512_castps_si512(_mm512_add_ps(_mm512_castsi512_ps(u), _mm512_castsi512_ps(_mm512_alignr_epi32(u, z, 14))));
+            u = _mm512_castps_si512(_mm512_add_ps(_mm512_castsi512_ps(u), _mm512_castsi512_ps(_mm512_alignr_epi32(u, z, 12))));
+            u = _mm512_castps_si512(_mm512_add_ps(_mm512_castsi512_ps(u), _mm512_castsi512_ps(_mm512_alignr_epi32(u, z, 8))));
+            return f32x16{_mm512_castsi512_ps(u)};
+        }
+
+        float last() const { return _mm_cvtss_f32(_mm512_castps512_ps128(_mm512_permutexvar_ps(_mm512_set1_epi32(15), v))); }
+
+        friend f32x16 operator+(f32x16 a, f32x16 b) { return f32x16{_mm512_add_ps(a.v, b.v)}; }
+        friend f32x16 operator-(f32x16 a, f32x16 b) { return f32x16{_mm512_sub_ps(a.v, b.v)}; }
+        friend f32x16 operator*(f32x16 a, f32x16 b) { return f32x16{_mm512_mul_ps(a.v, b.v)}; }
+        friend f32x16 operator/(f32x16 a, f32x16 b) { return f32x16{_mm512_div_ps(a.v, b.v)}; }
+        friend f32x16 max(f32x16 a, f32x16 b) { return f32x16{_mm512_max_ps(a.v, b.v)}; }
+        friend f32x16 min(f32x16 a, f32x16 b) { return f32x16{_mm512_min_ps(a.v, b.v)}; }
+
+        friend mask operator<(f32x16 a, f32x16 b) { return mask{_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)}; }
+        friend mask operator<=(f32x16 a, f32x16 b) { return mask{_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)}; }
+        friend mask operator==(f32x16 a, f32x16 b) { return mask{_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)}; }
+        friend f32x16 select(mask m, f32x16 a, f32x16 b) { return f32x16{_mm512_mask_blend_ps(m.m, b.v, a.v)}; }
+
+        __m512i bits() const { return _mm512_castps_si512(v); }
+        static f32x16 of(__m512i u) { return f32x16{_mm512_castsi512_ps(u)}; }
+        friend f32x16 iadd(f32x16 a, f32x16 b) { return of(_mm512_add_epi32(a.bits(), b.bits())); }
+        friend f32x16 isub(f32x16 a, f32x16 b) { return of(_mm512_sub_epi32(a.bits(), b.bits())); }
+        friend f32x16 iand(f32x16 a, f32x16 b) { return of(_mm512_and_si512(a.bits(), b.bits())); }
+        friend f32x16 ior(f32x16 a, f32x16 b) { return of(_mm512_or_si512(a.bits(), b.bits())); }
+        f32x16 shl(int n) const { return of(_mm512_slli_epi32(bits(), n)); }
+        f32x16 shr(int n) const { return of(_mm512_srli_epi32(bits(), n)); }
+    };
+
+    template <> struct native<double> { using type = f64x8; };
+    template <> struct native<float> { using type = f32x16; };
+#elif defined(__AVX2__)
+    struct f64x4
+    {
+        using value_type = double;
+        using bits_type = std::uint64_t;
+        static constexpr std::size_t width = 4;
+        __m256d v;
+
+        struct mask
+        {
+            __m256d m;
+
+            friend mask operator&(mask a, mask b) { return mask{_mm256_and_pd(a.m, b.m)}; }
+            friend mask operator|(mask a, mask b) { return mask{_mm256_or_pd(a.m, b.m)}; }
+            friend mask operator!(mask a) { return mask{_mm256_xor_pd(a.m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)))}; }
+            std::uint32_t bits() const { return std::uint32_t(_mm256_movemask_pd(m)); }
+        };
+
+        static f64x4 load(double const * p) { return f64x4{_mm256_loadu_pd(p)}; }
+        static f64x4 broadcast(double x) { return f64x4{_mm256_set1_pd(x)}; }
+        static f64x4 from_bits(bits_type u) { return f64x4{_mm256_castsi256_pd(_mm256_set1_epi64x((long long)u))}; }
+        void store(double * p) const { _mm256_storeu_pd(p, v); }
+
+        static f64x4 widen(std::uint8_t const * p) { return f64x4{_mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_loadu_si32(p)))}; }
+        static f64x4 widen(std::uint16_t const * p) { return f64x4{_mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const *)p)))}; }
+
+        void narrow(std::uint8_t * p) const
+        {
+            auto const i = _mm256_cvttpd_epi32(v);
+            auto const w = _mm_packus_epi32(i, i);
+            _mm_storeu_si32(p, _mm_packus_epi16(w, w));
+        }
+
+        void narrow(std::uint16_t * p) const
+        {
+            auto const i = _mm256_cvttpd_epi32(v);
+            _mm_storel_epi64((__m128i *)p, _mm_packus_epi32(i, i));
+        }
+
+        // the masked form, from zero, rather than from an undefined register.
+        static f64x4 gather(double const * p, f64x4 i)
+        {
+            auto const m = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            return f64x4{_mm256_mask_i32gather_pd(_mm256_setzero_pd(), p, _mm256_cvttpd_epi32(i.v), m, 8)};
+        }
+
+        double sum() const
+        {
+            __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+
+        double hmax() const
+        {
+            __m128d s = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_max_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+
+        double hmin() const
+        {
+            __m128d s = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_min_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+
+        // lane i := v[0] + ... + v[i], by shifting in zero lanes.
+        f64x4 prefix() const
+        {
+            auto u = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, 0x90), _mm256_setzero_pd(), 0x1));
+            return f64x4{_mm256_add_pd(u, _mm256_permute2f128_pd(u, u, 0x08))};
+        }
+
+        double last() const { return _mm_cvtsd_f64(_mm256_castpd256_pd128(_mm256_permute4x64_pd(v, 0x3))); }
+
+        friend f64x4 operator+(f64x4 a, f64x4 b) { return f64x4{_mm256_add_pd(a.v, b.v)}; }
+        friend f64x4 operator-(f64x4 a, f64x4 b) { return f64x4{_mm256_sub_pd(a.v, b.v)}; }
+        friend f64x4 operator*(f64x4 a, f64x4 b) { return f64x4{_mm256_mul_pd(a.v, b.v)}; }
+        friend f64x4 operator/(f64x4 a, f64x4 b) { return f64x4{_mm256_div_pd(a.v, b.v)}; }
+        friend f64x4 max(f64x4 a, f64x4 b) { return f64x4{_mm256_max_pd(a.v, b.v)}; }
+        friend f64x4 min(f64x4 a, f64x4 b) { return f64x4{_mm256_min_pd(a.v, b.v)}; }
+
+        friend mask operator<(f64x4 a, f64x4 b) { return mask{_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+        friend mask operator<=(f64x4 a, f64x4 b) { return mask{_mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ)}; }
+        friend mask operator==(f64x4 a, f64x4 b) { return mask{_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+        friend f64x4 select(mask m, f64x4 a, f64x4 b) { return f64x4{_mm256_blendv_pd(b.v, a.v, m.m)}; }
+
+        __m256i bits() const { return _mm256_castpd_si256(v); }
+        static f64x4 of(__m256i u) { return f64x4{_mm256_castsi256_pd(u)}; }
+        friend f64x4 iadd(f64x4 a, f64x4 b) { return of(_mm256_add_epi64(a.bits(), b.bits())); }
+        friend f64x4 isub(f64x4 a, f64x4 b) { return of(_mm256_sub_epi64(a.bits(), b.bits())); }
+        friend f64x4 iand(f64x4 a, f64x4 b) { return of(_mm256_and_si256(a.bits(), b.bits())); }
+        friend f64x4 ior(f64x4 a, f64x4 b) { return of(_mm256_or_si256(a.bits(), b.bits())); }
+        f64x4 shl(int n) const { return of(_mm256_slli_epi64(bits(), n)); }
+        f64x4 shr(int n) const { return of(_mm256_srli_epi64(bits(), n)); }
+    };
+
+    struct f32x8
+    {
+        using value_type = float;
+        using bits_type = std::uint32_t;
+        static constexpr std::size_t width = 8;
+        __m256 v;
+
+        struct mask
+        {
+            __m256 m;
+
+            friend mask operator&(mask a, mask b) { return mask{_mm256_and_ps(a.m, b.m)}; }
+            friend mask operator|(mask a, mask b) { return mask{_mm256_or_ps(a.m, b.m)}; }
+            friend mask operator!(mask a) { return mask{_mm256_xor_ps(a.m, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))}; }
+            std::uint32_t bits() const { return std::uint32_t(_mm256_movemask_ps(m)); }
+        };
+
+        static f32x8 load(float const * p) { return f32x8{_mm256_loadu_ps(p)}; }
+        static f32x8 broadcast(float x) { return f32x8{_mm256_set1_ps(x)}; }
+        static f32x8 from_bits(bits_type u) { return f32x8{_mm256_castsi256_ps(_mm256_set1_epi32((int)u))}; }
+        void store(float * p) const { _mm256_storeu_ps(p, v); }
+
+        static f32x8 widen(std::uint8_t const * p) { return f32x8{_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const *)p)))}; }
+        static f32x8 widen(std::uint16_t const * p) { return f32x8{_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *)p)))}; }
+
+        void narrow(std::uint8_t * p) const
+        {
+            auto const i = _mm256_cvttps_epi32(v);
+            auto const w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+            _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(w, w));
+        }
+
+        void narrow(std::uint16_t * p) const
+        {
+            auto const i = _mm256_cvttps_epi32(v);
+            _mm_storeu_si128((__m128i *)p, _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+        }
+
+        static f32x8 gather(float const * p, f32x8 i)
+        {
+            auto const m = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            return f32x8{_mm256_mask_i32gather_ps(_mm256_setzero_ps(), p, _mm256_cvttps_epi32(i.v), m, 4)};
+        }
+
+        float sum() const
+        {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        float hmax() const
+        {
+            __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        float hmin() const
+        {
+            __m128 s = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_min_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_min_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        // the prefix of each 128-bit half, then the low half's total added
+        // to the high half.
+        f32x8 prefix() const
+        {
+            auto u = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 4)));
+            u = _mm256_add_ps(u, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(u), 8)));
+            auto const t = _mm256_permute2f128_ps(u, u, 0x08);
+            return f32x8{_mm256_add_ps(u, _mm256_shuffle_ps(t, t, 0xff))};
+        }
+
+        float last() const { return _mm_cvtss_f32(_mm256_castps256_ps128(_mm256_permutevar8x32_ps(v, _mm256_set1_epi32(7)))); }
+
+        friend f32x8 operator+(f32x8 a, f32x8 b) { return f32x8{_mm256_add_ps(a.v, b.v)}; }
+        friend f32x8 operator-(f32x8 a, f32x8 b) { return f32x8{_mm256_sub_ps(a.v, b.v)}; }
+        friend f32x8 operator*(f32x8 a, f32x8 b) { return f32x8{_mm256_mul_ps(a.v, b.v)}; }
+        friend f32x8 operator/(f32x8 a, f32x8 b) { return f32x8{_mm256_div_ps(a.v, b.v)}; }
+        friend f32x8 max(f32x8 a, f32x8 b) { return f32x8{_mm256_max_ps(a.v, b.v)}; }
+        friend f32x8 min(f32x8 a, f32x8 b) { return f32x8{_mm256_min_ps(a.v, b.v)}; }
+
+        friend mask operator<(f32x8 a, f32x8 b) { return mask{_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+        friend mask operator<=(f32x8 a, f32x8 b) { return mask{_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+        friend mask operator==(f32x8 a, f32x8 b) { return mask{_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)}; }
+        friend f32x8 select(mask m, f32x8 a, f32x8 b) { return f32x8{_mm256_blendv_ps(b.v, a.v, m.m)}; }
+
+        __m256i bits() const { return _mm256_castps_si256(v); }
+        static f32x8 of(__m256i u) { return f32x8{_mm256_castsi256_ps(u)}; }
+        friend f32x8 iadd(f32x8 a, f32x8 b) { return of(_mm256_add_epi32(a.bits(), b.bits())); }
+        friend f32x8 isub(f32x8 a, f32x8 b) { return of(_mm256_sub_epi32(a.bits(), b.bits())); }
+        friend f32x8 iand(f32x8 a, f32x8 b) { return of(_mm256_and_si256(a.bits(), b.bits())); }
+        friend f32x8 ior(f32x8 a, f32x8 b) { return of(_mm256_or_si256(a.bits(), b.bits())); }
+        f32x8 shl(int n) const { return of(_mm256_slli_epi32(bits(), n)); }
+        f32x8 shr(int n) const { return of(_mm256_srli_epi32(bits(), n)); }
+    };
+
+    template <> struct native<double> { using type = f64x4; };
+    template <> struct native<float> { using type = f32x8; };
+#elif defined(__SSE2__)
+    struct f64x2
+    {
+        using value_type = double;
+        using bits_type = std::uint64_t;
+        static constexpr std::size_t width = 2;
+        __m128d v;
+
+        struct mask
+        {
+            __m128d m;
+
+            friend mask operator&(mask a, mask b) { return mask{_mm_and_pd(a.m, b.m)}; }
+            friend mask operator|(mask a, mask b) { return mask{_mm_or_pd(a.m, b.m)}; }
+            friend mask operator!(mask a) { return mask{_mm_xor_pd(a.m, _mm_castsi128_pd(_mm_set1_epi32(-1)))}; }
+            std::uint32_t bits() const { return std::uint32_t(_mm_movemask_pd(m)); }
+        };
+
+        static f64x2 load(double const * p) { return f64x2{_mm_loadu_pd(p)}; }
+        static f64x2 broadcast(double x) { return f64x2{_mm_set1_pd(x)}; }
+        static f64x2 from_bits(bits_type u) { return f64x2{_mm_castsi128_pd(_mm_set1_epi64x((long long)u))}; }
+        void store(double * p) const { _mm_storeu_pd(p, v); }
+
+        static f64x2 widen(std::uint8_t const * p) { return f64x2{_mm_cvtepi32_pd(_mm_setr_epi32(p[0], p[1], 0, 0))}; }
+        static f64x2 widen(std::uint16_t const * p) { return f64x2{_mm_cvtepi32_pd(_mm_setr_epi32(p[0], p[1], 0, 0))}; }
+
+        // SSE2 has no unsigned 32-bit pack, so the lanes are extracted.
+        template <typename U>
+        void narrow(U * p) const
+        {
+            auto const i = _mm_cvttpd_epi32(v);
+            p[0] = U(_mm_cvtsi128_si32(i));
+            p[1] = U(_mm_cvtsi128_si32(_mm_srli_si128(i, 4)));
+        }
+
+        static f64x2 gather(double const * p, f64x2 i)
+        {
+            auto const j = _mm_cvttpd_epi32(i.v);
+            return f64x2{_mm_setr_pd(p[_mm_cvtsi128_si32(j)], p[_mm_cvtsi128_si32(_mm_srli_si128(j, 4))])};
+        }
+
+        double sum() const { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+        double hmax() const { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+        double hmin() const { return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v))); }
+
+        f64x2 prefix() const { return f64x2{_mm_add_pd(v, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(v), 8)))}; }
+        double last() const { return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)); }
+
+        friend f64x2 operator+(f64x2 a, f64x2 b) { return f64x2{_mm_add_pd(a.v, b.v)}; }
+        friend f64x2 operator-(f64x2 a, f64x2 b) { return f64x2{_mm_sub_pd(a.v, b.v)}; }
+        friend f64x2 operator*(f64x2 a, f64x2 b) { return f64x2{_mm_mul_pd(a.v, b.v)}; }
+        friend f64x2 operator/(f64x2 a, f64x2 b) { return f64x2{_mm_div_pd(a.v, b.v)}; }
+        friend f64x2 max(f64x2 a, f64x2 b) { return f64x2{_mm_max_pd(a.v, b.v)}; }
+        friend f64x2 min(f64x2 a, f64x2 b) { return f64x2{_mm_min_pd(a.v, b.v)}; }
+
+        friend mask operator<(f64x2 a, f64x2 b) { return mask{_mm_cmplt_pd(a.v, b.v)}; }
+        friend mask operator<=(f64x2 a, f64x2 b) { return mask{_mm_cmple_pd(a.v, b.v)}; }
+        friend mask operator==(f64x2 a, f64x2 b) { return mask{_mm_cmpeq_pd(a.v, b.v)}; }
+        friend f64x2 select(mask m, f64x2 a, f64x2 b) { return f64x2{_mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v))}; }
+
+        __m128i bits() const { return _mm_castpd_si128(v); }
+        static f64x2 of(__m128i u) { return f64x2{_mm_castsi128_pd(u)}; }
+        friend f64x2 iadd(f64x2 a, f64x2 b) { return of(_mm_add_epi64(a.bits(), b.bits())); }
+        friend f64x2 isub(f64x2 a, f64x2 b) { return of(_mm_sub_epi64(a.bits(), b.bits())); }
+        friend f64x2 iand(f64x2 a, f64x2 b) { return of(_mm_and_si128(a.bits(), b.bits())); }
+        friend f64x2 ior(f64x2 a, f64x2 b) { return of(_mm_or_si128(a.bits(), b.bits())); }
+        f64x2 shl(int n) const { return of(_mm_slli_epi64(bits(), n)); }
+        f64x2 shr(int n) const { return of(_mm_srli_epi64(bits(), n)); }
+    };
+
+    struct f32x4
+    {
+        using value_type = float;
+        using bits_type = std::uint32_t;
+        static constexpr std::size_t width = 4;
+        __m128 v;
+
+        struct mask
+        {
+            __m128 m;
+
+            friend mask operator&(mask a, mask b) { return mask{_mm_and_ps(a.m, b.m)}; }
+            friend mask operator|(mask a, mask b) { return mask{_mm_or_ps(a.m, b.m)}; }
+            friend mask operator!(mask a) { return mask{_mm_xor_ps(a.m, _mm_castsi128_ps(_mm_set1_epi32(-1)))}; }
+            std::uint32_t bits() const { return std::uint32_t(_mm_movemask_ps(m)); }
+        };
+
+        static f32x4 load(float const * p) { return f32x4{_mm_loadu_ps(p)}; }
+        static f32x4 broadcast(float x) { return f32x4{_mm_set1_ps(x)}; }
+        static f32x4 from_bits(bits_type u) { return f32x4{_mm_castsi128_ps(_mm_set1_epi32((int)u))}; }
+        void store(float * p) const { _mm_storeu_ps(p, v); }
+
+        static f32x4 widen(std::uint8_t const * p)
+        {
+            auto const z = _mm_setzero_si128();
+            return f32x4{_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_loadu_si32(p), z), z))};
+        }
+
+        static f32x4 widen(std::uint16_t const * p) { return f32x4{_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const *)p), _mm_setzero_si128()))}; }
+
+        void narrow(std::uint8_t * p) const
+        {
+            auto const w = _mm_packs_epi32(_mm_cvttps_epi32(v), _mm_setzero_si128());
+            _mm_storeu_si32(p, _mm_packus_epi16(w, w));
+        }
+
+        // SSE2 has no unsigned 32-bit pack, so the lanes are offset into
+        // the signed range and back.
+        void narrow(std::uint16_t * p) const
+        {
+            auto const i = _mm_sub_epi32(_mm_cvttps_epi32(v), _mm_set1_epi32(32768));
+            _mm_storel_epi64((__m128i *)p, _mm_xor_si128(_mm_packs_epi32(i, i), _mm_set1_epi16(-32768)));
+        }
+
+        static f32x4 gather(float const * p, f32x4 i)
+        {
+            auto const j = _mm_cvttps_epi32(i.v);
+            return f32x4{_mm_setr_ps(p[_mm_cvtsi128_si32(j)], p[_mm_cvtsi128_si32(_mm_srli_si128(j, 4))],
+                p[_mm_cvtsi128_si32(_mm_srli_si128(j, 8))], p[_mm_cvtsi128_si32(_mm_srli_si128(j, 12))])};
+        }
+
+        float sum() const
+        {
+            __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        float hmax() const
+        {
+            __m128 s = _mm_max_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        float hmin() const
+        {
+            __m128 s = _mm_min_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_min_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        f32x4 prefix() const
+        {
+            auto const u = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+            return f32x4{_mm_add_ps(u, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(u), 8)))};
+        }
+
+        float last() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, 0xff)); }
+
+        friend f32x4 operator+(f32x4 a, f32x4 b) { return f32x4{_mm_add_ps(a.v, b.v)}; }
+        friend f32x4 operator-(f32x4 a, f32x4 b) { return f32x4{_mm_sub_ps(a.v, b.v)}; }
+        friend f32x4 operator*(f32x4 a, f32x4 b) { return f32x4{_mm_mul_ps(a.v, b.v)}; }
+        friend f32x4 operator/(f32x4 a, f32x4 b) { return f32x4{_mm_div_ps(a.v, b.v)}; }
+        friend f32x4 max(f32x4 a, f32x4 b) { return f32x4{_mm_max_ps(a.v, b.v)}; }
+        friend f32x4 min(f32x4 a, f32x4 b) { return f32x4{_mm_min_ps(a.v, b.v)}; }
+
+        friend mask operator<(f32x4 a, f32x4 b) { return mask{_mm_cmplt_ps(a.v, b.v)}; }
+        friend mask operator<=(f32x4 a, f32x4 b) { return mask{_mm_cmple_ps(a.v, b.v)}; }
+        friend mask operator==(f32x4 a, f32x4 b) { return mask{_mm_cmpeq_ps(a.v, b.v)}; }
+        friend f32x4 select(mask m, f32x4 a, f32x4 b) { return f32x4{_mm_or_ps(_mm_and_ps(m.m, a.v), _mm_andnot_ps(m.m, b.v))}; }
+
+        __m128i bits() const { return _mm_castps_si128(v); }
+        static f32x4 of(__m128i u) { return f32x4{_mm_castsi128_ps(u)}; }
+        friend f32x4 iadd(f32x4 a, f32x4 b) { return of(_mm_add_epi32(a.bits(), b.bits())); }
+        friend f32x4 isub(f32x4 a, f32x4 b) { return of(_mm_sub_epi32(a.bits(), b.bits())); }
+        friend f32x4 iand(f32x4 a, f32x4 b) { return of(_mm_and_si128(a.bits(), b.bits())); }
+        friend f32x4 ior(f32x4 a, f32x4 b) { return of(_mm_or_si128(a.bits(), b.bits())); }
+        f32x4 shl(int n) const { return of(_mm_slli_epi32(bits(), n)); }
+        f32x4 shr(int n) const { return of(_mm_srli_epi32(bits(), n)); }
+    };
+
+    template <> struct native<double> { using type = f64x2; };
+    template <> struct native<float> { using type = f32x4; };
+#endif
+
+    /**
+     * sum : (T*,n) -> T
+     *
+     * Sums n contiguous values with simd::lanes independent pack
+     * accumulators.
+     */
+    template <typename T>
+    T sum(T const * x, std::size_t n)
+    {
+        using P = pack<T>;
+        constexpr auto w = P::width;
+
+        auto s0 = P::broadcast(T(0)), s1 = s0, s2 = s0, s3 = s0;
+        std::size_t i = 0;
+        for (; i + lanes * w <= n; i += lanes * w)
+        {
+            s0 = s0 + P::load(x + i);
+            s1 = s1 + P::load(x + i + w);
+            s2 = s2 + P::load(x + i + 2 * w);
+            s3 = s3 + P::load(x + i + 3 * w);
+        }
+        for (; i + w <= n; i += w)
+            s0 = s0 + P::load(x + i);
+
+        T s = ((s0 + s1) + (s2 + s3)).sum();
+        for (; i < n; ++i)
+            s = s + x[i];
+        return s;
+    }
+
+    /**
+     * hmax : (T*,n) -> T
+     *
+     * The maximum of n > 0 contiguous values.
+     */
+    template <typename T>
+    T hmax(T const * x, std::size_t n)
+    {
+        using P = pack<T>;
+        constexpr auto w = P::width;
+
+        std::size_t i = 0;
+        T m = x[0];
+        if (n >= lanes * w)
+        {
+            auto m0 = P::load(x), m1 = P::load(x + w), m2 = P::load(x + 2 * w), m3 = P::load(x + 3 * w);
+            for (i = lanes * w; i + lanes * w <= n; i += lanes * w)
+            {
+                m0 = max(m0, P::load(x + i));
+                m1 = max(m1, P::load(x + i + w));
+                m2 = max(m2, P::load(x + i + 2 * w));
+                m3 = max(m3, P::load(x + i + 3 * w));
+            }
+            m = max(max(m0, m1), max(m2, m3)).hmax();
+        }
+        for (; i < n; ++i)
+            m = m < x[i] ? x[i] : m;
+        return m;
+    }
+
+    /**
+     * hmin : (T*,n) -> T
+     *
+     * The minimum of n > 0 contiguous values.
+     */
+    template <typename T>
+    T hmin(T const * x, std::size_t n)
+    {
+        using P = pack<T>;
+        constexpr auto w = P::width;
+
+        std::size_t i = 0;
+        T m = x[0];
+        if (n >= lanes * w)
+        {
+            auto m0 = P::load(x), m1 = P::load(x + w), m2 = P::load(x + 2 * w), m3 = P::load(x + 3 * w);
+            for (i = lanes * w; i + lanes * w <= n; i += lanes * w)
+            {
+                m0 = min(m0, P::load(x + i));
+                m1 = min(m1, P::load(x + i + w));
+                m2 = min(m2, P::load(x + i + 2 * w));
+                m3 = min(m3, P::load(x + i + 3 * w));
+            }
+            m = min(min(m0, m1), min(m2, m3)).hmin();
+        }
+        for (; i < n; ++i)
+            m = x[i] < m ? x[i] : m;
+        return m;
+    }
+
+    /**
+     * scan : (T*,T*,n,T) -> T
+     *
+     * The inclusive prefix sums of n contiguous values after a carry c,
+     *     y[i] := c + x[0] + ... + x[i],
+     * returning c + x[0] + ... + x[n-1]. y may be x.
+     */
+    template <typename T>
+    T scan(T const * x, T * y, std::size_t n, T c)
+    {
+        using P = pack<T>;
+        constexpr auto w = P::width;
+
+        auto carry = P::broadcast(c);
+        std::size_t i = 0;
+        for (; i + w <= n; i += w)
+        {
+            // the last lane of carry + p is carry + p.last(), so carry
+            // stays equal to the last y stored.
+            auto const p = P::load(x + i).prefix();
+            (carry + p).store(y + i);
+            carry = carry + P::broadcast(p.last());
+        }
+
+        c = carry.last();
+        for (; i < n; ++i)
+            y[i] = c = c + x[i];
+        return c;
+    }
+}
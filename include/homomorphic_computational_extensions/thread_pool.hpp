@@ -0,0 +1,223 @@
+/**
+ * A small work-stealing thread pool for the bulk kernels.
+ *
+ * The only operation is
+ *     parallel_for : (n, f) -> void,
+ * which calls f(i) once for every i in [0,n) and returns when all of
+ * them are done. The calling thread participates as worker 0.
+ *
+ * [0,n) is first split into one contiguous range per worker. A worker
+ * takes indices from the front of its own range and, when it runs dry,
+ * steals the back half of the range of another worker, so uneven work
+ * per index is balanced without a shared queue.
+ *
+ * Which worker calls f(i) is not deterministic. Kernels that need
+ * results that do not depend on the number of threads, e.g., the
+ * reductions in likelihood.hpp, write the result of f(i) to slot i and
+ * combine the slots in a fixed order afterwards.
+ *
+ * If some f(i) throws, the remaining indices are still run and the
+ * first exception is rethrown by parallel_for.
+ *
+ * A call to parallel_for from inside some f(i) on the same pool, i.e.,
+ * from one of its workers, runs every index of the nested call in order
+ * on that worker, since the workers are already busy with the outer
+ * call. Nested calls on other pools are run by those pools as usual.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class thread_pool
+{
+public:
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) :
+        queues_(std::max<std::size_t>(threads, 1))
+    {
+        for (std::size_t id = 1; id < queues_.size(); ++id)
+            workers_.emplace_back([this, id] { run(id); });
+    }
+
+    thread_pool(thread_pool const &) = delete;
+    thread_pool & operator=(thread_pool const &) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto & w : workers_)
+            w.join();
+    }
+
+    // number of workers, including the calling thread.
+    std::size_t size() const { return queues_.size(); }
+
+    template <typename F>
+    void parallel_for(std::size_t n, F && f)
+    {
+        if (n == 0)
+            return;
+
+        if (current_ == this)
+        {
+            std::exception_ptr error;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                try
+                {
+                    f(i);
+                }
+                catch (...)
+                {
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+            if (error)
+                std::rethrow_exception(error);
+            return;
+        }
+
+        std::lock_guard<std::mutex> job(submit_);
+        task_ = [&f](std::size_t i) { f(i); };
+        error_ = nullptr;
+
+        auto const w = queues_.size();
+        for (std::size_t q = 0; q < w; ++q)
+        {
+            std::lock_guard<std::mutex> lock(queues_[q].m);
+            queues_[q].begin = n * q / w;
+            queues_[q].end = n * (q + 1) / w;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            ++generation_;
+            active_ = w - 1;
+        }
+        wake_.notify_all();
+
+        // the calling thread is worker 0 until its share is done.
+        auto const outer = std::exchange(current_, this);
+        work(0);
+        current_ = outer;
+
+        std::unique_lock<std::mutex> lock(m_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+private:
+    struct range
+    {
+        std::mutex m;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    void run(std::size_t id)
+    {
+        current_ = this;
+        std::size_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_);
+                wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_)
+                    return;
+                seen = generation_;
+            }
+
+            work(id);
+
+            std::lock_guard<std::mutex> lock(m_);
+            if (--active_ == 0)
+                done_.notify_one();
+        }
+    }
+
+    void work(std::size_t id)
+    {
+        std::size_t i;
+        while (pop(id, i) || steal(id, i))
+        {
+            try
+            {
+                task_(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_);
+                if (!error_)
+                    error_ = std::current_exception();
+            }
+        }
+    }
+
+    bool pop(std::size_t id, std::size_t & i)
+    {
+        auto & q = queues_[id];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.begin == q.end)
+            return false;
+        i = q.begin++;
+        return true;
+    }
+
+    bool steal(std::size_t id, std::size_t & i)
+    {
+        auto const w = queues_.size();
+        for (std::size_t k = 1; k < w; ++k)
+        {
+            auto & v = queues_[(id + k) % w];
+            std::size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(v.m);
+                if (v.begin == v.end)
+                    continue;
+                end = v.end;
+                begin = v.end - (v.end - v.begin + 1) / 2;
+                v.end = begin;
+            }
+
+            // our own range is empty, so the stolen range replaces it.
+            i = begin;
+            auto & q = queues_[id];
+            std::lock_guard<std::mutex> lock(q.m);
+            q.begin = begin + 1;
+            q.end = end;
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<range> queues_;
+    std::vector<std::thread> workers_;
+    std::function<void(std::size_t)> task_;
+    std::exception_ptr error_;
+
+    // the pool whose parallel_for this thread is working on, if any.
+    static inline thread_local thread_pool * current_ = nullptr;
+
+    std::mutex submit_;
+    std::mutex m_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::size_t generation_ = 0;
+    std::size_t active_ = 0;
+    bool stop_ = false;
+};
@@ -0,0 +1,256 @@
+/**
+ * xfloat<T> is an extended-range floating point number type that
+ * models T, i.e., a value is
+ *     m * 2^e,
+ * where the mantissa m is a value of type T and the exponent e is a
+ * 64-bit integer. Its range is about [2^-(2^63), 2^(2^63)], which
+ * dwarfs even the range of lg<T>, but, unlike lg<T>, it is closed under
+ * addition and subtraction and is signed.
+ *
+ * Multiplication is a multiplication of the mantissas and an addition
+ * of the exponents,
+ *     (m1 * 2^e1) * (m2 * 2^e2) = (m1 * m2) * 2^(e1 + e2),
+ * so a long product, e.g., the likelihood of a sample
+ *     xfloat<T>(p(x1)) * ... * xfloat<T>(p(xn)),
+ * calls no transcendental function, while the same product in lg<T>
+ * pays a log per factor.
+ *
+ * The mantissa is renormalized lazily, i.e., m is only brought back to
+ * [1/2,1) by frexp (which is exact) when |m| leaves
+ *     [2^-b, 2^b],  b := numeric_limits<T>::max_exponent/2 - 12,
+ * since the product of two mantissas in that interval cannot overflow
+ * or underflow T. For double, b = 500, so the product of hundreds of
+ * probabilities is renormalized about once.
+ *
+ * Addition aligns the smaller operand to the exponent of the larger
+ * with ldexp and adds the mantissas, so it is rounded once, as in T.
+ *
+ * Conversions to and from lg<T,M> map the exponent by log(2), and
+ * conversions to and from scaled<T,N,D> (and T) go through ldexp, so
+ * they overflow or underflow only if the target type cannot represent
+ * the value.
+ */
+
+#pragma once
+
+#include "lg.hpp"
+#include "scaled.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+template <typename T>
+struct xfloat
+{
+    using value_type = T;
+
+    // the mantissa.
+    T m;
+    // the exponent.
+    std::int64_t e;
+
+    // by default, constructs a value equal to 0.
+    xfloat() : m(T(0)), e(0) {}
+
+    xfloat(T x) : m(x), e(0) { normalize(); }
+
+    // constructs the value m * 2^e.
+    xfloat(T m, std::int64_t e) : m(m), e(e) {}
+
+    template <typename M>
+    explicit xfloat(lg<T,M> const & x);
+
+    template <int N, int D>
+    explicit xfloat(scaled<T,N,D> const & x) : xfloat(x.k) { *this = *this / xfloat(x.scale()); }
+
+    // operator to convert to type T, which overflows or underflows
+    // as ldexp.
+    explicit operator T() const
+    {
+        using std::ldexp;
+        auto const y = normalized();
+        return ldexp(y.m, (int)std::clamp<std::int64_t>(y.e, -limit, limit));
+    }
+
+    template <typename M>
+    explicit operator lg<T,M>() const;
+
+    template <int N, int D>
+    explicit operator scaled<T,N,D>() const
+    {
+        return scaled<T,N,D>::from_scaled((T)(*this * xfloat(scaled<T,N,D>::scale())));
+    }
+
+    // brings m to [1/2,1), or leaves it as is if it is 0, infinite or NaN.
+    void normalize()
+    {
+        using std::frexp;
+        int k = 0;
+        m = frexp(m, &k);
+        e += k;
+    }
+
+    auto normalized() const
+    {
+        auto y = *this;
+        y.normalize();
+        return y;
+    }
+
+    // renormalizes m if |m| is outside of [2^-b, 2^b].
+    void renormalize()
+    {
+        using std::abs;
+        auto const a = abs(m);
+        if (a < small || big < a)
+            normalize();
+    }
+
+    xfloat & operator*=(xfloat const & y)
+    {
+        m = m * y.m;
+        e = e + y.e;
+        renormalize();
+        return *this;
+    }
+
+    xfloat & operator/=(xfloat const & y)
+    {
+        m = m / y.m;
+        e = e - y.e;
+        renormalize();
+        return *this;
+    }
+
+    xfloat & operator+=(xfloat const & y)
+    {
+        using std::ldexp;
+        auto a = normalized(), b = y.normalized();
+        if (a.m == T(0) || (b.m != T(0) && a.e < b.e))
+            std::swap(a, b);
+        // b is negligible if it is more than limit binades smaller.
+        auto const d = std::max<std::int64_t>(b.e - a.e, -limit);
+        m = a.m + ldexp(b.m, (int)d);
+        e = a.e;
+        return *this;
+    }
+
+    xfloat & operator-=(xfloat const & y) { return *this += -y; }
+
+    friend xfloat operator-(xfloat const & x) { return xfloat(-x.m, x.e); }
+    friend xfloat operator*(xfloat x, xfloat const & y) { return x *= y; }
+    friend xfloat operator/(xfloat x, xfloat const & y) { return x /= y; }
+    friend xfloat operator+(xfloat x, xfloat const & y) { return x += y; }
+    friend xfloat operator-(xfloat x, xfloat const & y) { return x += -y; }
+
+    // the order is the order on the sign of the difference, or, if either
+    // mantissa is infinite or NaN, the order of the mantissas, so that,
+    // as in T, inf == inf and NaN is unordered.
+    friend bool operator<(xfloat const & x, xfloat const & y) { auto const [a, b] = order(x, y); return a < b; }
+    friend bool operator<=(xfloat const & x, xfloat const & y) { auto const [a, b] = order(x, y); return a <= b; }
+    friend bool operator>(xfloat const & x, xfloat const & y) { auto const [a, b] = order(x, y); return b < a; }
+    friend bool operator>=(xfloat const & x, xfloat const & y) { auto const [a, b] = order(x, y); return b <= a; }
+    friend bool operator==(xfloat const & x, xfloat const & y) { auto const [a, b] = order(x, y); return a == b; }
+    friend bool operator!=(xfloat const & x, xfloat const & y) { return !(x == y); }
+
+private:
+    // a pair of T in the order of x and y.
+    static std::pair<T,T> order(xfloat const & x, xfloat const & y)
+    {
+        using std::isfinite;
+        if (isfinite(x.m) && isfinite(y.m))
+            return { (x - y).m, T(0) };
+        return { x.m, y.m };
+    }
+
+    static constexpr T exp2(int n)
+    {
+        T x = T(1);
+        for (; n > 0; --n)
+            x = x * T(2);
+        for (; n < 0; ++n)
+            x = x / T(2);
+        return x;
+    }
+
+    static constexpr int b = numeric_limits<T>::max_exponent / 2 - 12;
+    static constexpr T small = exp2(-b);
+    static constexpr T big = exp2(b);
+    // a shift that takes any normalized mantissa out of the range of T.
+    static constexpr std::int64_t limit = numeric_limits<T>::max_exponent - numeric_limits<T>::min_exponent +
+        numeric_limits<T>::digits + 2;
+};
+
+namespace xfloat_detail
+{
+    // log(2) as T, and the part of log(2) below it. A split with trailing
+    // zeros in the leading part, as in fast_math.hpp, keeps e * ln2_hi
+    // exact only for small e, so the products with e are instead taken
+    // exactly inside fma, which leaves an error of about |e| 2^-2digits
+    // for any |e| < 2^62.
+    template <typename T>
+    inline constexpr T ln2_hi = T(0.6931471805599453094172321214581766L);
+
+    template <typename T>
+    inline constexpr T ln2_lo = T(0.6931471805599453094172321214581766L - (long double)ln2_hi<T>);
+}
+
+/**
+ * xfloat<T> : lg<T,M> -> xfloat<T>
+ *
+ * exp(k) = 2^e * exp(r), where e := round(k / log(2)) and
+ * r := k - e * log(2) is in [-log(2)/2, log(2)/2], computed with two fma.
+ */
+template <typename T>
+template <typename M>
+xfloat<T>::xfloat(lg<T,M> const & x) : m(T(1)), e(0)
+{
+    using std::abs;
+    using std::fma;
+    using std::round;
+    using xfloat_detail::ln2_hi;
+    using xfloat_detail::ln2_lo;
+
+    auto const q = x.k / ln2_hi<T>;
+    // beyond the range of the exponent, or infinite or NaN.
+    if (!(abs(q) < T(0x1p62)))
+    {
+        m = q < T(0) ? T(0) : M::exp(x.k);
+        return;
+    }
+
+    auto const k = round(q);
+    e = (std::int64_t)k;
+    m = M::exp(fma(-k, ln2_lo<T>, fma(-k, ln2_hi<T>, x.k)));
+}
+
+/**
+ * lg<T,M> : xfloat<T> -> lg<T,M>
+ *
+ * log(m * 2^e) = log(m) + e * log(2), with two fma, so it rounds about
+ * once. The value must not be negative.
+ */
+template <typename T>
+template <typename M>
+xfloat<T>::operator lg<T,M>() const
+{
+    using std::fma;
+    using xfloat_detail::ln2_hi;
+    using xfloat_detail::ln2_lo;
+
+    auto const y = normalized();
+    assert(!(y.m < T(0)));
+    auto const k = T(y.e);
+    return lg<T,M>::from_log(fma(k, ln2_hi<T>, fma(k, ln2_lo<T>, M::log(y.m))));
+}
+
+template <typename T>
+auto abs(xfloat<T> const & x)
+{
+    using std::abs;
+    return xfloat<T>(abs(x.m), x.e);
+}
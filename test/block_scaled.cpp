@@ -0,0 +1,150 @@
+#include "homomorphic_computational_extensions/block_scaled.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// the relative error of xfloat x to y, both scaled by the largest value
+// of the block of y.
+double error(xfloat<double> const & x, double y, double top) { return std::abs((double)x - y) / top; }
+
+template <typename S>
+bool check(double tol)
+{
+    bool ok = true;
+    using A = block_scaled<S,64>;
+
+    // the magnitude changes from block to block by up to 2^+-200.
+    std::mt19937_64 g(11);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::size_t const n = 1000;
+    std::vector<double> xs(n), ys(n), top(n);
+    for (std::size_t b = 0; b < n; b += 64)
+    {
+        auto const sx = std::ldexp(1.0, int(200 * u(g))), sy = std::ldexp(1.0, int(200 * u(g)));
+        for (std::size_t i = b; i < std::min(n, b + 64); ++i)
+        {
+            xs[i] = sx * u(g);
+            ys[i] = sy * u(g);
+        }
+    }
+
+    A const x{ std::span<double const>(xs) }, y{ std::span<double const>(ys) };
+    ok &= x.size() == n && x.blocks() == 16 && x.mantissas().size() == 16 * 64;
+
+    // the largest magnitude in the block of i, of a sequence.
+    auto const block_top = [&](std::vector<double> const & v, std::size_t i)
+    {
+        double t = 0.0;
+        for (std::size_t j = i / 64 * 64; j < std::min(n, i / 64 * 64 + 64); ++j)
+            t = std::max(t, std::abs(v[j]));
+        return t;
+    };
+
+    std::vector<double> sum(n), diff(n), prod(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sum[i] = xs[i] + ys[i];
+        diff[i] = xs[i] - ys[i];
+        prod[i] = xs[i] * ys[i];
+    }
+
+    auto const s = x + y, d = x - y, p = x * y;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        ok &= error(x[i], xs[i], block_top(xs, i)) < tol;
+        ok &= error(s[i], sum[i], block_top(sum, i)) < 2 * tol;
+        ok &= error(d[i], diff[i], block_top(diff, i)) < 2 * tol;
+        ok &= error(p[i], prod[i], block_top(prod, i)) < 4 * tol;
+    }
+
+    // the dot product does not overflow, whatever the scales.
+    double r = 0.0, a = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        r += xs[i] * ys[i];
+        a += std::abs(xs[i] * ys[i]);
+    }
+    ok &= std::abs((double)dot(x, y) - r) < 4 * tol * a;
+
+    // to T.
+    std::vector<double> back(n);
+    x.copy_to(std::span<double>(back));
+    for (std::size_t i = 0; i < n; ++i)
+        ok &= std::abs(back[i] - xs[i]) <= tol * block_top(xs, i);
+
+    // from and to lg, beyond the range of double.
+    std::vector<lg<double>> ls(n);
+    for (std::size_t i = 0; i < n; ++i)
+        ls[i] = lg<double>::from_log(1000.0 * (i / 64) + 3 * u(g));
+    A const l{ std::span<lg<double> const>(ls) };
+    std::vector<lg<double>> lb(n);
+    l.copy_to(std::span<lg<double>>(lb));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        // exp(k) relative to exp(top) = log1p of the relative error.
+        auto const t = std::exp(ls[i].k - (1000.0 * (i / 64) + 3));
+        ok &= std::abs(std::exp(lb[i].k - ls[i].k) - 1.0) * t < 8 * tol;
+    }
+
+    // from and to scaled.
+    using Q = scaled<double,1,1024>;
+    std::vector<Q> qs(n), qb(n);
+    for (std::size_t i = 0; i < n; ++i)
+        qs[i] = Q::from_scaled(xs[i]);
+    A const q{ std::span<Q const>(qs) };
+    q.copy_to(std::span<Q>(qb));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        ok &= error(q[i], std::ldexp(xs[i], 10), std::ldexp(block_top(xs, i), 10)) < tol;
+        ok &= std::abs(qb[i].k - xs[i]) <= tol * block_top(xs, i);
+    }
+
+    // blocks of zeros do not decide the alignment of a sum.
+    std::vector<double> small(n, 1e-300), zero(n, 0.0);
+    auto const z = A{ std::span<double const>(small) } + A{ std::span<double const>(zero) };
+    ok &= (double)z[0] == (double)A{ std::span<double const>(small) }[0] && (double)z[0] != 0.0;
+
+    // lg exponents near and beyond the range of a block, which saturate
+    // above 2^29 and flush to 0 below -2^29.
+    auto const ln2 = std::log(2.0);
+    std::vector<lg<double>> hs{ lg<double>::from_log(1e10), lg<double>::from_log(1e8),
+        lg<double>::from_log(1e8 - 1), lg<double>::from_log(-1e8), lg<double>::from_log(-1e10) };
+    hs.resize(4 * 64, lg<double>::from_log(-1e8));
+    for (std::size_t i = 0; i < 64; ++i)
+    {
+        hs[64 + i] = lg<double>::from_log(1e8 + i);
+        hs[128 + i] = lg<double>::from_log(-1e8 - i);
+        hs[192 + i] = lg<double>::from_log(-1e10 - i);
+    }
+    A const h{ std::span<lg<double> const>(hs) };
+    auto const e = h.exponents();
+    ok &= e[0] == block_scaled_detail::max_exponent && e[1] < block_scaled_detail::max_exponent && e[1] > 1e8 / ln2;
+    ok &= e[2] < -1e8 / ln2 + 64 && e[2] > block_scaled_detail::min_exponent && e[3] == block_scaled_detail::zero_exponent;
+    ok &= h[0].m > 0 && h[1].m == 0 && h[4].m == 0 && h[192].m == 0;
+    std::vector<lg<double>> hb(hs.size());
+    h.copy_to(std::span<lg<double>>(hb));
+    ok &= std::abs(hb[127].k - hs[127].k) <= 8 * tol && std::abs(hb[128].k - hs[128].k) <= 8 * tol;
+    ok &= std::isinf(hb[192].k) && hb[192].k < 0;
+
+    // products whose exponents would overflow int32 saturate or flush.
+    auto hh = h * h;
+    for (int i = 0; i < 4; ++i)
+        hh = hh * hh;
+    ok &= hh.exponents()[0] == block_scaled_detail::max_exponent && hh.exponents()[1] == block_scaled_detail::max_exponent;
+    ok &= hh.exponents()[2] == block_scaled_detail::zero_exponent && hh[128].m == 0;
+    auto const hs2 = h + h;
+    ok &= hs2.exponents()[0] == block_scaled_detail::max_exponent && hs2.exponents()[3] == block_scaled_detail::zero_exponent;
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = check<float>(std::ldexp(1.0, -23)) && check<std::int16_t>(std::ldexp(1.0, -14));
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include "homomorphic_computational_extensions/epsilon_arithmetic.hpp"
+#include "homomorphic_computational_extensions/fast_math.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace alex::math;
+
+int main()
+{
+    bool ok = true;
+
+    std::mt19937_64 g(5);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::uniform_real_distribution<double> p(0.0, 1.0);
+    std::uniform_int_distribution<int> digits(3, 16);
+
+    // operands of every magnitude in [2^-20, 2^20], with relative eps in
+    // [1e-16, 1e-3] or exact.
+    auto const operand = [&](double lo, double hi)
+    {
+        auto const v = std::ldexp(lo < 0 ? u(g) : p(g) + 0.5, int(lo + (hi - lo) * p(g)));
+        auto const e = p(g) < 0.2 ? 0.0 : std::abs(v) * std::pow(10.0, -digits(g));
+        return epsilon<double>(v, e);
+    };
+
+    // a point of the interval of x: an end or a random point.
+    auto const point = [&](epsilon<double> const & x) -> long double
+    {
+        auto const t = p(g);
+        auto const s = t < 0.25 ? -1.0L : t < 0.5 ? 1.0L : 2.0L * p(g) - 1.0L;
+        return (long double)x.value + s * (long double)x.eps;
+    };
+
+    // z holds its claim for f on points of the intervals of x and y,
+    // evaluated in long double.
+    auto const holds = [&](epsilon<double> const & z, long double r)
+    {
+        return std::abs(r - (long double)z.value) <= (long double)z.eps;
+    };
+
+    std::size_t const n = 1000;
+    std::vector<epsilon<double>> xs, ys, es, ls;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        xs.push_back(operand(-20.0, 20.0));
+        ys.push_back(operand(-20.0, 20.0));
+        es.push_back(epsilon<double>(60.0 * u(g), p(g) < 0.2 ? 0.0 : std::pow(10.0, -digits(g))));
+        ls.push_back(operand(0.0, 20.0));
+    }
+
+    std::vector<epsilon<double>> sum(n, epsilon<double>(0.0, 0.0)), diff = sum, prod = sum, quot = sum, ex = sum, lx = sum, fx = sum;
+    add(std::span<epsilon<double> const>(xs), std::span<epsilon<double> const>(ys), std::span<epsilon<double>>(sum));
+    sub(std::span<epsilon<double> const>(xs), std::span<epsilon<double> const>(ys), std::span<epsilon<double>>(diff));
+    mul(std::span<epsilon<double> const>(xs), std::span<epsilon<double> const>(ys), std::span<epsilon<double>>(prod));
+    div(std::span<epsilon<double> const>(xs), std::span<epsilon<double> const>(ys), std::span<epsilon<double>>(quot));
+    exp(std::span<epsilon<double> const>(es), std::span<epsilon<double>>(ex));
+    log(std::span<epsilon<double> const>(ls), std::span<epsilon<double>>(lx));
+    exp<fast_math>(std::span<epsilon<double> const>(es), std::span<epsilon<double>>(fx));
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto const & x = xs[i];
+        auto const & y = ys[i];
+        for (int t = 0; t < 8; ++t)
+        {
+            auto const a = point(x), b = point(y), e = point(es[i]), l = point(ls[i]);
+            ok &= holds(x + y, a + b) && holds(sum[i], a + b);
+            ok &= holds(x - y, a - b) && holds(diff[i], a - b);
+            ok &= holds(x * y, a * b) && holds(prod[i], a * b);
+            ok &= holds(x / y, a / b) && holds(quot[i], a / b);
+            ok &= holds(exp(es[i]), std::exp(e)) && holds(ex[i], std::exp(e)) && holds(fx[i], std::exp(e));
+            ok &= holds(log(ls[i]), std::log(l)) && holds(lx[i], std::log(l));
+        }
+
+        // the batch forms compute the same values.
+        ok &= sum[i].value == (x + y).value && prod[i].value == (x * y).value;
+        ok &= quot[i].value == (x / y).value && lx[i].value == log(ls[i]).value;
+    }
+
+    // exact operands give bounds of a few units of roundoff.
+    auto const r = epsilon<double>(0.1, 0.0) + epsilon<double>(0.2, 0.0);
+    ok &= r.eps > 0.0 && r.eps < 4e-16 && holds(r, (long double)0.1 + (long double)0.2);
+
+    // an interval that reaches 0 cannot be a divisor or the argument of log.
+    ok &= std::isinf((epsilon<double>(1.0, 0.0) / epsilon<double>(0.5, 0.5)).eps);
+    ok &= std::isinf(log(epsilon<double>(1.0, 2.0)).eps);
+
+    // a long computation carries its bound: Horner's scheme for the
+    // Taylor polynomial of exp at 1, which sums to about e.
+    epsilon<double> h(1.0, 0.0);
+    long double hl = 1.0L;
+    for (int k = 20; k >= 1; --k)
+    {
+        h = epsilon<double>(1.0, 0.0) + h / epsilon<double>(double(k), 0.0);
+        hl = 1.0L + hl / k;
+    }
+    ok &= holds(h, hl) && h.eps < 1e-14;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#include "homomorphic_computational_extensions/epsilon_index.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace alex::math;
+
+int main()
+{
+    bool ok = true;
+
+    // mostly small tolerances, with a few wide ones that reach far from
+    // their values.
+    std::mt19937_64 g(3);
+    std::uniform_real_distribution<double> u(0.0, 100.0);
+    std::uniform_real_distribution<double> e(0.0, 0.5);
+    std::exponential_distribution<double> wide(1.0);
+    std::vector<epsilon<double>> xs;
+    for (int i = 0; i < 20000; ++i)
+        xs.push_back(epsilon<double>(u(g), i % 50 == 0 ? 3 * wide(g) : e(g) / 10));
+
+    thread_pool pool(4);
+    epsilon_index<double> const idx(std::span<epsilon<double> const>(xs), pool);
+    epsilon_index<double> const serial{ std::span<epsilon<double> const>(xs) };
+
+    // a query reports exactly the positions a scan finds, once each, in
+    // increasing order of value.
+    auto const check = [&](std::vector<std::size_t> const & r, auto pred)
+    {
+        std::set<std::size_t> const s(r.begin(), r.end());
+        bool good = s.size() == r.size();
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            good &= pred(xs[i]) == (s.count(i) > 0);
+        for (std::size_t i = 1; i < r.size(); ++i)
+            good &= !(xs[r[i]].value < xs[r[i - 1]].value);
+        return good;
+    };
+
+    for (int t = 0; t < 200; ++t)
+    {
+        epsilon<double> const a(u(g), e(g));
+        epsilon<double> const b(a.value + u(g) / 10, e(g));
+        ok &= check(idx.equal(a), [&](auto const & x) { return x == a; });
+        ok &= check(idx.less(a), [&](auto const & x) { return x < a; });
+        ok &= check(idx.greater(a), [&](auto const & x) { return x > a; });
+        ok &= check(idx.range(a, b), [&](auto const & x) { return a <= x && x <= b; });
+        ok &= serial.equal(a) == idx.equal(a);
+    }
+
+    std::vector<epsilon<double>> const none;
+    epsilon_index<double> const empty{ std::span<epsilon<double> const>(none) };
+    ok &= empty.size() == 0 && empty.equal(epsilon<double>(1.0, 1.0)).empty();
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include "homomorphic_computational_extensions/fast_math.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+// The error of y in units of the last place of the reference r.
+template <typename T>
+double ulps(T y, T r)
+{
+    if (std::isnan(r))
+        return std::isnan(y) ? 0 : std::numeric_limits<double>::infinity();
+    if (std::isinf(r))
+        return y == r ? 0 : std::numeric_limits<double>::infinity();
+    T const ulp = std::nextafter(std::abs(r), std::numeric_limits<T>::infinity()) - std::abs(r);
+    return std::abs((double)y - (double)r) / (double)ulp;
+}
+
+template <typename T, typename U>
+std::vector<T> full_range(std::size_t n)
+{
+    // uniformly distributed bit patterns over the non-negative values of T,
+    // i.e., every binade is sampled equally often.
+    std::mt19937_64 g(1);
+    std::uniform_int_distribution<U> u(0, std::bit_cast<U>(std::numeric_limits<T>::max()));
+    std::vector<T> xs(n);
+    for (auto & x : xs)
+        x = std::bit_cast<T>(u(g));
+    return xs;
+}
+
+template <typename T>
+std::vector<T> uniform(std::size_t n, T a, T b)
+{
+    std::mt19937_64 g(2);
+    std::uniform_real_distribution<T> u(a, b);
+    std::vector<T> xs(n);
+    for (auto & x : xs)
+        x = u(g);
+    return xs;
+}
+
+template <typename T, typename F, typename G>
+bool check(char const * name, std::vector<T> xs, F f, G ref, double bound)
+{
+    std::vector<T> ys(xs.size());
+    f(xs.data(), ys.data(), xs.size());
+
+    double worst = 0;
+    T arg = 0;
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        auto const e = ulps(ys[i], ref(xs[i]));
+        if (e > worst)
+        {
+            worst = e;
+            arg = xs[i];
+        }
+    }
+    std::cout << name << ": max error " << worst << " ulp at " << arg << "\n";
+    return worst <= bound;
+}
+
+int main()
+{
+    constexpr std::size_t n = 1 << 24;
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    bool ok = true;
+
+    auto dlog = [](double const * x, double * y, std::size_t n) { fast_math::log(x, y, n); };
+    auto dexp = [](double const * x, double * y, std::size_t n) { fast_math::exp(x, y, n); };
+    auto flog = [](float const * x, float * y, std::size_t n) { fast_math::log(x, y, n); };
+    auto fexp = [](float const * x, float * y, std::size_t n) { fast_math::exp(x, y, n); };
+    auto slog = [](auto x) { return std::log(x); };
+    auto sexp = [](auto x) { return std::exp(x); };
+
+    ok &= check("log<double>", full_range<double, std::uint64_t>(n), dlog, slog, 1);
+    ok &= check("log<double> near 1", uniform(n, 0.5, 2.0), dlog, slog, 1);
+    ok &= check("exp<double>", uniform(n, -750.0, 712.0), dexp, sexp, 1);
+    ok &= check("exp<double> near 0", uniform(n, -1.0, 1.0), dexp, sexp, 1);
+    ok &= check("log<float>", full_range<float, std::uint32_t>(n), flog, slog, 1);
+    ok &= check("log<float> near 1", uniform(n, 0.5f, 2.0f), flog, slog, 1);
+    ok &= check("exp<float>", uniform(n, -106.0f, 90.0f), fexp, sexp, 1);
+    ok &= check("exp<float> near 0", uniform(n, -1.0f, 1.0f), fexp, sexp, 1);
+
+    std::vector<double> special { 0.0, -0.0, -1.0, inf, -inf, nan, 1.0, 0x1p-1074, 0x1p-1022 };
+    ok &= check("log<double> special", special, dlog, slog, 1);
+    ok &= check("exp<double> special", special, dexp, sexp, 1);
+
+    // the scalar kernels are the ones used by lg<T,fast_math>.
+    auto x = lg<double,fast_math>(3.0) * lg<double,fast_math>(4.0);
+    ok &= ulps((double)x, 12.0) <= 4;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
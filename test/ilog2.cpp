@@ -0,0 +1,80 @@
+#include "homomorphic_computational_extensions/ilog2.hpp"
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static_assert(ilog2(std::uint8_t(1)) == 0 && ilog2(std::uint8_t(255)) == 7 && ilog2(0u) == -1);
+static_assert(ilog2(std::uint16_t(256)) == 8 && ilog2(~0ull) == 63 && ilog2(std::uint64_t(1) << 40) == 40);
+static_assert(log_bucket<2>(7u) == 7 && log_bucket<2>(8u) == 8 && log_bucket<2>(10u) == 9 && log_bucket<2>(16u) == 12);
+static_assert(log_bucket_floor<2>(9u) == 10u && log_bucket_floor<2>(12u) == 16u);
+
+int main()
+{
+    bool ok = true;
+
+    std::mt19937_64 g(13);
+    std::vector<std::uint32_t> xs(10000);
+    std::vector<std::uint64_t> ys(10000);
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        // every bit width is equally likely.
+        ys[i] = g() >> (g() % 64);
+        xs[i] = std::uint32_t(ys[i] >> 32);
+    }
+    xs[0] = 0;
+    ys[1] = 0;
+
+    // against the definition, for every width.
+    auto const floor_log2 = [](std::uint64_t x) { int e = -1; for (; x; x >>= 1) ++e; return e; };
+    std::vector<int> es(xs.size()), fs(ys.size());
+    ilog2(std::span<std::uint32_t const>(xs), std::span<int>(es));
+    ilog2(std::span<std::uint64_t const>(ys), std::span<int>(fs));
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        ok &= es[i] == floor_log2(xs[i]) && fs[i] == floor_log2(ys[i]) && ilog2(std::uint16_t(ys[i])) == floor_log2(std::uint16_t(ys[i]));
+
+#ifdef __SIZEOF_INT128__
+    auto const big = (ilog2_detail::uint128(1) << 100) + 3;
+    ok &= ilog2(big) == 100 && ilog2(ilog2_detail::uint128(5)) == 2;
+#endif
+
+    // a 3-limb integer.
+    std::uint32_t const limbs[] = { 7, 0, 1u << 5 };
+    ok &= ilog2(std::span<std::uint32_t const>(limbs)) == 69;
+    std::uint64_t const zeros[] = { 0, 0 };
+    ok &= ilog2(std::span<std::uint64_t const>(zeros)) == -1;
+
+    // the buckets are consecutive, in order, and within a factor 1 + 2^-S.
+    std::uint64_t b = 0;
+    for (std::uint64_t x = 1; x < 100000; ++x)
+    {
+        auto const c = log_bucket<4>(x);
+        ok &= c == b || c == b + 1;
+        ok &= log_bucket_floor<4>(c) <= x && x < log_bucket_floor<4>(c) * (1.0 + 1.0 / 16) + 1;
+        b = c;
+    }
+    std::vector<std::uint64_t> bs(ys.size());
+    log_bucket<6>(std::span<std::uint64_t const>(ys), std::span<std::uint64_t>(bs));
+    for (std::size_t i = 0; i < ys.size(); ++i)
+        ok &= bs[i] == log_bucket<6>(ys[i]) && log_bucket_floor<6>(bs[i]) <= ys[i];
+
+    // the log of counts, without log.
+    for (std::size_t i = 0; i < ys.size(); ++i)
+        if (ys[i] != 0)
+            ok &= std::abs(approx_log2(ys[i]) - std::log2((double)ys[i])) < 3e-6;
+    for (std::uint64_t x = 1; x < 512; ++x)
+        ok &= std::abs(approx_log2(x) - std::log2((double)x)) < 1e-15 * std::log2(512.0);
+    ok &= approx_log2(0) == -HUGE_VAL;
+
+    std::vector<lg<double>> ls(ys.size());
+    from_integers(std::span<std::uint64_t const>(ys), std::span<lg<double>>(ls));
+    for (std::size_t i = 0; i < ys.size(); ++i)
+        ok &= ys[i] == 0 ? ls[i].k == -HUGE_VAL : std::abs(ls[i].k - std::log((double)ys[i])) < 2.1e-6;
+    ok &= lg<double>::from_integer(1).k == 0.0 && lg<double>::from_integer(0).k == -HUGE_VAL;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
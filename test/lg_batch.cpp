@@ -0,0 +1,91 @@
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+// the kernels against scalar folds, for every length up to a few packs
+// and some longer than a block.
+template <typename T, typename M>
+bool check(T tol)
+{
+    bool ok = true;
+    using L = lg<T,M>;
+    auto const inf = std::numeric_limits<T>::infinity();
+
+    std::mt19937_64 g(13);
+    std::uniform_real_distribution<T> u(T(0.01), T(1));
+    std::vector<std::size_t> lengths{ 257, 1000, 1003 };
+    for (std::size_t n = 1; n <= 4 * simd::pack<T>::width + 1; ++n)
+        lengths.push_back(n);
+
+    for (auto const n : lengths)
+    {
+        std::vector<T> ps(n);
+        std::vector<L> xs(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            ps[i] = u(g);
+            xs[i] = L(ps[i]);
+        }
+
+        // the sequential fold, and the sum of the magnitudes of the
+        // exponents, which bounds the error of reordering the sum.
+        auto p = L();
+        auto hi = xs[0], lo = xs[0];
+        T a = T(0);
+        for (auto const & x : xs)
+        {
+            p = p * x;
+            hi = std::max(hi, x);
+            lo = std::min(lo, x);
+            a = a + std::abs(x.k);
+        }
+
+        ok &= std::abs(product(std::span<L const>(xs)).k - p.k) <= tol * a && std::abs(product(xs).k - p.k) <= tol * a;
+        ok &= std::abs(product_of<M>(std::span<T const>(ps)).k - p.k) <= tol * a && std::abs(product_of<M>(ps).k - p.k) <= tol * a;
+        ok &= maximum(std::span<L const>(xs)) == hi && maximum(xs) == hi;
+        ok &= minimum(std::span<L const>(xs)) == lo && minimum(xs) == lo;
+
+        std::vector<T> ys(n);
+        to_source(xs, ys);
+        for (std::size_t i = 0; i < n; ++i)
+            ok &= std::abs(ys[i] - ps[i]) <= tol * ps[i];
+    }
+
+    // the empty product is the identity.
+    ok &= product(std::span<L const>()).k == T(0) && product(std::vector<L>()).k == T(0);
+    ok &= product_of<M>(std::span<T const>()).k == T(0);
+
+    // infinite exponents, i.e., zeros and infinities, in the last lane
+    // of a pack and in the remainder.
+    std::vector<L> zs(3 * simd::pack<T>::width + 1, L(T(0.5)));
+    zs[simd::pack<T>::width - 1] = L::from_log(-inf);
+    ok &= product(zs).k == -inf && minimum(zs).k == -inf && maximum(zs) == L(T(0.5));
+    zs[simd::pack<T>::width - 1] = L(T(0.5));
+    zs.back() = L::from_log(inf);
+    ok &= product(zs).k == inf && maximum(zs).k == inf && minimum(zs) == L(T(0.5));
+    zs.front() = L::from_log(-inf);
+    ok &= maximum(zs).k == inf && minimum(zs).k == -inf && std::isnan(product(zs).k);
+
+    std::vector<T> qs(5, T(0.5));
+    qs[4] = T(0);
+    ok &= product_of<M>(qs).k == -inf;
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= check<double, std_math>(1e-15) && check<double, fast_math>(1e-15);
+    ok &= check<float, std_math>(1e-6f) && check<float, fast_math>(1e-6f);
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_expr.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+int main()
+{
+    using L = lg<double>;
+    bool ok = true;
+    auto const inf = std::numeric_limits<double>::infinity();
+    auto const zero = L::from_log(-inf);
+
+    // equal terms are folded, so x + x + x is exactly lg(3) * x.
+    auto const x = L::from_log(-1234.5);
+    ok &= eval(x + x + x).k == (L(3.0) * x).k && eval(x + (x + x)).k == (L(3.0) * x).k;
+    ok &= eval(x + x).k == (L(2.0) * x).k;
+
+    // a*b + c*d + e against long double, beyond the range of double.
+    std::mt19937_64 g(3);
+    std::uniform_real_distribution<double> u(-800.0, 800.0);
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto const a = L::from_log(u(g)), b = L::from_log(u(g)), c = L::from_log(u(g)), d = L::from_log(u(g));
+        auto const e = L::from_log(u(g));
+        L const r = a*b + c*d + e;
+        long double const k[] = { (long double)a.k + b.k, (long double)c.k + d.k, (long double)e.k };
+        auto const m = std::max({ k[0], k[1], k[2] });
+        auto const ref = m + std::log(std::exp(k[0] - m) + std::exp(k[1] - m) + std::exp(k[2] - m));
+        ok &= std::abs(r.k - ref) <= 4e-16L * std::max(1.0L, std::abs(ref));
+    }
+
+    // zero terms drop out, and an infinite term is the sum.
+    ok &= eval(x + zero).k == x.k && eval(zero + x + zero).k == x.k && eval(zero + zero).k == -inf;
+    ok &= eval(x + L::from_log(inf)).k == inf && eval(zero + L::from_log(inf)).k == inf;
+    ok &= eval(x * zero + x).k == x.k;
+
+    // products and quotients of sums, to within a few roundings.
+    auto const p = L(2.0), q = L(3.0), s = L(5.0);
+    auto const eps = std::numeric_limits<double>::epsilon();
+    ok &= std::abs(eval((p + q) * s).k - std::log(25.0)) <= 8 * eps && std::abs(eval(s * (p + q)).k - std::log(25.0)) <= 8 * eps;
+    ok &= std::abs(eval((p + q) * (q + s)).k - std::log(40.0)) <= 8 * eps;
+    ok &= std::abs(eval((p + q) / s).k) <= 4 * eps && std::abs(eval(s / (p + q)).k) <= 4 * eps;
+    ok &= std::abs(eval((p + s) / (q + q)).k - std::log(7.0 / 6.0)) <= 4 * eps;
+
+    // conversion to lg<T,M> and to T.
+    L const t = p + q + s;
+    ok &= std::abs(t.k - std::log(10.0)) <= 4 * eps && std::abs((double)(p + q + s) - 10.0) <= 10 * 8 * eps;
+    ok &= std::abs((double)((p + q) * s) - 25.0) <= 25 * 8 * eps;
+
+    // with the fast_math policy.
+    using F = lg<float, fast_math>;
+    F const y = F(0.25f) + F(0.5f) + F(0.25f);
+    ok &= std::abs(y.k) <= 2e-7f && eval(F(0.5f) + F(0.5f) + F(0.5f)).k == (F(3.0f) * F(0.5f)).k;
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include "homomorphic_computational_extensions/lg_gemm.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+int main()
+{
+    std::mt19937_64 g(2);
+    std::normal_distribution<double> d(0.0, 30.0);
+    bool ok = true;
+
+    for (auto [n, p, m] : { std::tuple{1, 1, 1}, {5, 7, 3}, {37, 129, 70}, {64, 300, 33}, {3, 0, 4} })
+    {
+        std::vector<lg<double>> a(n * p), b(p * m), c(n * m), r(n * m);
+        for (auto & x : a)
+            x = lg<double>::from_log(d(g));
+        for (auto & x : b)
+            x = lg<double>::from_log(d(g));
+
+        // a row of zeros, and a value so large that the factored sums of
+        // its row underflow for most columns.
+        if (n > 3 && p > 0)
+        {
+            for (int k = 0; k < p; ++k)
+                a[2 * p + k] = lg<double>::from_log(-numeric_limits<double>::infinity());
+            a[0] = lg<double>::from_log(5000.0);
+        }
+
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < m; ++j)
+            {
+                log_exp_sum<double> acc;
+                for (int k = 0; k < p; ++k)
+                    acc += a[i * p + k] * b[k * m + j];
+                r[i * m + j] = acc.value();
+            }
+
+        for (std::size_t threads : { 1, 3 })
+        {
+            thread_pool pool(threads);
+            matmul(std::span<lg<double> const>(a), std::span<lg<double> const>(b), std::span<lg<double>>(c), n, p, m, pool);
+            for (int i = 0; i < n * m; ++i)
+                ok &= c[i].k == r[i].k || std::abs(c[i].k - r[i].k) <= 1e-14 * std::max(1.0, std::abs(r[i].k));
+        }
+    }
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include "homomorphic_computational_extensions/lg_q.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using q16 = lg_q<std::uint16_t,1024>;
+using q8 = lg_q<std::uint8_t,4>;
+using q8_3 = lg_q<std::uint8_t,3,1,200>;
+
+static_assert(sizeof(q16) == 2 && sizeof(q8) == 1);
+
+int main()
+{
+    bool ok = true;
+
+    // the identity, zero and saturation.
+    ok &= q16().to_lg<double>().k == 0 && q16() * q16() == q16();
+    ok &= q16(lg<double>::from_log(-std::numeric_limits<double>::infinity())).q == 0 && std::isinf(q16::from_code(0).to_lg<double>().k);
+    ok &= q16(lg<double>(1e-40)).q == 0 && q16(lg<double>::from_log(-65534.0 / 1024)).q == 1;
+    ok &= q16(lg<double>(5.0)).q == 65535 && q8_3(lg<double>(1e10)).q == 255;
+    ok &= q8(lg<double>::from_log(-63.5)).q == 1 && q8(lg<double>::from_log(-63.6)).q == 1 && q8(lg<double>::from_log(-63.7)).q == 0;
+
+    // quantizing is within half a code, and dequantizing is exact for
+    // a power-of-two scale.
+    std::mt19937_64 g(23);
+    std::uniform_real_distribution<double> u(-60.0, 0.0);
+    std::vector<lg<double>> xs(10003);
+    for (auto & x : xs)
+        x = lg<double>::from_log(u(g));
+
+    std::vector<q16> qs(xs.size());
+    std::vector<q8_3> rs(xs.size());
+    quantize(xs, qs);
+    quantize(xs, rs);
+    std::vector<lg<float>> ys(xs.size()), zs(xs.size());
+    dequantize(qs, ys);
+    dequantize(rs, zs);
+
+    // from lg<float>, and to and from 8-bit codes, a pack at a time.
+    std::vector<lg<float>> fs(xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        fs[i] = lg<float>::from_log(float(xs[i].k));
+    std::vector<q16> gs(xs.size());
+    std::vector<q8> hs(xs.size());
+    quantize(fs, gs);
+    quantize(fs, hs);
+    std::vector<lg<double>> es(xs.size());
+    dequantize(hs, es);
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        ok &= qs[i] == q16(xs[i]) && rs[i] == q8_3(xs[i]);
+        ok &= std::abs(ys[i].k - xs[i].k) <= 0.5 / 1024 && double(ys[i].k) * 1024 == std::round(xs[i].k * 1024);
+        ok &= std::abs(double(lg<double>(rs[i]).k) - xs[i].k) <= 0.5 / 3 + 1e-12;
+        ok &= ys[i].k == lg<float>(qs[i]).k && zs[i].k == lg<float>(rs[i]).k;
+        ok &= gs[i] == q16(fs[i]) && std::abs(int(gs[i].q) - int(qs[i].q)) <= 1;
+        ok &= hs[i] == q8(fs[i]) && es[i].k == hs[i].to_lg<double>().k && std::abs(es[i].k - xs[i].k) <= 0.125 + 1e-6;
+    }
+
+    // products are sums of the codes, and quotients differences.
+    std::vector<q16> ps(qs.size() - 1);
+    multiply(std::span<q16 const>(qs.data(), ps.size()), std::span<q16 const>(qs.data() + 1, ps.size()), std::span<q16>(ps));
+    for (std::size_t i = 0; i < ps.size(); ++i)
+    {
+        auto const k = double(qs[i].to_lg<double>().k) + qs[i + 1].to_lg<double>().k;
+        ok &= ps[i] == qs[i] * qs[i + 1];
+        ok &= k < -64 ? ps[i].q == 0 : ps[i].to_lg<double>().k == k;
+        ok &= (qs[i] / qs[i + 1]).to_lg<double>().k == std::min(qs[i].to_lg<double>().k - qs[i + 1].to_lg<double>().k, 0.0);
+    }
+    auto const zero = q16::from_code(0);
+    ok &= zero * qs[0] == zero && qs[0] * zero == zero && zero / qs[0] == zero && (qs[0] / zero).q == 65535;
+    ok &= q16::from_code(1) * q16::from_code(65000) == zero && (q16::from_code(65535) * q16::from_code(65535)).q == 65535;
+
+    // the order of the codes is the order of the values.
+    ok &= (qs[0] < qs[1]) == (ys[0] < ys[1]) && zero < qs[0] && qs[0] <= q16();
+
+    // a product of n factors is within n/2 codes of the exact one.
+    double k = 0;
+    q16 p;
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        auto const x = lg<double>::from_log(u(g) / 100);
+        k += x.k;
+        p = p * q16(x);
+    }
+    ok &= std::abs(p.to_lg<double>().k - k) <= 100 * 0.5 / 1024;
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/lg_scan.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main()
+{
+    bool ok = true;
+
+    std::mt19937_64 g(21);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::size_t const n = 100003;
+    std::vector<lg<double>> xs(n);
+    for (auto & x : xs)
+        x = lg<double>(u(g));
+
+    // against a running sum of the exponents in long double.
+    std::vector<long double> ref(n);
+    long double r = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        ref[i] = r += xs[i].k;
+
+    std::vector<lg<double>> ys(n), zs(n), cs(n);
+    inclusive_product(xs, ys);
+    inclusive_product(xs, cs, true);
+    exclusive_product(xs, zs);
+    double err = 0, cerr = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        err = std::max(err, double(std::fabs(ys[i].k - ref[i])));
+        cerr = std::max(cerr, double(std::fabs(cs[i].k - ref[i]) / std::fabs(ref[i])));
+        ok &= zs[i].k == (i == 0 ? 0.0 : ys[i - 1].k);
+    }
+    ok &= err < 1e-8 && cerr <= 0x1p-52;
+
+    // the same for any number of threads, and close to the serial scan.
+    std::vector<lg<double>> ps(n), qs(n);
+    for (std::size_t threads : {1, 3, 8})
+    {
+        thread_pool pool(threads);
+        inclusive_product(xs, qs, pool, false, 1000);
+        if (threads == 1)
+            ps = qs;
+        for (std::size_t i = 0; i < n; ++i)
+            ok &= qs[i].k == ps[i].k && std::fabs(qs[i].k - ref[i]) < 1e-8;
+
+        exclusive_product(xs, qs, pool, true, 1000);
+        for (std::size_t i = 0; i < n; ++i)
+            ok &= std::fabs(qs[i].k - (i == 0 ? 0 : ref[i - 1])) <= 0x1p-52 * std::fabs(ref[i]);
+    }
+
+    // in place.
+    auto ws = xs;
+    exclusive_product(ws, ws);
+    for (std::size_t i = 0; i < n; ++i)
+        ok &= ws[i].k == zs[i].k;
+
+    // log-sum-exp, against the running sum of the values in long double,
+    // with exponents spread over a range that overflows double.
+    std::uniform_real_distribution<double> v(-2000.0, 2000.0);
+    std::vector<lg<double>> as(20000), bs(as.size()), es(as.size());
+    for (std::size_t i = 0; i < as.size(); ++i)
+        as[i] = lg<double>::from_log(v(g) * std::sqrt(double(i) / as.size()));
+    as[5] = lg<double>::from_log(-HUGE_VAL);
+
+    std::vector<long double> lse(as.size());
+    long double m = -HUGE_VALL, s = 0;
+    for (std::size_t i = 0; i < as.size(); ++i)
+    {
+        long double const k = as[i].k;
+        if (k > m)
+        {
+            s = s * std::exp(m - k) + 1;
+            m = k;
+        }
+        else
+            s += std::exp(k - m);
+        lse[i] = m + std::log(s);
+    }
+
+    for (bool compensated : {false, true})
+    {
+        inclusive_sum(as, bs, compensated);
+        exclusive_sum(as, es, compensated);
+        for (std::size_t i = 0; i < as.size(); ++i)
+            ok &= std::fabs(bs[i].k - lse[i]) <= 1e-12 * (1 + std::fabs(lse[i])) && es[i].k == (i == 0 ? -HUGE_VAL : bs[i - 1].k);
+
+        thread_pool pool(4);
+        inclusive_sum(as, bs, pool, compensated, 1000);
+        exclusive_sum(as, es, pool, compensated, 1000);
+        for (std::size_t i = 0; i < as.size(); ++i)
+            ok &= std::fabs(bs[i].k - lse[i]) <= 1e-12 * (1 + std::fabs(lse[i])) &&
+                (i == 0 ? es[i].k == -HUGE_VAL : std::fabs(es[i].k - lse[i - 1]) <= 1e-12 * (1 + std::fabs(lse[i])));
+    }
+
+    // the prefix products of lg<neumaier<double>> are compensated, with or
+    // without the flag, so a long sum of 0.1 is exact to within an ulp.
+    std::vector<lg<neumaier<double>>> ns(3001, lg<neumaier<double>>::from_log(neumaier<double>(0.1))), nt(ns.size());
+    for (bool compensated : {false, true})
+    {
+        thread_pool pool(2);
+        inclusive_product(ns, nt, compensated);
+        ok &= std::fabs(nt.back().k.value() - 300.1) <= 6e-14;
+        exclusive_product(ns, nt, pool, compensated, 500);
+        ok &= nt[0].k.value() == 0 && std::fabs(nt.back().k.value() - 300.0) <= 6e-14;
+    }
+
+    // the prefix sums of probabilities end at their sum, with fast_math.
+    std::vector<lg<double, fast_math>> fs(1000), gs(fs.size());
+    for (auto & f : fs)
+        f = lg<double, fast_math>(u(g) / 1000);
+    inclusive_sum(fs, gs);
+    long double t = 0;
+    for (std::size_t i = 0; i < fs.size(); ++i)
+    {
+        t += std::exp((long double)fs[i].k);
+        ok &= std::fabs(gs[i].k - std::log(t)) < 1e-13;
+    }
+
+    // the empty sum and product.
+    std::vector<lg<double>> none;
+    inclusive_sum(none, none);
+    exclusive_product(none, none);
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
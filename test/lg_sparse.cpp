@@ -0,0 +1,111 @@
+#include "homomorphic_computational_extensions/lg_sparse.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+int main()
+{
+    using L = lg<double>;
+    bool ok = true;
+    auto const zero = L::from_log(-std::numeric_limits<double>::infinity());
+
+    // a 300 x 200 matrix of probabilities, 95% zero, and a dense vector.
+    std::size_t const n = 300, m = 200;
+    std::mt19937_64 g(29);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<double> p(n * m);
+    std::vector<L> a(n * m), x(m);
+    for (std::size_t i = 0; i < n * m; ++i)
+    {
+        p[i] = u(g) < 0.05 ? u(g) : 0.0;
+        a[i] = p[i] == 0 ? zero : L(p[i]);
+    }
+    for (auto & y : x)
+        y = L(u(g));
+    x[3] = zero;
+
+    // serial and parallel construction, from lg and from probabilities.
+    thread_pool pool(4);
+    lg_sparse_matrix<double> s(std::span<L const>(a), n, m);
+    lg_sparse_matrix<double> t(std::span<L const>(a), n, m, pool);
+    auto const q = lg_sparse_matrix<double>::from_values(std::span<double const>(p), n, m, pool);
+    ok &= s.nnz() > 0 && s.nnz() < n * m / 10 && s.nnz() == t.nnz() && s.nnz() == q.nnz();
+    for (std::size_t r = 0; r < s.nnz(); ++r)
+    {
+        ok &= s.indices()[r] == t.indices()[r] && s.values()[r] == t.values()[r];
+        ok &= s.indices()[r] == q.indices()[r] && std::abs(s.values()[r].k - q.values()[r].k) <= 1e-15;
+    }
+    for (std::size_t i = 0; i <= n; ++i)
+        ok &= s.offsets()[i] == t.offsets()[i];
+
+    std::vector<L> d(n * m);
+    s.to_dense(d);
+    for (std::size_t i = 0; i < n * m; ++i)
+        ok &= d[i].k == a[i].k && s(i / m, i % m).k == a[i].k;
+    auto const st = s.transpose();
+    ok &= st.rows() == m && st.cols() == n && st.nnz() == s.nnz();
+    for (std::size_t i = 0; i < n; i += 7)
+        for (std::size_t j = 0; j < m; ++j)
+            ok &= st(j, i).k == s(i, j).k;
+
+    // matvec against the dense one of semiring.hpp.
+    std::vector<L> y(n), z(n), w(n);
+    matvec<lg_sum<double>>(std::span<L const>(a), std::span<L const>(x), std::span<L>(z), n, m);
+    matvec<lg_sum<double>>(s, std::span<L const>(x), std::span<L>(y));
+    matvec<lg_sum<double>>(s, std::span<L const>(x), std::span<L>(w), pool);
+    for (std::size_t i = 0; i < n; ++i)
+        ok &= std::abs(y[i].k - z[i].k) <= 1e-13 && y[i].k == w[i].k;
+    matvec<lg_max<double>>(std::span<L const>(a), std::span<L const>(x), std::span<L>(z), n, m);
+    matvec<lg_max<double>>(s, std::span<L const>(x), std::span<L>(y));
+    for (std::size_t i = 0; i < n; ++i)
+        ok &= y[i].k == z[i].k;
+
+    // vectors: a row, its dot product with x, its sum and its product with x.
+    std::span<L const> const row(a.data(), m);
+    lg_sparse_vector<double> v(row);
+    auto const vp = lg_sparse_vector<double>::from_values(std::span<double const>(p.data(), m));
+    ok &= v.nnz() == s.row_indices(0).size() && vp.nnz() == v.nnz();
+    log_exp_sum<double> e, f;
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        ok &= v[j].k == row[j].k && (vp[j].k == row[j].k || std::abs(vp[j].k - row[j].k) <= 1e-15);
+        e += row[j] * x[j];
+        f += row[j];
+    }
+    ok &= std::abs(dot(v, std::span<L const>(x)).k - e.value().k) <= 1e-13 && std::abs(sum(v).k - f.value().k) <= 1e-13;
+    auto const vx = v * std::span<L const>(x);
+    for (std::size_t j = 0; j < m; ++j)
+        ok &= vx[j].k == (row[j] * x[j]).k;
+
+    std::vector<L> vd(m);
+    v.to_dense(vd);
+    for (std::size_t j = 0; j < m; ++j)
+        ok &= vd[j].k == row[j].k;
+    ok &= lg_sparse_vector<double>(5).nnz() == 0 && sum(lg_sparse_vector<double>(5)).k == zero.k;
+
+    // an HMM whose states only move to the next two, against the dense forward.
+    std::size_t const states = 50, steps = 20;
+    std::vector<L> init(states), trans(states * states, zero), emit(steps * states), alpha(steps * states), beta(alpha.size());
+    for (std::size_t i = 0; i < states; ++i)
+    {
+        init[i] = L(1.0 / states);
+        trans[i * states + i] = L(0.6);
+        trans[i * states + (i + 1) % states] = L(0.4);
+    }
+    for (auto & b : emit)
+        b = L(u(g));
+    lg_sparse_matrix<double> sparse(std::span<L const>(trans), states, states);
+    auto const dense_f = forward<lg_sum<double>>(std::span<L const>(init), std::span<L const>(trans),
+        std::span<L const>(emit), std::span<L>(alpha), states, steps);
+    auto const sparse_f = forward<lg_sum<double>>(std::span<L const>(init), sparse, std::span<L const>(emit), std::span<L>(beta), steps);
+    auto const sparse_v = forward<lg_max<double>>(std::span<L const>(init), sparse, std::span<L const>(emit), std::span<L>(beta), steps);
+    auto const dense_v = forward<lg_max<double>>(std::span<L const>(init), std::span<L const>(trans),
+        std::span<L const>(emit), std::span<L>(alpha), states, steps);
+    ok &= sparse.nnz() == 2 * states && std::abs(dense_f.k - sparse_f.k) <= 1e-12 && dense_v.k == sparse_v.k;
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#include "homomorphic_computational_extensions/lg_vector.hpp"
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+int main()
+{
+    bool ok = true;
+    auto const near = [](double x, double y) { return std::abs(x - y) <= 1e-14 * std::abs(y); };
+
+    lg_vector<double> v{ lg<double>(2.0), lg<double>(3.0), lg<double>(0.5) };
+    ok &= (std::uintptr_t)v.data() % 64 == 0;
+
+    // log-probabilities written by some model, viewed without copying.
+    std::vector<double> raw{ std::log(4.0), std::log(5.0), std::log(0.25) };
+    lg_view<double const> w(raw.data(), raw.size());
+    ok &= (void const *)w.data() == (void const *)raw.data();
+
+    auto const p = v * w;
+    auto const q = v / lg<double>(2.0);
+    auto const r = pow(w, 2.0);
+    ok &= near(p[0], 8.0) && near(p[1], 15.0) && near(p[2], 0.125);
+    ok &= near(q[0], 1.0) && near(q[1], 1.5) && near(q[2], 0.25);
+    ok &= near(r[0], 16.0) && near(r[1], 25.0) && near(r[2], 0.0625);
+    ok &= (v < w) == std::vector<std::uint64_t>{ 0b011 } && (v >= w) == std::vector<std::uint64_t>{ 0b100 };
+    ok &= near(product(w), 5.0);
+
+    // writes through a view go to the viewed exponents.
+    lg_view<double> u(v);
+    u[0] = lg<double>(7.0);
+    ok &= near(v[0], 7.0);
+
+    // longer than a pack, with a tail.
+    lg_vector<double> x(1001, lg<double>(1.5));
+    auto const y = x * x;
+    for (auto const & e : y)
+        ok &= near(e, 2.25);
+
+    // comparisons, a bit per value, against the scalar ones.
+    lg_vector<double> z(1001);
+    for (std::size_t i = 0; i < z.size(); ++i)
+        z[i] = i % 3 == 0 ? x[i] : lg<double>(1.0 + double(i % 5) / 4);
+    auto const bit = [](std::vector<std::uint64_t> const & m, std::size_t i) { return bool((m[i / 64] >> (i % 64)) & 1); };
+    auto const lt = x < z, le = x <= z, gt = x > z, ge = x >= z, eq = x == z, ne = x != z;
+    ok &= lt.size() == 16 && lt.back() >> (1001 % 64) == 0 && ne.back() >> (1001 % 64) == 0;
+    for (std::size_t i = 0; i < z.size(); ++i)
+    {
+        ok &= bit(lt, i) == (x[i] < z[i]) && bit(le, i) == (x[i] <= z[i]) && bit(gt, i) == (x[i] > z[i]);
+        ok &= bit(ge, i) == (x[i] >= z[i]) && bit(eq, i) == (x[i] == z[i]) && bit(ne, i) == (x[i] != z[i]);
+    }
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+#include "homomorphic_computational_extensions/likelihood.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main()
+{
+    std::mt19937_64 g(1);
+    std::normal_distribution<double> d(1.0, 2.0);
+    std::vector<double> xs(1000003);
+    for (auto & x : xs)
+        x = d(g);
+
+    // the pdf of a normal distribution with mean 1 and standard deviation 2.
+    auto pdf = [](double x)
+    {
+        double const z = (x - 1.0) / 2.0;
+        return lg<double>::from_log(-0.5 * z * z - std::log(2.0 * std::sqrt(2.0 * M_PI)));
+    };
+
+    double serial = 0;
+    for (auto x : xs)
+        serial += pdf(x).k;
+
+    bool ok = true;
+    double first = 0;
+    for (std::size_t threads : { 1, 2, 3, 4, 7, 16 })
+    {
+        thread_pool pool(threads);
+        auto const l = likelihood(xs, pdf, pool);
+        std::cout << threads << " threads: log-likelihood " << l.k << "\n";
+
+        // bit-for-bit the same for any number of threads.
+        if (threads == 1)
+            first = l.k;
+        ok &= l.k == first;
+        ok &= std::abs(l.k - serial) <= 1e-9 * std::abs(serial);
+    }
+
+    thread_pool pool(4);
+    ok &= likelihood(std::vector<double>{}, pdf, pool).k == 0;
+
+    // a parallel_for nested in another on the same pool runs inline on
+    // the worker, here a likelihood per row, and rethrows as usual.
+    std::vector<double> rows(8);
+    pool.parallel_for(rows.size(), [&](std::size_t r)
+    {
+        std::vector<double> const ys(xs.begin() + r * 1000, xs.begin() + (r + 1) * 1000);
+        rows[r] = likelihood(ys, pdf, pool).k;
+    });
+    for (std::size_t r = 0; r < rows.size(); ++r)
+    {
+        double s = 0;
+        for (std::size_t i = r * 1000; i < (r + 1) * 1000; ++i)
+            s += pdf(xs[i]).k;
+        ok &= std::abs(rows[r] - s) <= 1e-12 * std::abs(s);
+    }
+
+    bool thrown = false;
+    try
+    {
+        pool.parallel_for(4, [&](std::size_t) { pool.parallel_for(3, [](std::size_t j) { if (j == 1) throw 1; }); });
+    }
+    catch (int)
+    {
+        thrown = true;
+    }
+    ok &= thrown;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include "homomorphic_computational_extensions/lns.hpp"
+#include "homomorphic_computational_extensions/log_exp_sum.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+// sb to within the truncation bound of the table and a few ulps of log(2).
+template <typename T, int P>
+bool check_sb(double bound)
+{
+    bool ok = true;
+    for (int i = 0; i <= 50000; ++i)
+    {
+        auto const d = T(i) / T(1000);
+        auto const e = std::log1p(std::exp(-(long double)d));
+        ok &= std::abs(gaussian_log<T,P>::sb(d) - e) <= bound + 4 * std::numeric_limits<T>::epsilon();
+    }
+    return ok && gaussian_log<T,P>::sb(T(0)) == T(std::log(2.0L));
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= check_sb<float,4>(5.0e-9) && check_sb<float,2>(2.0e-6);
+    ok &= check_sb<double,4>(2.4e-17) && check_sb<double,2>(1.6e-12);
+
+    // the nodes do not straddle cache lines.
+    ok &= (std::uintptr_t)lns_detail::table<double,4>.data() % 64 == 0 && (std::uintptr_t)lns_detail::table<float,2>.data() % 64 == 0;
+
+    // zeros and infinities.
+    auto const inf = std::numeric_limits<double>::infinity();
+    auto const zero = lg<double>::from_log(-inf);
+    auto const x = lg<double>(3.0);
+    ok &= lns_add(x, zero).k == x.k && lns_add(zero, x).k == x.k && lns_add(zero, zero).k == -inf;
+    ok &= lns_add(x, lg<double>::from_log(inf)).k == inf && lns_add(lg<double>::from_log(inf), lg<double>::from_log(inf)).k == inf;
+    ok &= std::abs(lns_add(x, x).k - std::log(6.0)) <= 4e-16 && std::abs(lns_add(lg<double>(1.0), lg<double>(2.0)).k - std::log(3.0)) <= 4e-16;
+
+    // pairs against log_exp_sum, a pack at a time and one at a time.
+    std::mt19937_64 g(17);
+    std::uniform_real_distribution<double> u(-60.0, 60.0);
+    std::vector<lg<double>> xs(10003), ys(xs.size()), zs(xs.size());
+    std::vector<lg<float>> fs(xs.size()), gs(xs.size()), hs(xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        xs[i] = lg<double>::from_log(u(g));
+        ys[i] = lg<double>::from_log(xs[i].k + u(g) / 2);
+        fs[i] = lg<float>::from_log(float(xs[i].k));
+        gs[i] = lg<float>::from_log(float(ys[i].k));
+    }
+    xs[5].k = -inf;
+    lns_add(xs, ys, zs);
+    lns_add(fs, gs, hs);
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        log_exp_sum<double> e;
+        e += xs[i];
+        e += ys[i];
+        auto const r = e.value().k;
+        ok &= std::abs(zs[i].k - r) <= 4e-16 * std::max(1.0, std::abs(r));
+        ok &= std::abs(zs[i].k - lns_add(xs[i], ys[i]).k) <= 4e-16 * std::max(1.0, std::abs(r));
+
+        log_exp_sum<float> f;
+        f += fs[i];
+        f += gs[i];
+        ok &= std::abs(hs[i].k - f.value().k) <= 3e-7f * std::max(1.0f, std::abs(f.value().k));
+    }
+
+    // a long sum, and the empty sum.
+    log_exp_sum<double> e;
+    e += std::span<lg<double> const>(xs);
+    ok &= std::abs(lns_sum(xs).k - e.value().k) <= 1e-13 * std::abs(e.value().k);
+    ok &= std::abs(lns_sum<2>(xs).k - e.value().k) <= 1e-10 * std::abs(e.value().k);
+    ok &= lns_sum(std::span<lg<double> const>()).k == -inf;
+    std::vector<lg<float>> ones(1000, lg<float>());
+    ok &= std::abs(lns_sum(ones).k - std::log(1000.0f)) <= 1e-4f;
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/log_exp_sum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+// the log of the sum of exp(k) for the exponents of xs, in long double.
+template <typename T, typename M>
+long double reference(std::span<lg<T,M> const> xs)
+{
+    auto m = -std::numeric_limits<long double>::infinity();
+    for (auto const & x : xs)
+        m = std::max(m, (long double)x.k);
+    if (std::isinf(m))
+        return m;
+    long double s = 0;
+    for (auto const & x : xs)
+        s += std::exp(x.k - m);
+    return m + std::log(s);
+}
+
+template <typename T, typename M>
+bool check(T tol)
+{
+    bool ok = true;
+    using L = lg<T,M>;
+    auto const inf = std::numeric_limits<T>::infinity();
+    auto const near = [tol](L const & x, long double r) { return std::abs(x.k - r) <= tol * std::max(1.0L, std::abs(r)); };
+
+    // the empty sum is 0, one value is itself.
+    ok &= log_exp_sum<T,M>().value().k == -inf && sum(std::span<L const>()).k == -inf;
+    log_exp_sum<T,M> one;
+    one += L::from_log(T(-3.5));
+    ok &= one.value().k == T(-3.5);
+
+    // exponents whose running maximum rises within and across blocks, so
+    // the sum is rescaled in both paths.
+    std::mt19937_64 g(5);
+    std::uniform_real_distribution<T> u(T(-30), T(0));
+    std::vector<L> xs(1003);
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        xs[i] = L::from_log(u(g) + T(i) / T(4));
+    auto const r = reference(std::span<L const>(xs));
+
+    log_exp_sum<T,M> a, b;
+    for (auto const & x : xs)
+        a += x;
+    b += std::span<L const>(xs);
+    ok &= near(a.value(), r) && near(b.value(), r) && near(sum(xs), r);
+
+    // the merge of two halves, in either order, is the sum of the whole.
+    log_exp_sum<T,M> lo, hi;
+    lo += std::span<L const>(xs.data(), 300);
+    hi += std::span<L const>(xs.data() + 300, xs.size() - 300);
+    ok &= near((lo + hi).value(), r) && near((hi + lo).value(), r);
+    auto c = lo;
+    c += log_exp_sum<T,M>();
+    ok &= c.value().k == lo.value().k && (log_exp_sum<T,M>() + lo).value().k == lo.value().k;
+
+    // a larger value in the middle of the first block.
+    std::vector<L> ys(100, L::from_log(T(-10)));
+    ys[37] = L::from_log(T(50));
+    ok &= near(sum(ys), reference(std::span<L const>(ys)));
+
+    // -inf terms are zeros, +inf terms make the sum +inf.
+    auto zs = xs;
+    for (std::size_t i = 0; i < zs.size(); i += 3)
+        zs[i] = L::from_log(-inf);
+    log_exp_sum<T,M> d;
+    for (auto const & z : zs)
+        d += z;
+    ok &= near(d.value(), reference(std::span<L const>(zs))) && near(sum(zs), reference(std::span<L const>(zs)));
+    std::vector<L> zeros(300, L::from_log(-inf));
+    ok &= sum(zeros).k == -inf;
+
+    zs[500] = L::from_log(inf);
+    log_exp_sum<T,M> e;
+    for (auto const & z : zs)
+        e += z;
+    ok &= e.value().k == inf && sum(zs).k == inf;
+    log_exp_sum<T,M> f;
+    f += L::from_log(inf);
+    ok &= (f + a).value().k == inf && (a + f).value().k == inf;
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= check<double, std_math>(1e-14) && check<double, fast_math>(1e-14);
+    ok &= check<float, std_math>(1e-5f) && check<float, fast_math>(1e-5f);
+
+    // the same values with either policy.
+    std::vector<lg<double>> xs(777);
+    std::vector<lg<double, fast_math>> ys(xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        xs[i] = lg<double>::from_log(std::sin(double(i)) * 100);
+        ys[i] = lg<double, fast_math>::from_log(xs[i].k);
+    }
+    ok &= std::abs(sum(xs).k - sum(ys).k) <= 1e-14 * std::abs(sum(xs).k);
+
+    std::cout << (ok ? "passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "homomorphic_computational_extensions/fast_math.hpp"
+#include "homomorphic_computational_extensions/log_gamma.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// the error of x against the reference y, in ulps of y.
+double ulps(double x, long double y)
+{
+    auto const u = std::nextafter(double(y), HUGE_VAL) - double(y);
+    return double(std::fabs(x - y) / u);
+}
+
+int main()
+{
+    bool ok = true;
+
+    // log(n!) against a sum of logs in long double, in and beyond the table.
+    long double s = 0;
+    for (std::uint64_t n = 1; n < 5000; ++n)
+    {
+        s += std::log((long double)n);
+        ok &= ulps(log_factorial(n).k, s) <= 3;
+    }
+    ok &= log_factorial(0).k == 0 && log_factorial(1).k == 0;
+    ok &= ulps(log_factorial(1000000000000ull).k, std::lgamma(1000000000001.0L)) <= 2;
+
+    // log(gamma(x)) against lgammal, including near its zeros at 1 and 2.
+    std::mt19937_64 g(17);
+    std::uniform_real_distribution<double> u(-3.0, 8.0);
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto const x = std::exp2(u(g));
+        auto const y = log_gamma(x).k;
+        auto const r = std::lgamma((long double)x);
+        ok &= ulps(y, r) <= 6;
+    }
+    ok &= log_gamma(1.0).k == 0 && log_gamma(2.0).k == 0 && ulps(log_gamma(1.0 + 0x1p-30).k, (-0.577215664901532860606L + 0.822467033424113218236L * 0x1p-30L) * 0x1p-30L) <= 5;
+    ok &= std::fabs(log_gamma(0.5).k - 0.5 * std::log(3.14159265358979323846)) < 1e-15;
+    ok &= std::fabs(gamma(lg<double>(5.0)).k - std::log(24.0)) < 1e-13;
+
+    // the batch forms agree with the scalar ones.
+    std::vector<std::uint64_t> ns{0, 1, 10, 255, 256, 257, 100000, 1ull << 40};
+    std::vector<lg<double>> fs(ns.size());
+    log_factorial(std::span<std::uint64_t const>(ns), std::span<lg<double>>(fs));
+    for (std::size_t i = 0; i < ns.size(); ++i)
+        ok &= fs[i].k == log_factorial(ns[i]).k;
+
+    std::vector<double> xs(1000);
+    for (auto & x : xs)
+        x = std::exp2(u(g));
+    std::vector<lg<double>> ys(xs.size());
+    log_gamma(std::span<double const>(xs), std::span<lg<double>>(ys));
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        ok &= ys[i].k == log_gamma(xs[i]).k;
+
+    std::vector<lg<double, fast_math>> zs(xs.size());
+    log_gamma(std::span<double const>(xs), std::span<lg<double, fast_math>>(zs));
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        ok &= std::fabs(zs[i].k - ys[i].k) <= 1e-13 * std::fabs(ys[i].k) + 1e-14;
+
+    // log(n choose k) for small k against a product in long double, where
+    // a difference of log-factorials of large n would cancel.
+    for (std::uint64_t n : {2ull, 17ull, 300ull, 1000000ull, 1ull << 50})
+    {
+        long double c = 0;
+        for (std::uint64_t k = 1; k <= 40 && k < n; ++k)
+        {
+            c += std::log((long double)(n - k + 1) / k);
+            ok &= ulps(log_binomial(n, k).k, c) <= 4;
+        }
+    }
+    ok &= log_binomial(10, 0).k == 0 && log_binomial(10, 10).k == 0;
+    ok &= std::fabs(log_binomial(10, 5).k - std::log(252.0)) < 1e-15;
+
+    // log(beta(a,b)) against lgammal, where its 64 bits suffice.
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto const a = std::exp2(u(g)), b = std::exp2(u(g));
+        auto const r = std::lgamma((long double)a) + std::lgamma((long double)b) - std::lgamma((long double)a + b);
+        ok &= std::fabs(log_beta(a, b).k - r) <= 1e-14 * (1 + std::fabs(r));
+    }
+
+    // log(beta(a,1)) = -log(a), even for large a.
+    for (double a : {20.0, 1e3, 1e8, 1e15})
+        ok &= ulps(log_beta(a, 1.0).k, -std::log((long double)a)) <= 4;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#include "homomorphic_computational_extensions/mapped_array.hpp"
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+int main()
+{
+    bool ok = true;
+    std::string const path = "mapped_array_test.bin";
+
+    std::vector<lg<double>> v;
+    for (int i = 1; i <= 100000; ++i)
+        v.push_back(lg<double>(1.0 / i));
+    write_array_file(path, v);
+
+    {
+        mapped_array<lg<double>> a(path);
+        ok &= a.size() == v.size() && (std::uintptr_t)a.data() % 64 == 0;
+        ok &= product(a.view()).k == product(v).k;
+
+        // chunks of 4096 values, with the last one shorter.
+        std::size_t n = 0, chunks = 0;
+        for (auto c : a.chunks(4096))
+        {
+            for (std::size_t i = 0; i < c.size(); ++i)
+                ok &= c[i] == v[n + i];
+            n += c.size();
+            ++chunks;
+        }
+        ok &= n == v.size() && chunks == 25;
+    }
+
+    // the header does not match the requested type.
+    auto const rejects = [&](auto tag)
+    {
+        try
+        {
+            mapped_array<decltype(tag)> a(path);
+            return false;
+        }
+        catch (std::runtime_error const &)
+        {
+            return true;
+        }
+    };
+    ok &= rejects(lg<float>()) && rejects(scaled<double,1,2>());
+
+    std::vector<scaled<double,1,1024>> s{ scaled<double,1,1024>(3.0) };
+    write_array_file(path, s);
+    ok &= (double)mapped_array<scaled<double,1,1024>>(path)[0] == 3.0 && rejects(scaled<double,1,2>());
+
+    std::remove(path.c_str());
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
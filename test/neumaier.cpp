@@ -0,0 +1,51 @@
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main()
+{
+    std::mt19937_64 g(1);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    std::size_t const n = 1000003;
+    std::vector<lg<double>> xs;
+    std::vector<lg<neumaier<double>>> ys;
+    long double exact = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto const p = u(g);
+        xs.push_back(lg<double>(p));
+        ys.push_back(lg<neumaier<double>>(p));
+        exact += (long double)xs.back().k;
+    }
+
+    neumaier<double> fold;
+    for (auto const & y : ys)
+        fold += y.k;
+
+    auto const plain = product(xs).k;
+    auto const comp = product(ys).k.value();
+    auto const err = [&](double k) { return (double)std::abs((long double)k - exact); };
+
+    std::cout << "exact:      " << (double)exact << "\n";
+    std::cout << "lg<double>:   error " << err(plain) << "\n";
+    std::cout << "lg<neumaier>: error " << err(comp) << "\n";
+    std::cout << "fold:         error " << err(fold.value()) << "\n";
+
+    // within an ulp or so of the exact sum, since the log of each value
+    // is already rounded to double.
+    bool ok = err(comp) <= 2 * std::abs((double)exact) * 0x1p-53;
+    ok &= err(fold.value()) <= 2 * std::abs((double)exact) * 0x1p-53;
+
+    // the ring operations required by lg.
+    auto const a = lg<neumaier<double>>(0.25), b = lg<neumaier<double>>(8.0);
+    ok &= std::abs((double)(neumaier<double>)(a * b) - 2.0) < 1e-15;
+    ok &= std::abs((double)(neumaier<double>)(b / a) - 32.0) < 1e-13;
+    ok &= a < b;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include "homomorphic_computational_extensions/lg_batch.hpp"
+#include "homomorphic_computational_extensions/safe_batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+int main()
+{
+    bool ok = true;
+
+    // exponents in [-100,100), some of which do not convert to float.
+    std::vector<lg<float>> xs;
+    for (int i = 0; i < 1000; ++i)
+        xs.push_back(lg<float>::from_log(float(i % 200) - 100.0f));
+
+    using B = safe_batch<lg<float>>;
+    B const b{ std::span<lg<float> const>(xs) };
+    auto const c = fmap([](auto x) { return x * x; }, b);
+
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        auto const k = xs[i].k;
+        auto const over = B::hi() < k, under = k < B::lo();
+        ok &= b.overflow(i) == over && b.underflow(i) == under;
+
+        // the square is 2k in the log-domain; invalid values keep their
+        // state and exponent.
+        ok &= c.overflow(i) == (over || (!under && B::hi() < 2 * k));
+        ok &= c.underflow(i) == (under || (!over && 2 * k < B::lo()));
+        if (c.valid(i))
+            ok &= std::abs(c.values()[i].k - 2 * k) <= 1e-5f * std::max(1.0f, std::abs(k));
+        if (b.invalid(i))
+            ok &= c.values()[i].k == k;
+    }
+    ok &= b.count_valid() == 880 && c.count_valid() == 440;
+    ok &= c[150].overflow() && c[10].underflow() && c[100].valid();
+
+    // f(x) <= 0 has no exponent, so it underflows rather than becoming a
+    // valid NaN, and values that were already invalid keep their state.
+    std::vector<lg<double>> hs(20, lg<double>(0.5));
+    hs[3] = lg<double>::from_log(1e6);
+    hs[17] = lg<double>(2.0);
+    safe_batch<lg<double>> const h{ std::span<lg<double> const>(hs) };
+    auto const g = fmap([](auto x) { return x - decltype(x)::broadcast(1.0); }, h);
+    ok &= g.count_valid() == 1 && g.valid(17) && g.values()[17].k == 0.0 && g.overflow(3);
+    for (std::size_t i = 0; i < hs.size(); ++i)
+        ok &= i == 3 || i == 17 || g.underflow(i);
+    auto const zero = fmap([](auto x) { return x - x; }, h);
+    ok &= zero.count_valid() == 0 && zero.underflow(0) && zero.overflow(3);
+
+    // a NaN exponent is out of range too.
+    std::vector<lg<float>> ns(70, lg<float>(1.0f));
+    ns[5].k = ns[66].k = std::numeric_limits<float>::quiet_NaN();
+    safe_batch<lg<float>> const nb{ std::span<lg<float> const>(ns) };
+    ok &= nb.count_valid() == 68 && nb.underflow(5) && nb.underflow(66) && nb.valid(4);
+
+    // conversion back to float, classified in the same pass, agrees with
+    // the batch and with the states of safe<lg<float>>.
+    std::vector<float> ys(xs.size()), zs(xs.size());
+    std::vector<std::uint64_t> over((xs.size() + 63) / 64), under(over.size());
+    auto const invalid = to_source(std::span<lg<float> const>(xs), std::span<float>(ys), std::span<std::uint64_t>(over),
+        std::span<std::uint64_t>(under));
+    to_source(xs, zs);
+    ok &= invalid == xs.size() - b.count_valid();
+    ok &= std::equal(over.begin(), over.end(), b.overflow_mask().begin()) &&
+        std::equal(under.begin(), under.end(), b.underflow_mask().begin());
+    for (std::size_t i = 0; i < xs.size(); ++i)
+    {
+        safe<lg<float>> const x(xs[i]);
+        ok &= x.overflow() == b.overflow(i) && x.underflow() == b.underflow(i);
+        ok &= ys[i] == std::exp(xs[i].k) && zs[i] == ys[i];
+    }
+    to_source(b, std::span<float>(zs));
+    ok &= std::equal(ys.begin(), ys.end(), zs.begin());
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
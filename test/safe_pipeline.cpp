@@ -0,0 +1,47 @@
+#include "homomorphic_computational_extensions/safe_pipeline.hpp"
+#include "homomorphic_computational_extensions/safe_batch.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+int main()
+{
+    bool ok = true;
+
+    auto const square = bounded([](auto x) { return x * x; }, { 2, 0, 0 });
+    auto const twice = bounded([](auto x) { return x + x; }, { 1, std::log(2.0), std::log(2.0) });
+    auto const p = pipe(square, twice, square);
+
+    // (3^2 * 2)^2 = 324.
+    auto const a = fmap(p, safe<lg<double>>(lg<double>(3.0)));
+    ok &= a.valid() && std::abs((double)a.value() - 324.0) < 1e-12;
+
+    // the same as the composition of the lifted stages.
+    auto const f = std::function<double(double)>([](double x) { return x * x; });
+    auto const g = std::function<double(double)>([](double x) { return x + x; });
+    auto const b = fmap(f, fmap(g, fmap(f, safe<lg<double>>(lg<double>(3.0)))));
+    ok &= b.valid() && b.value().k == a.value().k;
+
+    // the range analysis proves the first in range but not the second,
+    // whose result overflows.
+    ok &= p.in_range(1.0, -708.0, 709.0) && !p.in_range(200.0, -708.0, 709.0);
+    ok &= fmap(p, safe<lg<double>>(lg<double>::from_log(200.0))).overflow();
+
+    // stages without bounds, which are checked after the last stage.
+    auto const c = fmap(pipe([](double x) { return x * 1e300; }, [](double x) { return x * 1e300; }),
+        safe<lg<double>>(lg<double>(3.0)));
+    ok &= c.overflow();
+    ok &= fmap([](double x) { return x + 1; }, safe<lg<double>>(lg<double>(3.0))).valid();
+
+    // invalid values propagate.
+    ok &= fmap(p, safe<lg<double>>(safe<lg<double>>::State::underflow)).underflow();
+
+    // a pipeline is also a function on packs.
+    std::vector<lg<double>> xs{ lg<double>(2.0), lg<double>(3.0) };
+    auto const r = fmap(p, safe_batch<lg<double>>{ std::span<lg<double> const>(xs) });
+    ok &= std::abs((double)r.values()[0] - 64.0) < 1e-12 && std::abs((double)r.values()[1] - 324.0) < 1e-12;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#include "homomorphic_computational_extensions/scaled.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+int main()
+{
+    bool ok = true;
+
+    static_assert(scaled<double,1,1024>::exact && scaled<double,6,3>::exact && scaled<float,1,1>::exact);
+    static_assert(!scaled<double,3,1>::exact && !scaled<double,1,10>::exact);
+    static_assert(scaled_detail::exponent<1,1024> == -10 && scaled_detail::exponent<6,3> == 1);
+
+    // with a power of two scale, the conversions are exact and every
+    // operation rounds once, so the results are those of double.
+    using S = scaled<double,1,1024>;
+    std::mt19937_64 g(7);
+    std::uniform_real_distribution<double> u(-1e6, 1e6);
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto const a = u(g), b = u(g);
+        ok &= (double)S(a) == a && S(a).k == std::ldexp(a, -10);
+        ok &= (double)(S(a) * S(b)) == a * b && (double)(S(a) / S(b)) == a / b;
+        ok &= (double)(S(a) + S(b)) == a + b && (double)inv(S(a)) == 1 / a;
+    }
+
+    // log(D/N) is folded into a constant.
+    ok &= std::abs((double)log(S(3.0)) - std::log(3.0)) < 1e-15;
+    ok &= std::abs((double)exp(S(0.5)) - std::exp(0.5)) < 1e-15;
+
+    // values beyond the range of double.
+    using B = scaled<double,1,1024>;
+    auto const big = B::from_scaled(1e307);
+    ok &= overflow_to(big) && !overflow_to(B(1e308));
+
+    // other scales still work, with an extra rounding.
+    using R = scaled<double,3,1>;
+    ok &= std::abs((double)(R(2.0) * R(5.0)) - 10.0) < 1e-14 && std::abs((double)log(R(3.0)) - std::log(3.0)) < 1e-15;
+
+    // fixed-point Q8 arithmetic on integers.
+    using Q = scaled<std::int32_t,256,1>;
+    ok &= Q(3).k == 768 && (std::int32_t)(Q(3) * Q(-5)) == -15 && (Q::from_scaled(128) * Q(6)).k == 768;
+    ok &= (Q(12) / Q(4)).k == 768 && (Q(3) / Q(2)).k == 384 && (Q(1) / Q(2)).k == 128 && (Q(-1) / Q(3)).k == -85;
+    ok &= inv(Q(2)).k == 128 && inv(Q(-4)).k == -64 && inv(Q::from_scaled(3)).k == 21845;
+    ok &= (Q(200) * Q(200)).k == 40000 * 256 && (Q::from_scaled(-3) * Q::from_scaled(128)).k == -1;
+    ok &= (Q::from_scaled(3) * Q::from_scaled(128)).k == 1 && (Q::from_scaled(-1) * Q::from_scaled(255)).k == 0;
+
+    // Q-8 values, i.e., scaled by 1/256, divide the scaled denominator.
+    using P = scaled<std::int64_t,1,256>;
+    ok &= P(256 * 7).k == 7 && (P(256 * 6) / P(256 * 4)).k == 0 && (P(1 << 20) / P(256)).k == 16;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
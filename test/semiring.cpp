@@ -0,0 +1,61 @@
+#include "homomorphic_computational_extensions/semiring.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+static_assert(semiring<lg_sum<double>> && semiring<lg_lns<float>> && semiring<lg_max<float>> && semiring<min_plus<double>>);
+
+int main()
+{
+    using L = lg<double>;
+    bool ok = true;
+
+    // a hidden Markov model with 2 states and 3 observations.
+    double const pi[2] = { 0.6, 0.4 };
+    double const a[2][2] = { { 0.7, 0.3 }, { 0.4, 0.6 } };
+    double const b[3][2] = { { 0.5, 0.1 }, { 0.4, 0.3 }, { 0.1, 0.6 } };
+
+    std::vector<L> init, trans, emit, alpha(6);
+    for (int i = 0; i < 2; ++i)
+    {
+        init.push_back(L(pi[i]));
+        for (int j = 0; j < 2; ++j)
+            trans.push_back(L(a[i][j]));
+    }
+    for (int t = 0; t < 3; ++t)
+        for (int j = 0; j < 2; ++j)
+            emit.push_back(L(b[t][j]));
+
+    // the likelihood and the probability of the most likely path by
+    // enumerating the paths.
+    double sum = 0, max = 0;
+    for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < 2; ++j)
+            for (int k = 0; k < 2; ++k)
+            {
+                auto const p = pi[i] * b[0][i] * a[i][j] * b[1][j] * a[j][k] * b[2][k];
+                sum += p;
+                max = std::max(max, p);
+            }
+
+    auto const f = forward<lg_sum<double>>(std::span<L const>(init), std::span<L const>(trans),
+        std::span<L const>(emit), std::span<L>(alpha), 2, 3);
+    auto const v = forward<lg_max<double>>(std::span<L const>(init), std::span<L const>(trans),
+        std::span<L const>(emit), std::span<L>(alpha), 2, 3);
+    auto const g = forward<lg_lns<double>>(std::span<L const>(init), std::span<L const>(trans),
+        std::span<L const>(emit), std::span<L>(alpha), 2, 3);
+    ok &= std::abs((double)f - sum) < 1e-15 && std::abs((double)v - max) < 1e-15 && std::abs((double)g - sum) < 1e-15;
+
+    std::vector<double> x{ 3, 1, 2 }, y(3);
+    scan<min_plus<double>>(std::span<double const>(x), std::span<double>(y));
+    ok &= y == std::vector<double>{ 3, 1, 1 };
+
+    std::vector<L> xs{ L(1.0), L(2.0), L(3.0) }, ys(3);
+    scan<lg_sum<double>>(std::span<L const>(xs), std::span<L>(ys));
+    ok &= std::abs((double)ys[2] - 6.0) < 1e-14;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include "homomorphic_computational_extensions/signed_lg.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main()
+{
+    using S = signed_lg<double>;
+    bool ok = true;
+
+    S const a(3.0), b(-5.0), zero(0.0);
+    ok &= std::abs((double)(a + b) + 2.0) < 1e-14 && std::abs((double)(a - b) - 8.0) < 1e-14;
+    ok &= std::abs((double)(a * b) + 15.0) < 1e-14 && std::abs((double)inv(b) + 0.2) < 1e-16;
+    ok &= (double)(a - a) == 0.0 && a + zero == a && zero == -zero;
+    ok &= b < zero && zero < a && b < a && !(a < b);
+    ok &= a < lg<double>(4.0) && lg<double>(2.0) < a;
+
+    std::mt19937_64 g(1);
+    std::normal_distribution<double> d;
+    std::size_t const n = 10007;
+    std::vector<double> xv(n), yv(n);
+    std::vector<S> x(n), y(n), z(n);
+    double ref = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        xv[i] = d(g);
+        yv[i] = d(g);
+        x[i] = S(xv[i]);
+        y[i] = S(yv[i]);
+        ref += xv[i] * yv[i];
+    }
+
+    ok &= std::abs((double)dot(x, y) - ref) < 1e-12 * n;
+
+    // the relative error of a sum is bounded by the condition number of
+    // the sum times the error of the log of each operand.
+    add(std::span<S const>(x), std::span<S const>(y), std::span<S>(z));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto const cond = (std::abs(xv[i]) + std::abs(yv[i])) / std::abs(xv[i] + yv[i]);
+        ok &= std::abs((double)z[i] - (xv[i] + yv[i])) <= 8e-16 * cond * std::abs(xv[i] + yv[i]);
+        ok &= z[i] == x[i] + y[i];
+    }
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "homomorphic_computational_extensions/xfloat.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+int main()
+{
+    using X = xfloat<double>;
+    bool ok = true;
+    auto const inf = std::numeric_limits<double>::infinity();
+    auto const nan = std::numeric_limits<double>::quiet_NaN();
+
+    X const a(0.5), b(3.0);
+    ok &= (double)(a * b) == 1.5 && (double)(a + b) == 3.5 && (double)(a - b) == -2.5 && (double)(b / a) == 6.0;
+    ok &= a < b && !(b < a) && a == a && a != b;
+
+    // negative values.
+    X const c(-3.0), d(-0.25);
+    ok &= (double)(c * b) == -9.0 && (double)(c * d) == 0.75 && (double)(c / d) == 12.0 && (double)(c + b) == 0.0;
+    ok &= c < d && d < a && c < a && -c == b && !(c > d) && c <= c && (double)abs(c) == 3.0 && (double)(-X(2.0)) == -2.0;
+
+    // zero.
+    X const z, zz(0.0);
+    ok &= z == zz && (double)z == 0.0 && z * b == z && z + b == b && b + z == b && b - b == z && (double)(z / b) == 0.0;
+    ok &= z < a && c < z && z <= z && z >= z && -z == z;
+
+    // infinities and NaN behave as in double.
+    X const pi(inf), ni(-inf), n(nan);
+    ok &= pi == pi && ni == ni && pi != ni && ni < c && c < pi && X(1.0, 1 << 30) < pi && ni < X(-1.0, 1 << 30);
+    ok &= (double)pi == inf && (double)(pi * b) == inf && (double)(pi * c) == -inf && std::isnan((double)(pi - pi));
+    ok &= std::isnan((double)n) && !(n == n) && n != n && !(n < a) && !(a < n) && !(n <= a) && !(n >= a) && std::isnan((double)(n + a));
+
+    // values whose exponents differ by more than limit (about 2100 for
+    // double), whose difference is the larger one.
+    X const huge(0.75, 100000), tiny(0.75, -100000), neg(-0.5, 5000);
+    ok &= tiny < huge && huge > tiny && tiny != huge && neg < tiny && tiny < X(1e-300) && X(-1e-300) < tiny;
+    ok &= huge + tiny == huge && huge - tiny == huge && tiny - huge == -huge && tiny - huge < neg;
+    ok &= X(0.75, 2500) > X(0.75, -2500) && X(-0.75, 2500) < X(-0.75, -2500) && X(-0.75, -2500) < X(0.75, -3000);
+
+    // the same value with different mantissas.
+    ok &= X(1.0, 10) == X(0.5, 11) && X(2.0, 9) == X(1024.0) && X(0x1p100, -100) == X(1.0);
+
+    // the mantissa is renormalized only when it leaves [2^-500, 2^500].
+    X x(0.5);
+    x *= X(0x1p501, 0);
+    ok &= x.m == 0x1p500 && x.e == 0;
+    x *= X(2.0, 0);
+    ok &= x.m == 0.5 && x.e == 502;
+    X y(0.5);
+    y /= X(0x1p499, 0);
+    ok &= y.m == 0x1p-500 && y.e == 0;
+    y *= X(0.5, 0);
+    ok &= y.m == 0.5 && y.e == -500 && (double)y == 0x1p-501;
+    X w(-0.5);
+    w *= X(-0x1p502, 0);
+    ok &= w.m == 0.5 && w.e == 502;
+    auto const v = X(0x1p500, 0) * X(0x1p500, 0);
+    ok &= v.m == 0.5 && v.e == 1001 && (double)v == 0x1p1000 && (double)(v * v) == inf && v * v > X(1e308);
+
+    // 10^-15000 is far outside the range of double.
+    X p(1.0);
+    for (int i = 0; i < 5000; ++i)
+        p *= X(1e-3);
+    ok &= p > X(0.0) && (p + X(1.0)) == X(1.0);
+
+    // to and from lg<double>.
+    auto const l = (lg<double>)p;
+    ok &= std::abs(l.k - 5000 * std::log(1e-3)) <= 1e-12 * std::abs(l.k);
+    ok &= std::abs((double)((X(l) - p) / p)) < 1e-10;
+    ok &= (double)X(lg<double>(0.75)) == 0.75 && X(lg<double>::from_log(-1e300)) == X(0.0);
+    ok &= X(lg<double>::from_log(-inf)) == z && X(lg<double>::from_log(inf)) == pi && ((lg<double>)z).k == -inf;
+
+    // large exponents k map to 2^e exp(r) with r accurate to well below
+    // an ulp of k, e.g., 1.2e-10 for k near 1e6.
+    std::mt19937_64 g(19);
+    std::uniform_real_distribution<double> u(1e5, 1e6);
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto const k = i % 2 ? u(g) : -u(g);
+        auto const q = X(lg<double>::from_log(k));
+        auto const r = std::log((long double)q.m) + q.e * 0.6931471805599453094172321214581766L;
+        ok &= std::abs(r - k) <= 1e-13L && ((lg<double>)q).k == k;
+    }
+
+    // to and from scaled<double,N,D>.
+    using S = scaled<double,1,1024>;
+    ok &= (double)X(S(3.0)) == 3.0 && (double)(S)(X(S(3.0)) * X(2.0)) == 6.0;
+
+    std::cout << (ok ? "passed" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}